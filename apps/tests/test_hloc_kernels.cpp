@@ -0,0 +1,132 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* Bandwidth of the CPU kernels of the local Hamiltonian compared to the STREAM triad. The amount of transferred
+ * memory is counted in the STREAM convention: each array element is read or written once. */
+
+template <typename F>
+double measure(int repeat__, F&& f__)
+{
+    /* warm up */
+    f__();
+    double t = -omp_get_wtime();
+    for (int i = 0; i < repeat__; i++) {
+        f__();
+    }
+    t += omp_get_wtime();
+    return t / repeat__;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--n=", "{int} number of elements");
+    args.register_key("--repeat=", "{int} number of repeats");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    int n      = args.value<int>("n", 1 << 22);
+    int repeat = args.value<int>("repeat", 20);
+
+    sirius::initialize(1);
+
+    std::vector<double> a(n), b(n), c(n, 0.5), v(n), by(n), ekin(n);
+    std::vector<double_complex> z(n), phi(n), vphi(n), hphi(n), zref(n);
+    std::vector<double> re(n), im(n);
+    for (int i = 0; i < n; i++) {
+        b[i]    = 1.0 + 1e-8 * i;
+        v[i]    = 1.0 + 1e-9 * i;
+        by[i]   = 1e-9 * i;
+        ekin[i] = 0.5 * i / n;
+        z[i]    = type_wrapper<double_complex>::random();
+        phi[i]  = type_wrapper<double_complex>::random();
+        vphi[i] = type_wrapper<double_complex>::random();
+        re[i]   = z[i].real();
+        im[i]   = z[i].imag();
+    }
+
+    /* check the kernels against the reference loops */
+    double diff{0};
+    zref = z;
+    local_operator_kernels::mul_by_veff(n, v.data(), z.data());
+    for (int i = 0; i < n; i++) {
+        diff += std::abs(z[i] - zref[i] * v[i]);
+    }
+    zref = z;
+    local_operator_kernels::mul_by_bxy(n, v.data(), by.data(), -1, z.data());
+    for (int i = 0; i < n; i++) {
+        diff += std::abs(z[i] - zref[i] * double_complex(v[i], -by[i]));
+    }
+    std::vector<double_complex> zd(phi), zdref(phi);
+    zref = z;
+    local_operator_kernels::mul_by_veff_spinor(n, v.data(), b.data(), c.data(), by.data(), z.data(), zd.data());
+    for (int i = 0; i < n; i++) {
+        diff += std::abs(z[i] - (zref[i] * v[i] + zdref[i] * double_complex(c[i], -by[i])));
+        diff += std::abs(zd[i] - (zdref[i] * b[i] + zref[i] * double_complex(c[i], by[i])));
+    }
+    zref = hphi;
+    local_operator_kernels::add_pw_ekin(n, 1.0, ekin.data(), phi.data(), vphi.data(), hphi.data());
+    for (int i = 0; i < n; i++) {
+        diff += std::abs(hphi[i] - (zref[i] + phi[i] * ekin[i] + vphi[i]));
+    }
+    printf("difference with reference: %18.12e\n", diff);
+
+    double gb = double(n) / (1 << 30);
+
+    double t = measure(repeat, [&]() {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            a[i] = b[i] + 3.0 * c[i];
+        }
+    });
+    double triad = 3 * sizeof(double) * gb / t;
+    printf("STREAM triad              : %10.4f GB/s\n", triad);
+
+    auto report = [&](std::string name, double bytes, double t) {
+        double bw = bytes * gb / t;
+        printf("%-26s: %10.4f GB/s (%6.2f%% of triad)\n", name.c_str(), bw, 100 * bw / triad);
+    };
+
+    t = measure(repeat, [&]() {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            z[i] *= v[i];
+        }
+    });
+    report("mul_by_veff (loop)", 40, t);
+
+    t = measure(repeat, [&]() { local_operator_kernels::mul_by_veff(n, v.data(), z.data()); });
+    report("mul_by_veff", 40, t);
+
+    t = measure(repeat, [&]() { local_operator_kernels::mul_by_veff(n, v.data(), re.data(), im.data()); });
+    report("mul_by_veff (split)", 40, t);
+
+    t = measure(repeat, [&]() { local_operator_kernels::mul_by_bxy(n, v.data(), by.data(), 1, z.data()); });
+    report("mul_by_bxy", 48, t);
+
+    t = measure(repeat, [&]() {
+        local_operator_kernels::mul_by_veff_spinor(n, v.data(), b.data(), c.data(), by.data(), z.data(), zd.data());
+    });
+    report("mul_by_veff_spinor", 96, t);
+
+    t = measure(repeat, [&]() {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            hphi[i] += phi[i] * ekin[i] + vphi[i];
+        }
+    });
+    report("add_pw_ekin (loop)", 72, t);
+
+    t = measure(repeat, [&]() {
+        local_operator_kernels::add_pw_ekin(n, 1.0, ekin.data(), phi.data(), vphi.data(), hphi.data());
+    });
+    report("add_pw_ekin", 72, t);
+
+    sirius::finalize();
+}
@@ -0,0 +1,87 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* Products of the atomic blocks of the non-local operator with a panel of <beta|phi>: specialized kernels
+ * compared to BLAS. */
+
+template <typename T>
+double run(int nbf__, int na__, int n__, int repeat__)
+{
+    int nbeta = nbf__ * na__;
+    matrix<T> op(nbf__ * nbf__, na__);
+    matrix<T> beta_phi(nbeta, n__);
+    matrix<T> c1(nbeta, n__);
+    matrix<T> c2(nbeta, n__);
+    for (size_t i = 0; i < op.size(); i++) {
+        op[i] = type_wrapper<T>::random();
+    }
+    for (size_t i = 0; i < beta_phi.size(); i++) {
+        beta_phi[i] = type_wrapper<T>::random();
+    }
+
+    double t1 = -omp_get_wtime();
+    for (int r = 0; r < repeat__; r++) {
+        #pragma omp parallel for schedule(static)
+        for (int ia = 0; ia < na__; ia++) {
+            linalg<CPU>::gemm(0, 0, nbf__, n__, nbf__, op.template at<CPU>(0, ia), nbf__,
+                              beta_phi.template at<CPU>(ia * nbf__, 0), nbeta, c1.template at<CPU>(ia * nbf__, 0),
+                              nbeta);
+        }
+    }
+    t1 += omp_get_wtime();
+
+    double t2 = -omp_get_wtime();
+    for (int r = 0; r < repeat__; r++) {
+        #pragma omp parallel for schedule(static)
+        for (int ia = 0; ia < na__; ia++) {
+            non_local_operator_kernels::apply_atom_block(nbf__, n__, op.template at<CPU>(0, ia),
+                                                         beta_phi.template at<CPU>(ia * nbf__, 0), nbeta,
+                                                         c2.template at<CPU>(ia * nbf__, 0), nbeta);
+        }
+    }
+    t2 += omp_get_wtime();
+
+    double diff{0};
+    for (size_t i = 0; i < c1.size(); i++) {
+        diff += std::abs(c1[i] - c2[i]);
+    }
+    printf("nbf: %2i  BLAS: %10.6f sec.  kernel: %10.6f sec.  speedup: %6.2f  difference: %18.12e\n",
+           nbf__, t1, t2, t1 / t2, diff);
+    return diff;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--na=", "{int} number of atoms");
+    args.register_key("--n=", "{int} number of bands");
+    args.register_key("--repeat=", "{int} number of repeats");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    int na     = args.value<int>("na", 256);
+    int n      = args.value<int>("n", 64);
+    int repeat = args.value<int>("repeat", 10);
+
+    sirius::initialize(1);
+
+    double diff{0};
+    printf("real\n");
+    for (int nbf: {4, 8, 13, 18, 26, 7}) {
+        diff += run<double>(nbf, na, n, repeat);
+    }
+    printf("complex\n");
+    for (int nbf: {4, 8, 13, 18, 26, 7}) {
+        diff += run<double_complex>(nbf, na, n, repeat);
+    }
+
+    sirius::finalize();
+
+    return (diff < 1e-8) ? 0 : 1;
+}
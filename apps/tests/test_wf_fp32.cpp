@@ -0,0 +1,135 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+template <typename T>
+double max_diff(dmatrix<T>& a__, dmatrix<T>& b__, int n__)
+{
+    double diff{0};
+    for (int j = 0; j < n__; j++) {
+        for (int i = 0; i < n__; i++) {
+            diff = std::max(diff, std::abs(a__(i, j) - b__(i, j)));
+        }
+    }
+    return diff;
+}
+
+template <typename T>
+int test_wf_fp32(Gvec const& gvec__, int num_bands__)
+{
+    Gvec_partition gvecp(gvec__, Communicator::world(), Communicator::self());
+
+    int ngk = gvecp.gvec().count();
+
+    Wave_functions phi(gvecp, num_bands__);
+    for (int i = 0; i < num_bands__; i++) {
+        for (int j = 0; j < ngk; j++) {
+            phi.pw_coeffs(0).prime(j, i) = type_wrapper<double_complex>::random();
+        }
+        if (gvec__.reduced() && gvec__.comm().rank() == 0) {
+            phi.pw_coeffs(0).prime(0, i) = phi.pw_coeffs(0).prime(0, i).real();
+        }
+    }
+
+    /* single precision copy of the wave-functions */
+    mdarray<std::complex<float>, 1> buf(3 * ngk * num_bands__);
+    Wave_functions phi32(buf.at<CPU>(0), gvecp, num_bands__);
+    Wave_functions tmp32(buf.at<CPU>(ngk * num_bands__), gvecp, num_bands__);
+    Wave_functions out32(buf.at<CPU>(2 * ngk * num_bands__), gvecp, num_bands__);
+    phi32.copy_from(CPU, num_bands__, phi, 0, 0, 0, 0);
+    /* work with the rounded values in both precisions */
+    phi.copy_from(CPU, num_bands__, phi32, 0, 0, 0, 0);
+
+    dmatrix<T> ref(num_bands__, num_bands__);
+    dmatrix<T> mtrx(num_bands__, num_bands__);
+
+    int err{0};
+
+    /* overlap with fp64 storage */
+    inner(CPU, 0, phi, 0, num_bands__, phi, 0, num_bands__, ref, 0, 0);
+
+    /* mixed and single precision storage */
+    inner(CPU, 0, phi32, 0, num_bands__, phi, 0, num_bands__, mtrx, 0, 0);
+    double d1 = max_diff(ref, mtrx, num_bands__);
+    inner(CPU, 0, phi32, 0, num_bands__, phi32, 0, num_bands__, mtrx, 0, 0);
+    double d2 = max_diff(ref, mtrx, num_bands__);
+    mtrx.zero();
+    inner_herm(CPU, 0, phi32, 0, phi32, 0, num_bands__, mtrx, 0, 0);
+    double d3{0};
+    for (int j = 0; j < num_bands__; j++) {
+        for (int i = 0; i <= j; i++) {
+            d3 = std::max(d3, std::abs(ref(i, j) - mtrx(i, j)));
+        }
+    }
+
+    /* transformation with a random matrix */
+    for (int j = 0; j < num_bands__; j++) {
+        for (int i = 0; i < num_bands__; i++) {
+            mtrx(i, j) = type_wrapper<T>::random();
+        }
+    }
+    Wave_functions out(gvecp, num_bands__);
+    transform<T>(CPU, 0, {&phi}, 0, num_bands__, mtrx, 0, 0, {&out}, 0, num_bands__);
+    transform<T>(CPU, 0, {&phi32}, 0, num_bands__, mtrx, 0, 0, {&out32}, 0, num_bands__);
+    double d4{0};
+    for (int i = 0; i < num_bands__; i++) {
+        for (int j = 0; j < ngk; j++) {
+            d4 = std::max(d4, std::abs(out.pw_coeffs(0).prime(j, i) -
+                                       static_cast<double_complex>(out32.pw_coeffs_fp32(0).prime(j, i))));
+        }
+    }
+    /* relative to the norm of the transformed wave-functions */
+    d4 /= std::sqrt(static_cast<double>(num_bands__));
+
+    /* orthonormalization of the single precision wave-functions */
+    Wave_functions tmp(gvecp, num_bands__);
+    orthogonalize<T, 0, 0>(CPU, 0, {&phi32}, 0, num_bands__, mtrx, tmp);
+    inner(CPU, 0, phi32, 0, num_bands__, phi32, 0, num_bands__, mtrx, 0, 0);
+    double d5{0};
+    for (int j = 0; j < num_bands__; j++) {
+        for (int i = 0; i < num_bands__; i++) {
+            d5 = std::max(d5, std::abs(mtrx(i, j) - static_cast<double>(i == j)));
+        }
+    }
+
+    if (Communicator::world().rank() == 0) {
+        printf("inner (mixed): %12.6e, inner (fp32): %12.6e, inner_herm (fp32): %12.6e, transform: %12.6e, "
+               "orthogonality: %12.6e\n", d1, d2, d3, d4, d5);
+    }
+    /* the products are accumulated in double precision over blocks of single precision GEMMs */
+    double tol = 1e-4 * ngk;
+    if (d1 > tol || d2 > tol || d3 > tol || d4 > 1e-4 || d5 > 1e-4) {
+        err = 1;
+    }
+    return err;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--cutoff=", "{double} wave-functions cutoff");
+    args.register_key("--num_bands=", "{int} number of bands");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto cutoff = args.value<double>("cutoff", 4.0);
+    auto num_bands = args.value<int>("num_bands", 50);
+
+    sirius::initialize(1);
+
+    matrix3d<double> M = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    int err{0};
+    Gvec gvec(M, cutoff, Communicator::world(), false);
+    err += test_wf_fp32<double_complex>(gvec, num_bands);
+    Gvec gvec_r(M, cutoff, Communicator::world(), true);
+    err += test_wf_fp32<double>(gvec_r, num_bands);
+
+    sirius::finalize();
+
+    return err ? 1 : 0;
+}
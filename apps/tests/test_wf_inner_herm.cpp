@@ -0,0 +1,73 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+template <typename T>
+double test_wf_inner_herm(Gvec const& gvec__, int num_bands__, int N__)
+{
+    Gvec_partition gvecp(gvec__, Communicator::world(), Communicator::self());
+
+    Wave_functions phi(gvecp, N__ + num_bands__);
+    Wave_functions ophi(gvecp, N__ + num_bands__);
+    for (int i = 0; i < N__ + num_bands__; i++) {
+        for (int j = 0; j < phi.pw_coeffs(0).num_rows_loc(); j++) {
+            phi.pw_coeffs(0).prime(j, i) = type_wrapper<double_complex>::random();
+            /* a Hermitian (diagonal in G) operator */
+            ophi.pw_coeffs(0).prime(j, i) = phi.pw_coeffs(0).prime(j, i) * (1.0 + j % 7);
+        }
+    }
+
+    dmatrix<T> full(N__ + num_bands__, N__ + num_bands__);
+    dmatrix<T> herm(N__ + num_bands__, N__ + num_bands__);
+    full.zero();
+    herm.zero();
+
+    inner(CPU, 0, phi, N__, num_bands__, ophi, N__, num_bands__, full, N__, N__);
+    inner_herm(CPU, 0, phi, N__, ophi, N__, num_bands__, herm, N__, N__);
+
+    double diff{0};
+    for (int j = 0; j < N__ + num_bands__; j++) {
+        for (int i = 0; i < N__ + num_bands__; i++) {
+            diff = std::max(diff, std::abs(full(i, j) - herm(i, j)));
+        }
+    }
+    return diff;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--cutoff=", "{double} wave-functions cutoff");
+    args.register_key("--num_bands=", "{int} number of bands");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto cutoff = args.value<double>("cutoff", 4.0);
+    auto num_bands = args.value<int>("num_bands", 150);
+
+    sirius::initialize(1);
+
+    matrix3d<double> M = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    int err{0};
+    for (int N: {0, 17}) {
+        Gvec gvec(M, cutoff, Communicator::world(), false);
+        double diff = test_wf_inner_herm<double_complex>(gvec, num_bands, N);
+        Gvec gvec_r(M, cutoff, Communicator::world(), true);
+        double diff_r = test_wf_inner_herm<double>(gvec_r, num_bands, N);
+        if (Communicator::world().rank() == 0) {
+            printf("N: %i, difference (complex): %18.12e, difference (real): %18.12e\n", N, diff, diff_r);
+        }
+        if (diff > 1e-10 || diff_r > 1e-10) {
+            err = 1;
+        }
+    }
+
+    sirius::finalize();
+
+    return err;
+}
@@ -0,0 +1,149 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* check blocking and non-blocking remapping of wave-functions against the reference layout of the extra storage
+   and check the backward remapping */
+int test_wf_remap(std::vector<int> mpi_grid_dims__, double cutoff__, int num_bands__)
+{
+    MPI_grid mpi_grid(mpi_grid_dims__, Communicator::world());
+
+    matrix3d<double> M = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    Communicator comm_ortho_fft = Communicator::world().split(mpi_grid.communicator(1 << 0).rank());
+
+    Gvec gvec(M, cutoff__, Communicator::world(), false);
+
+    Gvec_partition gvecp(gvec, mpi_grid.communicator(1 << 0), comm_ortho_fft);
+
+    if (Communicator::world().rank() == 0) {
+        printf("size of comm_ortho_fft: %i\n", comm_ortho_fft.size());
+        if (comm_ortho_fft.size() == 1) {
+            printf("warning: wave-functions are not remapped\n");
+        }
+    }
+
+    /* coefficient of the wave-function i for the global G-vector index ig */
+    auto coeff = [](int ig, int i)
+    {
+        return double_complex(ig, i);
+    };
+
+    Wave_functions phi(gvecp, 2 * num_bands__);
+    Wave_functions psi(gvecp, 2 * num_bands__);
+    for (int i = 0; i < 2 * num_bands__; i++) {
+        for (int j = 0; j < phi.pw_coeffs(0).num_rows_loc(); j++) {
+            phi.pw_coeffs(0).prime(j, i) = coeff(gvec.offset() + j, i);
+        }
+    }
+
+    /* reference layout: the rows of the extra storage are the G-vectors of the ranks of comm_ortho_fft
+       stacked in the order of ranks, the columns are split in blocks between the ranks of comm_ortho_fft */
+    std::vector<int> gvec_offs(comm_ortho_fft.size());
+    std::vector<int> gvec_counts(comm_ortho_fft.size());
+    gvec_offs[comm_ortho_fft.rank()]   = gvec.offset();
+    gvec_counts[comm_ortho_fft.rank()] = gvec.count();
+    comm_ortho_fft.allgather(gvec_offs.data(), comm_ortho_fft.rank(), 1);
+    comm_ortho_fft.allgather(gvec_counts.data(), comm_ortho_fft.rank(), 1);
+    std::vector<int> row_gvec;
+    for (int r = 0; r < comm_ortho_fft.size(); r++) {
+        for (int ig = 0; ig < gvec_counts[r]; ig++) {
+            row_gvec.push_back(gvec_offs[r] + ig);
+        }
+    }
+    splindex<block> spl_col(num_bands__, comm_ortho_fft.size(), comm_ortho_fft.rank());
+
+    int err{0};
+    for (int idx0: {0, num_bands__ / 2}) {
+        auto check_extra = [&](mdarray<double_complex, 2> const& extra__, int i__)
+        {
+            for (int j = 0; j < static_cast<int>(row_gvec.size()); j++) {
+                if (extra__(j, i__) != coeff(row_gvec[j], idx0 + spl_col[i__])) {
+                    err = 1;
+                }
+            }
+        };
+
+        phi.pw_coeffs(0).remap_forward(CPU, num_bands__, idx0);
+        auto& phi_extra = phi.pw_coeffs(0).extra();
+        if (phi.pw_coeffs(0).spl_num_col().local_size() != spl_col.local_size() ||
+            static_cast<int>(phi_extra.size(0)) != static_cast<int>(row_gvec.size())) {
+            err = 1;
+        } else {
+            for (int i = 0; i < spl_col.local_size(); i++) {
+                check_extra(phi_extra, i);
+            }
+        }
+
+        for (int i = 0; i < 2 * num_bands__; i++) {
+            for (int j = 0; j < phi.pw_coeffs(0).num_rows_loc(); j++) {
+                psi.pw_coeffs(0).prime(j, i) = phi.pw_coeffs(0).prime(j, i);
+            }
+        }
+        /* non-blocking remapping; columns are checked in order as they arrive */
+        psi.pw_coeffs(0).remap_forward_begin(num_bands__, idx0);
+        auto& psi_extra = psi.pw_coeffs(0).extra();
+        if (static_cast<int>(psi_extra.size(0)) != static_cast<int>(row_gvec.size())) {
+            err = 1;
+        }
+        for (int i = 0; i < spl_col.local_size(); i++) {
+            psi.pw_coeffs(0).remap_forward_wait(i);
+            if (!err) {
+                check_extra(psi_extra, i);
+            }
+        }
+        psi.pw_coeffs(0).remap_forward_end();
+
+        /* extra -> prime; without remapping the extra storage is the prime storage itself */
+        if (!psi.pw_coeffs(0).is_remapped()) {
+            continue;
+        }
+        for (int i = 0; i < 2 * num_bands__; i++) {
+            for (int j = 0; j < psi.pw_coeffs(0).num_rows_loc(); j++) {
+                psi.pw_coeffs(0).prime(j, i) = 0;
+            }
+        }
+        psi.pw_coeffs(0).remap_backward(CPU, num_bands__, idx0);
+        for (int i = 0; i < 2 * num_bands__; i++) {
+            for (int j = 0; j < psi.pw_coeffs(0).num_rows_loc(); j++) {
+                auto z = (i >= idx0 && i < idx0 + num_bands__) ? phi.pw_coeffs(0).prime(j, i) : double_complex(0, 0);
+                if (psi.pw_coeffs(0).prime(j, i) != z) {
+                    err = 1;
+                }
+            }
+        }
+    }
+    Communicator::world().allreduce<int, mpi_op_t::max>(&err, 1);
+    return err;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--cutoff=", "{double} wave-functions cutoff");
+    args.register_key("--num_bands=", "{int} number of bands");
+    args.register_key("--mpi_grid_dims=", "{int int} dimensions of MPI grid");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto cutoff = args.value<double>("cutoff", 4.0);
+    auto num_bands = args.value<int>("num_bands", 37);
+
+    sirius::initialize(1);
+
+    /* by default all ranks are in the column communicator, so the wave-functions are remapped */
+    auto mpi_grid_dims = args.value<std::vector<int>>("mpi_grid_dims", {1, Communicator::world().size()});
+
+    int err = test_wf_remap(mpi_grid_dims, cutoff, num_bands);
+    if (Communicator::world().rank() == 0) {
+        printf("%s\n", err ? "Failed" : "OK");
+    }
+
+    sirius::finalize();
+
+    return err;
+}
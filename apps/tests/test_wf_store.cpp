@@ -0,0 +1,121 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* page wave-functions out to the scratch file and read them back */
+int test_wf_store(double cutoff__, int num_bands__, std::string const& path__)
+{
+    matrix3d<double> M = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    Gvec gvec(M, cutoff__, Communicator::world(), false);
+
+    Gvec_partition gvecp(gvec, Communicator::world(), Communicator::self());
+
+    std::vector<std::unique_ptr<Wave_functions>> phi;
+    std::vector<double_complex> cs;
+    for (int k = 0; k < 3; k++) {
+        phi.push_back(std::unique_ptr<Wave_functions>(new Wave_functions(gvecp, num_bands__, 2)));
+        for (int ispn = 0; ispn < 2; ispn++) {
+            for (int i = 0; i < num_bands__; i++) {
+                for (int j = 0; j < phi[k]->pw_coeffs(ispn).num_rows_loc(); j++) {
+                    phi[k]->pw_coeffs(ispn).prime(j, i) = type_wrapper<double_complex>::random();
+                }
+            }
+        }
+        cs.push_back(phi[k]->checksum_pw(CPU, 0, 0, num_bands__) + phi[k]->checksum_pw(CPU, 1, 0, num_bands__));
+    }
+
+    Wave_functions_store store(path__);
+    for (int k = 0; k < 3; k++) {
+        store.add(*phi[k]);
+        store.page_out(k);
+    }
+
+    auto checksum = [&](int k)
+    {
+        return phi[k]->checksum_pw(CPU, 0, 0, num_bands__) + phi[k]->checksum_pw(CPU, 1, 0, num_bands__);
+    };
+
+    int err{0};
+    /* the same access pattern as in the loop over k-points: prefetch next, process current, page out;
+       the wave-functions are modified in the first pass and only read in the second pass */
+    for (int iter = 0; iter < 2; iter++) {
+        bool modify = (iter == 0);
+        for (int k = 0; k < 3; k++) {
+            if (k + 1 < 3) {
+                store.prefetch(k + 1, modify);
+            }
+            store.page_in(k, modify);
+            if (std::abs(checksum(k) - cs[k]) > 1e-12) {
+                err = 1;
+            }
+            if (modify) {
+                for (int ispn = 0; ispn < 2; ispn++) {
+                    for (int i = 0; i < num_bands__; i++) {
+                        for (int j = 0; j < phi[k]->pw_coeffs(ispn).num_rows_loc(); j++) {
+                            phi[k]->pw_coeffs(ispn).prime(j, i) *= 2.0;
+                        }
+                    }
+                }
+                cs[k] *= 2.0;
+            }
+            if (store.is_dirty(k) != modify) {
+                err = 1;
+            }
+            store.page_out(k);
+        }
+    }
+    /* no explicit page out: the least recently used wave-functions are paged out by the store */
+    for (int iter = 0; iter < 2; iter++) {
+        for (int k = 0; k < 3; k++) {
+            store.page_in(k, false);
+            if (std::abs(checksum(k) - cs[k]) > 1e-12) {
+                err = 1;
+            }
+            int n{0};
+            for (int k1 = 0; k1 < 3; k1++) {
+                n += store.is_resident(k1);
+            }
+            if (n > 2) {
+                err = 1;
+            }
+        }
+    }
+    for (int k = 0; k < 3; k++) {
+        store.page_out(k);
+        if (store.is_resident(k)) {
+            err = 1;
+        }
+    }
+    return err;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--cutoff=", "{double} wave-functions cutoff");
+    args.register_key("--num_bands=", "{int} number of bands");
+    args.register_key("--path=", "{string} directory of the scratch file");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto cutoff = args.value<double>("cutoff", 4.0);
+    auto num_bands = args.value<int>("num_bands", 20);
+    auto path = args.value<std::string>("path", ".");
+
+    sirius::initialize(1);
+
+    int err = test_wf_store(cutoff, num_bands, path);
+    Communicator::world().allreduce<int, mpi_op_t::max>(&err, 1);
+    if (Communicator::world().rank() == 0) {
+        printf("%s\n", err ? "Failed" : "OK");
+    }
+
+    sirius::finalize();
+
+    return err;
+}
@@ -2,11 +2,13 @@
 
 using namespace sirius;
 
-void test_wf_ortho(std::vector<int> mpi_grid_dims__,
-                   double cutoff__,
-                   int num_bands__,
-                   int use_gpu__,
-                   int bs__)
+double test_wf_ortho(std::vector<int> mpi_grid_dims__,
+                     double cutoff__,
+                     int num_bands__,
+                     int use_gpu__,
+                     int bs__,
+                     ortho_method_t method__,
+                     double* time__ = nullptr)
 {
     device_t pu = static_cast<device_t>(use_gpu__);
 
@@ -34,20 +36,31 @@ void test_wf_ortho(std::vector<int> mpi_grid_dims__,
 
     dmatrix<double_complex> ovlp(2 * num_bands__, 2 * num_bands__, blacs_grid, bs__, bs__);
     
-    orthogonalize<double_complex>(pu, 0, phi, hphi, 0, num_bands__, ovlp, tmp);
-    orthogonalize<double_complex>(pu, 0, phi, hphi, num_bands__, num_bands__, ovlp, tmp);
+    Communicator::world().barrier();
+    double t = -omp_get_wtime();
+    orthogonalize<double_complex>(pu, 0, phi, hphi, 0, num_bands__, ovlp, tmp, method__);
+    orthogonalize<double_complex>(pu, 0, phi, hphi, num_bands__, num_bands__, ovlp, tmp, method__);
+    Communicator::world().barrier();
+    t += omp_get_wtime();
+    if (time__) {
+        *time__ = t;
+    }
 
     inner(pu, 0, phi, 0, 2 * num_bands__, phi, 0, 2 * num_bands__, ovlp, 0, 0);
 
+    double err{0};
     for (int j = 0; j < ovlp.num_cols_local(); j++) {
         for (int i = 0; i < ovlp.num_rows_local(); i++) {
             double_complex z = (ovlp.irow(i) == ovlp.icol(j)) ? ovlp(i, j) - 1.0 : ovlp(i, j);
-            if (std::abs(z) > 1e-12) {
-                printf("test_wf_ortho: wrong overlap");
-                exit(1);
-            }
+            err = std::max(err, std::abs(z));
         }
     }
+    Communicator::world().allreduce<double, mpi_op_t::max>(&err, 1);
+    if (err > 1e-12) {
+        printf("test_wf_ortho: wrong overlap");
+        exit(1);
+    }
+    return err;
 }
 
 int main(int argn, char** argv)
@@ -57,6 +70,7 @@ int main(int argn, char** argv)
     args.register_key("--cutoff=", "{double} wave-functions cutoff");
     //args.register_key("--bs=", "{int} block size");
     args.register_key("--use_gpu=", "{int} 0: CPU only, 1: hybrid CPU+GPU");
+    args.register_key("--num_bands=", "{int} number of bands in the benchmark");
 
     args.parse_args(argn, argv);
     if (args.exist("help")) {
@@ -68,11 +82,22 @@ int main(int argn, char** argv)
     auto cutoff = args.value<double>("cutoff", 8.0);
     auto use_gpu = args.value<int>("use_gpu", 0);
     //auto bs = args.value<int>("bs", 16);
+    auto num_bands = args.value<int>("num_bands", 200);
 
     sirius::initialize(1);
-    for (int bs = 1; bs < 16; bs++) {
-        for (int i = 1; i < 30; i++) {
-            test_wf_ortho(mpi_grid_dims, cutoff, i, use_gpu, bs);
+    for (auto method: {"cholesky", "cholesky_qr2", "tsqr"}) {
+        for (int bs = 1; bs < 16; bs++) {
+            for (int i = 1; i < 30; i++) {
+                test_wf_ortho(mpi_grid_dims, cutoff, i, use_gpu, bs, get_ortho_method_t(method));
+            }
+        }
+    }
+    /* benchmark: time and orthogonality error of each method */
+    for (auto method: {"cholesky", "cholesky_qr2", "tsqr"}) {
+        double t{0};
+        double err = test_wf_ortho(mpi_grid_dims, cutoff, num_bands, use_gpu, 32, get_ortho_method_t(method), &t);
+        if (Communicator::world().rank() == 0) {
+            printf("method: %-12s  time: %12.6f (sec)  orthogonality error: %18.12e\n", method, t, err);
         }
     }
     Communicator::world().barrier();
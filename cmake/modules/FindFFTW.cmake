@@ -12,6 +12,12 @@ find_library(FFTW_LIBRARIES NAMES fftw3
   HINTS ENV FFTWROOT
   )
 
+# single precision library (optional)
+find_library(FFTWF_LIBRARIES NAMES fftw3f
+  HINTS ENV MKLROOT
+  HINTS ENV FFTWROOT
+  )
+
 set(FFTW_INCLUDE_DIRS ${FFTW_INCLUDE_DIR})
 
 if(FFTW_LIBRARIES MATCHES "NOTFOUND")
@@ -75,6 +75,19 @@ class Band // TODO: Band class is lightweight and in principle can be converted
     template <typename T>
     inline int diag_pseudo_potential_davidson(K_point* kp__, Hamiltonian& H__) const;
 
+    /// Block LOBPCG diagonalization with soft locking.
+    /** The basis consists of the current wave-functions X, the search directions P and the preconditioned
+     *  residuals W and never exceeds three times the number of bands. */
+    template <typename T>
+    inline int diag_pseudo_potential_lobpcg(K_point* kp__, Hamiltonian& H__) const;
+
+    /// Projected preconditioned conjugate gradient (PPCG) diagonalization.
+    /** Each band is updated by the Rayleigh-Ritz step in the 3-dimensional subspace of its current approximation,
+     *  preconditioned residual and search direction. The Rayleigh-Ritz step in the subspace of all bands is only
+     *  done every iterative_solver.rr_period iterations and at the end. */
+    template <typename T>
+    inline int diag_pseudo_potential_ppcg(K_point* kp__, Hamiltonian& H__) const;
+
     /// RMM-DIIS diagonalization.
     template <typename T>
     inline void diag_pseudo_potential_rmm_diis(K_point* kp__, int ispn__, Hamiltonian& H__) const;
@@ -95,6 +108,9 @@ class Band // TODO: Band class is lightweight and in principle can be converted
                                             mdarray<double, 1>& o_diag__) const;
 
     /// Compute residuals.
+    /** If num_locked is not zero, the first num_locked bands are locked: the active basis functions start from the
+     *  column num_locked of hphi and ophi, and num_bands, evec and the optional list of converged bands refer to
+     *  the active bands only; eval and eval_old are indexed by the band. */
     template <typename T>
     inline int residuals(K_point* kp__,
                          int ispn__,
@@ -109,7 +125,9 @@ class Band // TODO: Band class is lightweight and in principle can be converted
                          Wave_functions& opsi__,
                          Wave_functions& res__,
                          mdarray<double, 2>& h_diag__,
-                         mdarray<double, 1>& o_diag__) const;
+                         mdarray<double, 1>& o_diag__,
+                         int num_locked__ = 0,
+                         std::vector<bool>* converged__ = nullptr) const;
 
     template <typename T>
     void check_residuals(K_point* kp__, Hamiltonian& H__) const;
@@ -158,14 +176,17 @@ class Band // TODO: Band class is lightweight and in principle can be converted
 
     /** Compute \f$ O_{ii'} = \langle \phi_i | \hat O | \phi_{i'} \rangle \f$ operator matrix
      *  for the subspace spanned by the wave-functions \f$ \phi_i \f$. The matrix is always returned
-     *  in the CPU pointer because most of the standard math libraries start from the CPU. */
+     *  in the CPU pointer because most of the standard math libraries start from the CPU. The wave-functions
+     *  of the subspace start from the column N0 of phi and op_phi. The old N x N block of the matrix is taken
+     *  from mtrx_old; if mtrx_old is empty, the block is expected to be already set in mtrx. */
     template <typename T>
     inline void set_subspace_mtrx(int N__,
                                   int n__,
                                   Wave_functions& phi__,
                                   Wave_functions& op_phi__,
                                   dmatrix<T>& mtrx__,
-                                  dmatrix<T>& mtrx_old__) const;
+                                  dmatrix<T>& mtrx_old__,
+                                  int N0__ = 0) const;
 
   public:
     /// Constructor
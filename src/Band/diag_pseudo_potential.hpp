@@ -53,6 +53,10 @@ int Band::diag_pseudo_potential(K_point* kp__, Hamiltonian& H__) const
         }
     } else if (itso.type_ == "davidson") {
         niter = diag_pseudo_potential_davidson<T>(kp__, H__);
+    } else if (itso.type_ == "lobpcg") {
+        niter = diag_pseudo_potential_lobpcg<T>(kp__, H__);
+    } else if (itso.type_ == "ppcg") {
+        niter = diag_pseudo_potential_ppcg<T>(kp__, H__);
     } else if (itso.type_ == "rmm-diis") {
         if (ctx_.num_mag_dims() != 3) {
             for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
@@ -232,6 +236,20 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
 
     bool converge_by_energy = (itso.converge_by_energy_ == 1);
 
+    auto ortho_method = get_ortho_method_t(itso.ortho_method_);
+
+    /* locked bands are kept out of the subspace; the new basis functions stay orthogonal to them only if the
+     * basis is orthogonalized */
+    bool locking = itso.locking_ && itso.orthogonalize_;
+
+    /* S operator is the identity if none of the atom types is augmented */
+    bool s_is_one{true};
+    for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
+        if (ctx_.unit_cell().atom_type(iat).augment()) {
+            s_is_one = false;
+        }
+    }
+
     if (ctx_.control().verbosity_ >= 2 && kp__->comm().rank() == 0) {
         printf("iterative solver tolerance: %18.12f\n", ctx_.iterative_solver_tolerance());
     }
@@ -262,24 +280,45 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
         TERMINATE(s);
     }
 
-    /* total memory size of all wave-functions */
-    const size_t size = num_sc * kp__->num_gkvec_loc() * (3 * num_phi + 3 * num_bands);
+    /* in the early SCF iterations the auxiliary basis is stored in single precision (mixed precision solver);
+       the subspace matrices are still accumulated and diagonalized in double precision */
+    const bool fp32 = ctx_.local_op_fp32() && ctx_.processing_unit() == CPU;
+
+    /* total memory size of all double precision wave-functions */
+    const size_t size = num_sc * kp__->num_gkvec_loc() * ((fp32 ? 0 : 3 * num_phi) + 3 * num_bands);
     /* get preallocatd memory buffer */
     double_complex* mem_buf_ptr = ctx_.mem_pool().allocate<double_complex, memory_t::host>(size);
 
     /* allocate wave-functions */
 
+    /* memory buffer for the auxiliary wave-functions stored in single precision */
+    std::complex<float>* mem_buf_fp32_ptr{nullptr};
+    if (fp32) {
+        mem_buf_fp32_ptr = ctx_.mem_pool().allocate<std::complex<float>, memory_t::host>(
+            num_sc * kp__->num_gkvec_loc() * 3 * num_phi);
+    }
+
+    /* create auxiliary wave-functions in double or single precision */
+    auto aux_wf = [&]() -> Wave_functions
+    {
+        size_t sz = kp__->num_gkvec_loc() * num_phi * num_sc;
+        if (fp32) {
+            mem_buf_fp32_ptr += sz;
+            return Wave_functions(mem_buf_fp32_ptr - sz, kp__->gkvec_partition(), num_phi, num_sc);
+        } else {
+            mem_buf_ptr += sz;
+            return Wave_functions(mem_buf_ptr - sz, kp__->gkvec_partition(), num_phi, num_sc);
+        }
+    };
+
     /* auxiliary wave-functions */
-    Wave_functions phi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
-    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+    Wave_functions phi = aux_wf();
 
     /* Hamiltonian, applied to auxiliary wave-functions */
-    Wave_functions hphi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
-    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+    Wave_functions hphi = aux_wf();
 
     /* S operator, applied to auxiliary wave-functions */
-    Wave_functions sphi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
-    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+    Wave_functions sphi = aux_wf();
 
     /* Hamiltonain, applied to new Psi wave-functions */
     Wave_functions hpsi(mem_buf_ptr, kp__->gkvec_partition(), num_bands, num_sc);
@@ -433,27 +472,48 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
         /* number of newly added basis functions */
         int n{0};
 
+        /* number of locked bands; they are the first num_lock bands and the first num_lock basis functions */
+        int num_lock{0};
+
+        /* number of active bands */
+        int num_act = num_bands;
+
+        /* convergence flags of the active bands */
+        std::vector<bool> converged;
+
         /* second phase: start iterative diagonalization */
         for (int k = 0; k < itso.num_steps_; k++) {
 
+            /* number of lowest active bands that are converged */
+            int num_conv{0};
+
             /* don't compute residuals on last iteration */
             if (k != itso.num_steps_ - 1) {
                 /* get new preconditionined residuals, and also hpsi and opsi as a by-product */
-                n = residuals<T>(kp__, nc_mag ? 2 : ispin_step, N, num_bands, eval, eval_old, evec, hphi,
-                                 sphi, hpsi, spsi, res, h_diag, o_diag);
+                n = residuals<T>(kp__, nc_mag ? 2 : ispin_step, N, num_act, eval, eval_old, evec, hphi,
+                                 sphi, hpsi, spsi, res, h_diag, o_diag, num_lock, &converged);
+                if (locking) {
+                    while (num_conv < num_act && converged[num_conv]) {
+                        num_conv++;
+                    }
+                }
             }
 
+            /* lock the converged lowest bands when the subspace is collapsed anyway, or when it consists only of
+             * the current approximations to the active bands, in which case the collapse is lossless */
+            bool lock = (num_conv > 0) && (N == num_act || num_lock + N + n > num_phi);
+
             /* check if we run out of variational space or eigen-vectors are converged or it's a last iteration */
-            if (N + n > num_phi || n <= itso.min_num_res_ || k == (itso.num_steps_ - 1)) {
+            if (num_lock + N + n > num_phi || n <= itso.min_num_res_ || k == (itso.num_steps_ - 1) || lock) {
                 utils::timer t1("sirius::Band::diag_pseudo_potential_davidson|update_phi");
                 /* recompute wave-functions */
                 /* \Psi_{i} = \sum_{mu} \phi_{mu} * Z_{mu, i} */
                 if (ctx_.settings().always_update_wf_ || k + n > 0) {
                     /* in case of non-collinear magnetism transform two components */
-                    transform<T>(ctx_.processing_unit(), nc_mag ? 2 : ispin_step, {&phi}, 0, N, evec, 0, 0,
-                                 {&psi}, 0, num_bands);
+                    transform<T>(ctx_.processing_unit(), nc_mag ? 2 : ispin_step, {&phi}, num_lock, N, evec, 0, 0,
+                                 {&psi}, num_lock, num_act);
                     /* update eigen-values */
-                    for (int j = 0; j < num_bands; j++) {
+                    for (int j = num_lock; j < num_bands; j++) {
                         kp__->band_energy(j, ispin_step) = eval[j];
                     }
                 } else {
@@ -467,15 +527,22 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
                     break;
                 } else { /* otherwise, set Psi as a new trial basis */
                     if (ctx_.control().verbosity_ >= 3 && kp__->comm().rank() == 0) {
-                        printf("subspace size limit reached\n");
+                        if (lock) {
+                            printf("locking %i converged bands\n", num_conv);
+                        } else {
+                            printf("subspace size limit reached\n");
+                        }
                     }
+                    /* converged bands are locked: their basis functions stay in front of the active ones and the
+                     * active subspace starts from the remaining Ritz vectors */
+                    int num_act_new = num_act - num_conv;
                     hmlt_old.zero();
-                    for (int i = 0; i < num_bands; i++) {
-                        hmlt_old.set(i, i, eval[i]);
+                    for (int i = 0; i < num_act_new; i++) {
+                        hmlt_old.set(i, i, eval[num_lock + num_conv + i]);
                     }
                     if (!itso.orthogonalize_) {
                         ovlp_old.zero();
-                        for (int i = 0; i < num_bands; i++) {
+                        for (int i = 0; i < num_act_new; i++) {
                             ovlp_old.set(i, i, 1);
                         }
                     }
@@ -483,37 +550,48 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
                     /* need to compute all hpsi and opsi states (not only unconverged) */
                     if (converge_by_energy) {
                         transform<T>(ctx_.processing_unit(), nc_mag ? 2 : ispin_step, 1.0,
-                                     std::vector<Wave_functions*>({&hphi, &sphi}), 0, N, evec, 0, 0, 0.0,
-                                     {&hpsi, &spsi}, 0, num_bands);
+                                     std::vector<Wave_functions*>({&hphi, &sphi}), num_lock, N, evec, 0, 0, 0.0,
+                                     {&hpsi, &spsi}, 0, num_act);
                     }
 
                     /* update basis functions, hphi and ophi */
                     for (int ispn = 0; ispn < num_sc; ispn++) {
-                        phi.copy_from(ctx_.processing_unit(), num_bands, psi, nc_mag ? ispn : ispin_step, 0, nc_mag ? ispn : 0, 0);
-                        hphi.copy_from(ctx_.processing_unit(), num_bands, hpsi, ispn, 0, ispn, 0);
-                        sphi.copy_from(ctx_.processing_unit(), num_bands, spsi, ispn, 0, ispn, 0);
+                        phi.copy_from(ctx_.processing_unit(), num_act, psi, nc_mag ? ispn : ispin_step, num_lock,
+                                      nc_mag ? ispn : 0, num_lock);
+                        hphi.copy_from(ctx_.processing_unit(), num_act, hpsi, ispn, 0, ispn, num_lock);
+                        sphi.copy_from(ctx_.processing_unit(), num_act, spsi, ispn, 0, ispn, num_lock);
                     }
+                    num_lock += num_conv;
+                    num_act = num_act_new;
                     /* number of basis functions that we already have */
-                    N = num_bands;
+                    N = num_act;
                 }
             }
 
             /* expand variational subspace with new basis vectors obtatined from residuals */
             for (int ispn = 0; ispn < num_sc; ispn++) {
-                phi.copy_from(ctx_.processing_unit(), n, res, ispn, 0, ispn, N);
+                phi.copy_from(ctx_.processing_unit(), n, res, ispn, 0, ispn, num_lock + N);
             }
 
             /* apply Hamiltonian and S operators to the new basis functions */
-            H__.apply_h_s<T>(kp__, nc_mag ? 2 : ispin_step, N, n, phi, &hphi, &sphi);
+            H__.apply_h_s<T>(kp__, nc_mag ? 2 : ispin_step, num_lock + N, n, phi, &hphi, &sphi);
 
+            /* new basis functions are orthogonalized to the locked and to the active ones */
             if (itso.orthogonalize_) {
-                orthogonalize<T>(ctx_.processing_unit(), nc_mag ? 2 : 0, phi, hphi, sphi, N, n, ovlp, res);
+                if (s_is_one) {
+                    /* overlap of the new basis functions is <phi|phi>; this allows the TSQR orthonormalization */
+                    orthogonalize<T, 0, 0>(ctx_.processing_unit(), nc_mag ? 2 : 0, {&phi, &hphi, &sphi},
+                                           num_lock + N, n, ovlp, res, ortho_method);
+                } else {
+                    orthogonalize<T>(ctx_.processing_unit(), nc_mag ? 2 : 0, phi, hphi, sphi, num_lock + N, n, ovlp,
+                                     res, ortho_method);
+                }
             }
 
-            /* setup eigen-value problem
+            /* setup eigen-value problem for the active subspace
              * N is the number of previous basis functions
              * n is the number of new basis functions */
-            set_subspace_mtrx(N, n, phi, hphi, hmlt, hmlt_old);
+            set_subspace_mtrx(N, n, phi, hphi, hmlt, hmlt_old, num_lock);
 
             if (ctx_.control().verification_ >= 1) {
                 double max_diff = check_hermitian(hmlt, N + n);
@@ -526,7 +604,7 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
 
             if (!itso.orthogonalize_) {
                 /* setup overlap matrix */
-                set_subspace_mtrx(N, n, phi, sphi, ovlp, ovlp_old);
+                set_subspace_mtrx(N, n, phi, sphi, ovlp, ovlp_old, num_lock);
 
                 if (ctx_.control().verification_ >= 1) {
                     double max_diff = check_hermitian(ovlp, N + n);
@@ -546,14 +624,14 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
             utils::timer t1("sirius::Band::diag_pseudo_potential_davidson|evp");
             if (itso.orthogonalize_) {
                 /* solve standard eigen-value problem with the size N */
-                if (std_solver->solve(N, num_bands, hmlt, eval.data(), evec)) {
+                if (std_solver->solve(N, num_act, hmlt, &eval[num_lock], evec)) {
                     std::stringstream s;
                     s << "error in diagonalziation";
                     TERMINATE(s);
                 }
             } else {
                 /* solve generalized eigen-value problem with the size N */
-                if (gen_solver->solve(N, num_bands, hmlt, ovlp, eval.data(), evec)) {
+                if (gen_solver->solve(N, num_act, hmlt, ovlp, &eval[num_lock], evec)) {
                     std::stringstream s;
                     s << "error in diagonalziation";
                     TERMINATE(s);
@@ -564,7 +642,8 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
             evp_work_count() += std::pow(static_cast<double>(N) / num_bands, 3);
 
             if (ctx_.control().verbosity_ >= 2 && kp__->comm().rank() == 0) {
-                printf("step: %i, current subspace size: %i, maximum subspace size: %i\n", k, N, num_phi);
+                printf("step: %i, current subspace size: %i, maximum subspace size: %i, locked bands: %i\n", k, N,
+                       num_phi, num_lock);
                 if (ctx_.control().verbosity_ >= 4) {
                     for (int i = 0; i < num_bands; i++) {
                         printf("eval[%i]=%20.16f, diff=%20.16f, occ=%20.16f\n", i, eval[i], std::abs(eval[i] - eval_old[i]),
@@ -574,6 +653,21 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
             }
             niter++;
         }
+
+        /* wave-functions, expanded in the single precision basis, are orthonormal only to the single precision;
+         * restore the orthonormality in double precision, otherwise the error is carried over to the next
+         * (double precision) runs of the solver which assume orthonormal starting vectors */
+        if (fp32) {
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                hpsi.copy_from(ctx_.processing_unit(), num_bands, psi, nc_mag ? ispn : ispin_step, 0, ispn, 0);
+            }
+            H__.apply_h_s<T>(kp__, nc_mag ? 2 : ispin_step, 0, num_bands, hpsi, nullptr, &spsi);
+            orthogonalize<T, 0, 1>(ctx_.processing_unit(), nc_mag ? 2 : ispin_step, {&hpsi, &spsi}, 0, num_bands,
+                                   ovlp, res);
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                psi.copy_from(ctx_.processing_unit(), num_bands, hpsi, ispn, 0, nc_mag ? ispn : ispin_step, 0);
+            }
+        }
     } /* loop over ispin_step */
     t3.stop();
 
@@ -617,6 +711,784 @@ inline int Band::diag_pseudo_potential_davidson(K_point*       kp__,
     return niter;
 }
 
+template <typename T>
+inline int Band::diag_pseudo_potential_lobpcg(K_point*     kp__,
+                                              Hamiltonian& H__) const
+{
+    PROFILE("sirius::Band::diag_pseudo_potential_lobpcg");
+
+    auto& itso = ctx_.iterative_solver_input();
+
+    bool converge_by_energy = (itso.converge_by_energy_ == 1);
+
+    auto ortho_method = get_ortho_method_t(itso.ortho_method_);
+
+    /* S operator is the identity if none of the atom types is augmented */
+    bool s_is_one{true};
+    for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
+        if (ctx_.unit_cell().atom_type(iat).augment()) {
+            s_is_one = false;
+        }
+    }
+
+    /* true if this is a non-collinear case */
+    const bool nc_mag = (ctx_.num_mag_dims() == 3);
+
+    /* number of spin components, treated simultaneously */
+    const int num_sc = nc_mag ? 2 : 1;
+
+    /* short notation for number of target wave-functions */
+    const int num_bands = ctx_.num_bands();
+
+    /* short notation for target wave-functions */
+    auto& psi = kp__->spinor_wave_functions();
+
+    /* the basis {X, P, W} is never larger than three times the number of bands */
+    const int num_phi = 3 * num_bands;
+
+    if (num_phi > kp__->num_gkvec()) {
+        std::stringstream s;
+        s << "subspace size is too large!";
+        TERMINATE(s);
+    }
+
+    utils::timer t1("sirius::Band::diag_pseudo_potential_lobpcg|wf");
+
+    /* total memory size of all wave-functions; the basis is rotated in place and psi holds the residuals and
+     * serves as a temporary storage for the orthogonalization, so no other wave-functions are needed */
+    const size_t size = num_sc * kp__->num_gkvec_loc() * 3 * num_phi;
+    /* get preallocatd memory buffer */
+    double_complex* mem_buf_ptr = ctx_.mem_pool().allocate<double_complex, memory_t::host>(size);
+
+    /* basis functions: current approximation X to the wave-functions, search directions P and
+     * preconditioned residuals W */
+    Wave_functions phi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
+    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+
+    /* Hamiltonian, applied to basis functions */
+    Wave_functions hphi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
+    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+
+    /* S operator, applied to basis functions */
+    Wave_functions sphi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
+    t1.stop();
+
+    auto mem_type = (ctx_.std_evp_solver_type() == ev_solver_t::magma) ? memory_t::host_pinned : memory_t::host;
+
+    const int bs = ctx_.cyclic_block_size();
+
+    dmatrix<T> hmlt(num_phi, num_phi, ctx_.blacs_grid(), bs, bs, mem_type);
+    /* overlap matrix of the initial X; later it is used by the orthogonalization of P to X and of W to {X, P} */
+    dmatrix<T> ovlp(2 * num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
+    dmatrix<T> evec(num_phi, num_phi, ctx_.blacs_grid(), bs, bs, mem_type);
+    /* the Ritz vectors X diagonalize the Hamiltonian, so the old block of the subspace matrix is set directly */
+    dmatrix<T> hmlt_old;
+    dmatrix<T> ovlp_old;
+
+    /* full copy of the Ritz vectors, extended by their {P, W} components, for the in-place rotation of the basis */
+    mdarray<T, 2> z(num_phi, 2 * num_bands);
+
+    kp__->beta_projectors().prepare();
+
+    #ifdef __GPU
+    if (ctx_.processing_unit() == GPU) {
+        if (!keep_wf_on_gpu) {
+            for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+                psi.pw_coeffs(ispn).allocate_on_device();
+                psi.pw_coeffs(ispn).copy_to_device(0, num_bands);
+            }
+        }
+        for (int i = 0; i < num_sc; i++) {
+            phi.pw_coeffs(i).allocate_on_device();
+            hphi.pw_coeffs(i).allocate_on_device();
+            sphi.pw_coeffs(i).allocate_on_device();
+        }
+        z.allocate(memory_t::device);
+
+        if (ctx_.blacs_grid().comm().size() == 1) {
+            evec.allocate(memory_t::device);
+            ovlp.allocate(memory_t::device);
+            hmlt.allocate(memory_t::device);
+        }
+    }
+    #endif
+
+    /* get diagonal elements for preconditioning */
+    auto h_diag = H__.get_h_diag<T>(kp__);
+    auto o_diag = H__.get_o_diag<T>(kp__);
+
+    auto std_solver = ctx_.std_evp_solver<T>();
+    auto gen_solver = ctx_.gen_evp_solver<T>();
+
+    auto pu = ctx_.processing_unit();
+
+    int niter{0};
+
+    utils::timer t3("sirius::Band::diag_pseudo_potential_lobpcg|iter");
+    for (int ispin_step = 0; ispin_step < ctx_.num_spin_dims(); ispin_step++) {
+
+        /* spin index of the operators and of the auxiliary wave-functions */
+        const int ispn_op = nc_mag ? 2 : ispin_step;
+
+        std::vector<double> eval(num_bands);
+        std::vector<double> eval_old(num_bands, 1e100);
+
+        if (itso.init_eval_old_) {
+            for (int j = 0; j < num_bands; j++) {
+                eval_old[j] = kp__->band_energy(j, ispin_step);
+            }
+        }
+
+        /* initial X */
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            phi.copy_from(pu, num_bands, psi, nc_mag ? ispn : ispin_step, 0, ispn, 0);
+        }
+        H__.apply_h_s<T>(kp__, ispn_op, 0, num_bands, phi, &hphi, &sphi);
+
+        /* Rayleigh-Ritz in the subspace of X; the starting wave-functions are not necessarily orthonormal */
+        set_subspace_mtrx(0, num_bands, phi, hphi, hmlt, hmlt_old);
+        set_subspace_mtrx(0, num_bands, phi, sphi, ovlp, ovlp_old);
+
+        utils::timer t1("sirius::Band::diag_pseudo_potential_lobpcg|evp");
+        if (gen_solver->solve(num_bands, num_bands, hmlt, ovlp, eval.data(), evec)) {
+            std::stringstream s;
+            s << "error in diagonalziation";
+            TERMINATE(s);
+        }
+        t1.stop();
+
+        evp_work_count() += 1;
+
+        /* current size of the basis {X, P, W} */
+        int N = num_bands;
+
+        for (int k = 0; k < itso.num_steps_; k++) {
+            utils::timer t2("sirius::Band::diag_pseudo_potential_lobpcg|update");
+            /* Ritz vectors X = X C_X + {P, W} C_{PW} go to the columns [0, num_bands) and the new search directions
+             * P = {P, W} C_{PW} go to the columns [num_bands, 2 * num_bands) */
+            int nout = (N > num_bands) ? 2 * num_bands : num_bands;
+            z.zero();
+            for (int jloc = 0; jloc < evec.num_cols_local(); jloc++) {
+                int j = evec.icol(jloc);
+                if (j >= num_bands) {
+                    continue;
+                }
+                for (int iloc = 0; iloc < evec.num_rows_local(); iloc++) {
+                    int i = evec.irow(iloc);
+                    if (i < N) {
+                        z(i, j) = evec(iloc, jloc);
+                        if (i >= num_bands) {
+                            z(i, num_bands + j) = evec(iloc, jloc);
+                        }
+                    }
+                }
+            }
+            if (evec.comm().size() > 1) {
+                evec.comm().allreduce(z.template at<CPU>(), static_cast<int>(z.size()));
+            }
+            if (pu == GPU) {
+                z.template copy<memory_t::host, memory_t::device>();
+            }
+            transform_in_place<T>(pu, ispn_op, {&phi, &hphi, &sphi}, 0, N, z, 0, nout);
+            for (int j = 0; j < num_bands; j++) {
+                kp__->band_energy(j, ispin_step) = eval[j];
+            }
+            t2.stop();
+
+            /* don't compute residuals on last iteration */
+            if (k == itso.num_steps_ - 1) {
+                break;
+            }
+
+            /* preconditioned residuals of all bands; they are stored in psi until the end of the iterations */
+            auto res_norm = residuals_aux(kp__, ispn_op, num_bands, eval, hphi, sphi, psi, h_diag, o_diag);
+
+            /* soft locking: converged bands stay in X, but their search directions and residuals are dropped */
+            std::vector<int> act;
+            for (int j = 0; j < num_bands; j++) {
+                bool conv = res_norm[j] <= itso.residual_tolerance_;
+                if (converge_by_energy) {
+                    double o1 = std::abs(kp__->band_occupancy(j, nc_mag ? 0 : ispin_step) / ctx_.max_occupancy());
+                    double o2 = std::abs(1 - o1);
+                    double tol = o1 * itso.energy_tolerance_ + o2 * (itso.energy_tolerance_ +
+                                                                     itso.empty_states_tolerance_);
+                    conv = conv || (std::abs(eval[j] - eval_old[j]) <= tol);
+                }
+                if (!conv) {
+                    act.push_back(j);
+                }
+            }
+            int n = static_cast<int>(act.size());
+
+            if (ctx_.control().verbosity_ >= 3 && kp__->comm().rank() == 0) {
+                printf("number of residuals : %i\n", n);
+            }
+
+            if (n <= itso.min_num_res_) {
+                break;
+            }
+
+            /* number of search directions */
+            int np = (N > num_bands) ? n : 0;
+
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                for (int j = 0; j < np; j++) {
+                    if (act[j] != j) {
+                        phi.copy_from(pu, 1, phi, ispn, num_bands + act[j], ispn, num_bands + j);
+                        hphi.copy_from(pu, 1, hphi, ispn, num_bands + act[j], ispn, num_bands + j);
+                        sphi.copy_from(pu, 1, sphi, ispn, num_bands + act[j], ispn, num_bands + j);
+                    }
+                }
+                for (int j = 0; j < n; j++) {
+                    phi.copy_from(pu, 1, psi, nc_mag ? ispn : ispin_step, act[j], ispn, num_bands + np + j);
+                }
+            }
+
+            /* prevent numerical noise in the Gamma-point case */
+            if (std::is_same<T, double>::value && kp__->comm().rank() == 0) {
+                switch (pu) {
+                    case CPU: {
+                        for (int j = num_bands + np; j < num_bands + np + n; j++) {
+                            phi.pw_coeffs(0).prime(0, j) = phi.pw_coeffs(0).prime(0, j).real();
+                        }
+                        break;
+                    }
+                    case GPU: {
+#ifdef __GPU
+                        make_real_g0_gpu(phi.pw_coeffs(0).prime().at<GPU>(0, num_bands + np),
+                                         phi.pw_coeffs(0).prime().ld(), n);
+#endif
+                        break;
+                    }
+                }
+            }
+
+            /* apply Hamiltonian and S operators to the new residuals */
+            H__.apply_h_s<T>(kp__, ispn_op, num_bands + np, n, phi, &hphi, &sphi);
+
+            /* orthonormalize P to X and W to {X, P}; this keeps the Rayleigh-Ritz problem well conditioned */
+            for (auto b: {std::make_pair(num_bands, np), std::make_pair(num_bands + np, n)}) {
+                if (b.second == 0) {
+                    continue;
+                }
+                if (s_is_one) {
+                    orthogonalize<T, 0, 0>(pu, ispn_op, {&phi, &hphi, &sphi}, b.first, b.second, ovlp, psi,
+                                           ortho_method);
+                } else {
+                    orthogonalize<T>(pu, ispn_op, phi, hphi, sphi, b.first, b.second, ovlp, psi, ortho_method);
+                }
+            }
+
+            /* X are the Ritz vectors; the subspace matrix is diagonal in this block */
+            hmlt.zero();
+            for (int j = 0; j < num_bands; j++) {
+                hmlt.set(j, j, eval[j]);
+            }
+            set_subspace_mtrx(num_bands, np + n, phi, hphi, hmlt, hmlt_old);
+
+            N = num_bands + np + n;
+
+            eval_old = eval;
+
+            utils::timer t1("sirius::Band::diag_pseudo_potential_lobpcg|evp");
+            if (std_solver->solve(N, num_bands, hmlt, eval.data(), evec)) {
+                std::stringstream s;
+                s << "error in diagonalziation";
+                TERMINATE(s);
+            }
+            t1.stop();
+
+            evp_work_count() += std::pow(static_cast<double>(N) / num_bands, 3);
+
+            if (ctx_.control().verbosity_ >= 2 && kp__->comm().rank() == 0) {
+                printf("step: %i, current subspace size: %i, number of search directions: %i\n", k, N, np);
+                if (ctx_.control().verbosity_ >= 4) {
+                    for (int i = 0; i < num_bands; i++) {
+                        printf("eval[%i]=%20.16f, diff=%20.16f\n", i, eval[i], std::abs(eval[i] - eval_old[i]));
+                    }
+                }
+            }
+            niter++;
+        }
+
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            psi.copy_from(pu, num_bands, phi, ispn, 0, nc_mag ? ispn : ispin_step, 0);
+        }
+    } /* loop over ispin_step */
+    t3.stop();
+
+    kp__->beta_projectors().dismiss();
+
+    #ifdef __GPU
+    if (ctx_.processing_unit() == GPU) {
+        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            psi.pw_coeffs(ispn).copy_to_host(0, num_bands);
+            if (!keep_wf_on_gpu) {
+                psi.pw_coeffs(ispn).deallocate_on_device();
+            }
+        }
+    }
+    #endif
+
+    ctx_.mem_pool().reset<memory_t::host>();
+
+    return niter;
+}
+
+/// Local contribution to the inner product of two columns of wave-functions.
+/** Only the plane-wave part is taken into account; the result must be reduced over the communicator of
+ *  the wave-functions. */
+template <typename T>
+static T inner_local(int ispn__, Wave_functions& a__, int ia__, Wave_functions& b__, int ib__)
+{
+    int s0 = (ispn__ == 2) ? 0 : ispn__;
+    int s1 = (ispn__ == 2) ? 1 : ispn__;
+
+    double_complex z(0, 0);
+    for (int ispn = s0; ispn <= s1; ispn++) {
+        auto& a = a__.pw_coeffs(ispn).prime();
+        auto& b = b__.pw_coeffs(ispn).prime();
+        double_complex zs(0, 0);
+        for (int ig = 0; ig < a__.pw_coeffs(ispn).num_rows_loc(); ig++) {
+            zs += std::conj(a(ig, ia__)) * b(ig, ib__);
+        }
+        /* real wave-functions: take into account the -G half of the sphere */
+        if (std::is_same<T, double>::value) {
+            zs *= 2;
+            if (a__.comm().rank() == 0) {
+                zs -= std::conj(a(0, ia__)) * b(0, ib__);
+            }
+        }
+        z += zs;
+    }
+    return type_wrapper<T>::bypass(z);
+}
+
+/// Lowest eigen-pair of a small Rayleigh-Ritz problem.
+/** Hamiltonian and overlap matrices of n basis vectors are given as full column-major matrices. Linearly dependent
+ *  basis vectors are dropped by the Gram-Schmidt orthogonalization in the metric of the overlap matrix. The
+ *  expansion coefficients of the lowest Ritz vector are returned in c; the eigen-value is returned. */
+template <typename T>
+static double small_rayleigh_ritz(int n__, T const* h__, T const* o__, T* c__)
+{
+    const int nmax{3};
+    assert(n__ <= nmax);
+
+    /* orthonormal basis in terms of the input basis vectors */
+    T q[nmax * nmax];
+    int m{0};
+    for (int a = 0; a < n__; a++) {
+        T v[nmax];
+        for (int b = 0; b < n__; b++) {
+            v[b] = (a == b) ? 1 : 0;
+        }
+        /* two passes of the projection */
+        for (int pass = 0; pass < 2; pass++) {
+            for (int k = 0; k < m; k++) {
+                T s{0};
+                for (int b = 0; b < n__; b++) {
+                    for (int d = 0; d < n__; d++) {
+                        s += conj_val(q[b + k * nmax]) * o__[b + d * n__] * v[d];
+                    }
+                }
+                for (int b = 0; b < n__; b++) {
+                    v[b] -= q[b + k * nmax] * s;
+                }
+            }
+        }
+        double nrm{0};
+        for (int b = 0; b < n__; b++) {
+            for (int d = 0; d < n__; d++) {
+                nrm += std::real(conj_val(v[b]) * o__[b + d * n__] * v[d]);
+            }
+        }
+        if (nrm > 1e-12 * std::abs(o__[a + a * n__])) {
+            for (int b = 0; b < n__; b++) {
+                q[b + m * nmax] = v[b] / std::sqrt(nrm);
+            }
+            m++;
+        }
+    }
+
+    /* Hamiltonian in the orthonormal basis */
+    T hq[nmax * nmax];
+    for (int k = 0; k < m; k++) {
+        for (int l = 0; l < m; l++) {
+            T s{0};
+            for (int b = 0; b < n__; b++) {
+                for (int d = 0; d < n__; d++) {
+                    s += conj_val(q[b + k * nmax]) * h__[b + d * n__] * q[d + l * nmax];
+                }
+            }
+            hq[k + l * nmax] = s;
+        }
+    }
+
+    double w[nmax];
+    ftn_int ld{nmax};
+    ftn_int lwork{64};
+    ftn_int info;
+    T work[64];
+    if (std::is_same<T, double_complex>::value) {
+        double rwork[3 * nmax];
+        FORTRAN(zheev)("V", "U", &m, reinterpret_cast<double_complex*>(hq), &ld, w,
+                       reinterpret_cast<double_complex*>(work), &lwork, rwork, &info, (ftn_len)1, (ftn_len)1);
+    } else {
+        FORTRAN(dsyev)("V", "U", &m, reinterpret_cast<double*>(hq), &ld, w, reinterpret_cast<double*>(work), &lwork,
+                       &info, (ftn_len)1, (ftn_len)1);
+    }
+    if (info) {
+        std::stringstream s;
+        s << "error in the diagonalization of the " << m << " x " << m << " matrix, info = " << info;
+        TERMINATE(s);
+    }
+
+    for (int b = 0; b < n__; b++) {
+        c__[b] = 0;
+        for (int k = 0; k < m; k++) {
+            c__[b] += q[b + k * nmax] * hq[k];
+        }
+    }
+    return w[0];
+}
+
+template <typename T>
+inline int Band::diag_pseudo_potential_ppcg(K_point*     kp__,
+                                            Hamiltonian& H__) const
+{
+    PROFILE("sirius::Band::diag_pseudo_potential_ppcg");
+
+    auto pu = ctx_.processing_unit();
+
+    /* the band-by-band updates of the wave-functions are done on the host */
+    if (pu == GPU) {
+        TERMINATE_NOT_IMPLEMENTED
+    }
+
+    auto& itso = ctx_.iterative_solver_input();
+
+    bool converge_by_energy = (itso.converge_by_energy_ == 1);
+
+    auto ortho_method = get_ortho_method_t(itso.ortho_method_);
+
+    /* S operator is the identity if none of the atom types is augmented */
+    bool s_is_one{true};
+    for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
+        if (ctx_.unit_cell().atom_type(iat).augment()) {
+            s_is_one = false;
+        }
+    }
+
+    /* true if this is a non-collinear case */
+    const bool nc_mag = (ctx_.num_mag_dims() == 3);
+
+    /* number of spin components, treated simultaneously */
+    const int num_sc = nc_mag ? 2 : 1;
+
+    /* short notation for number of target wave-functions */
+    const int num_bands = ctx_.num_bands();
+
+    /* short notation for target wave-functions */
+    auto& psi = kp__->spinor_wave_functions();
+
+    /* X, W and P blocks */
+    const int num_phi = 3 * num_bands;
+
+    if (num_phi > kp__->num_gkvec()) {
+        std::stringstream s;
+        s << "subspace size is too large!";
+        TERMINATE(s);
+    }
+
+    utils::timer t1("sirius::Band::diag_pseudo_potential_ppcg|wf");
+
+    /* total memory size of all wave-functions */
+    const size_t size = num_sc * kp__->num_gkvec_loc() * (3 * num_phi + 3 * num_bands);
+    /* get preallocatd memory buffer */
+    double_complex* mem_buf_ptr = ctx_.mem_pool().allocate<double_complex, memory_t::host>(size);
+
+    /* current approximation X to the wave-functions in the columns [0, num_bands), preconditioned residuals W
+     * in the columns [num_bands, 2 * num_bands) and search directions P in the columns [2 * num_bands, num_phi) */
+    Wave_functions phi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
+    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+
+    /* Hamiltonian, applied to X, W and P */
+    Wave_functions hphi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
+    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+
+    /* S operator, applied to X, W and P */
+    Wave_functions sphi(mem_buf_ptr, kp__->gkvec_partition(), num_phi, num_sc);
+    mem_buf_ptr += kp__->num_gkvec_loc() * num_phi * num_sc;
+
+    /* temporary storage for the rotation of X and P */
+    Wave_functions hpsi(mem_buf_ptr, kp__->gkvec_partition(), num_bands, num_sc);
+    mem_buf_ptr += kp__->num_gkvec_loc() * num_bands * num_sc;
+
+    Wave_functions spsi(mem_buf_ptr, kp__->gkvec_partition(), num_bands, num_sc);
+    mem_buf_ptr += kp__->num_gkvec_loc() * num_bands * num_sc;
+
+    /* residuals */
+    Wave_functions res(mem_buf_ptr, kp__->gkvec_partition(), num_bands, num_sc);
+    t1.stop();
+
+    auto mem_type = (ctx_.std_evp_solver_type() == ev_solver_t::magma) ? memory_t::host_pinned : memory_t::host;
+
+    const int bs = ctx_.cyclic_block_size();
+
+    dmatrix<T> hmlt(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
+    dmatrix<T> ovlp(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
+    dmatrix<T> evec(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
+    dmatrix<T> hmlt_old;
+
+    kp__->beta_projectors().prepare();
+
+    /* get diagonal elements for preconditioning */
+    auto h_diag = H__.get_h_diag<T>(kp__);
+    auto o_diag = H__.get_o_diag<T>(kp__);
+
+    auto std_solver = ctx_.std_evp_solver<T>();
+
+    int niter{0};
+
+    utils::timer t3("sirius::Band::diag_pseudo_potential_ppcg|iter");
+    for (int ispin_step = 0; ispin_step < ctx_.num_spin_dims(); ispin_step++) {
+
+        /* spin index of the operators and of the auxiliary wave-functions */
+        const int ispn_op = nc_mag ? 2 : ispin_step;
+
+        std::vector<double> eval(num_bands);
+        std::vector<double> eval_old(num_bands, 1e100);
+
+        if (itso.init_eval_old_) {
+            for (int j = 0; j < num_bands; j++) {
+                eval_old[j] = kp__->band_energy(j, ispin_step);
+            }
+        }
+
+        /* S-orthonormalize X; H and S applied to X are transformed together with X */
+        auto ortho_x = [&]()
+        {
+            if (s_is_one) {
+                orthogonalize<T, 0, 0>(pu, nc_mag ? 2 : 0, {&phi, &hphi, &sphi}, 0, num_bands, ovlp, res, ortho_method);
+            } else {
+                orthogonalize<T>(pu, nc_mag ? 2 : 0, phi, hphi, sphi, 0, num_bands, ovlp, res, ortho_method);
+            }
+        };
+
+        /* full Rayleigh-Ritz step in the subspace of X; the search directions are rotated together with X */
+        auto rayleigh_ritz = [&](bool rotate_p__)
+        {
+            set_subspace_mtrx(0, num_bands, phi, hphi, hmlt, hmlt_old);
+
+            utils::timer t1("sirius::Band::diag_pseudo_potential_ppcg|evp");
+            if (std_solver->solve(num_bands, num_bands, hmlt, eval.data(), evec)) {
+                std::stringstream s;
+                s << "error in diagonalziation";
+                TERMINATE(s);
+            }
+            t1.stop();
+
+            evp_work_count() += 1;
+
+            for (int i0: {0, 2 * num_bands}) {
+                if (i0 && !rotate_p__) {
+                    continue;
+                }
+                transform<T>(pu, ispn_op, {&phi, &hphi, &sphi}, i0, num_bands, evec, 0, 0, {&res, &hpsi, &spsi}, 0,
+                             num_bands);
+                for (int ispn = 0; ispn < num_sc; ispn++) {
+                    phi.copy_from(pu, num_bands, res, ispn, 0, ispn, i0);
+                    hphi.copy_from(pu, num_bands, hpsi, ispn, 0, ispn, i0);
+                    sphi.copy_from(pu, num_bands, spsi, ispn, 0, ispn, i0);
+                }
+            }
+        };
+
+        /* initial X */
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            phi.copy_from(pu, num_bands, psi, nc_mag ? ispn : ispin_step, 0, ispn, 0);
+        }
+        H__.apply_h_s<T>(kp__, ispn_op, 0, num_bands, phi, &hphi, &sphi);
+        ortho_x();
+        rayleigh_ritz(false);
+
+        /* no search directions at the first step */
+        phi.zero(pu, ispn_op, 2 * num_bands, num_bands);
+        hphi.zero(pu, ispn_op, 2 * num_bands, num_bands);
+        sphi.zero(pu, ispn_op, 2 * num_bands, num_bands);
+
+        for (int k = 0; k < itso.num_steps_; k++) {
+            /* Theta = X^{H} H X; eigen-values are estimated by its diagonal between the Rayleigh-Ritz steps */
+            inner(pu, nc_mag ? 2 : 0, phi, 0, num_bands, hphi, 0, num_bands, hmlt, 0, 0);
+            auto theta = hmlt.get_diag(num_bands);
+            for (int j = 0; j < num_bands; j++) {
+                eval[j] = std::real(theta[j]);
+            }
+
+            /* residuals R = HX - SX Theta */
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                res.copy_from(pu, num_bands, hphi, ispn, 0, ispn, 0);
+            }
+            transform<T>(pu, ispn_op, -1.0, std::vector<Wave_functions*>({&sphi}), 0, num_bands, hmlt, 0, 0, 1.0,
+                         {&res}, 0, num_bands);
+            auto res_norm = res.l2norm(pu, ispn_op, num_bands);
+
+            /* soft locking: converged bands are not updated */
+            std::vector<int> act;
+            for (int j = 0; j < num_bands; j++) {
+                bool conv = res_norm[j] <= itso.residual_tolerance_;
+                if (converge_by_energy) {
+                    double o1 = std::abs(kp__->band_occupancy(j, nc_mag ? 0 : ispin_step) / ctx_.max_occupancy());
+                    double o2 = std::abs(1 - o1);
+                    double tol = o1 * itso.energy_tolerance_ + o2 * (itso.energy_tolerance_ +
+                                                                     itso.empty_states_tolerance_);
+                    conv = conv || (std::abs(eval[j] - eval_old[j]) <= tol);
+                }
+                if (!conv) {
+                    act.push_back(j);
+                }
+            }
+            int n = static_cast<int>(act.size());
+
+            if (ctx_.control().verbosity_ >= 3 && kp__->comm().rank() == 0) {
+                printf("number of residuals : %i\n", n);
+            }
+
+            if (n <= itso.min_num_res_ || k == itso.num_steps_ - 1) {
+                break;
+            }
+
+            /* eigen-value estimates of the bands before the update; on the first step eval_old keeps the band
+             * energies of the previous SCF iteration (or the large initial value), otherwise all bands would look
+             * converged right after the initial Rayleigh-Ritz step */
+            eval_old = eval;
+
+            utils::timer t2("sirius::Band::diag_pseudo_potential_ppcg|w");
+            /* preconditioned and normalized residuals of the active bands */
+            mdarray<double, 1> eval_act(n);
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                for (int j = 0; j < n; j++) {
+                    if (act[j] != j) {
+                        res.copy_from(pu, 1, res, ispn, act[j], ispn, j);
+                    }
+                }
+            }
+            for (int j = 0; j < n; j++) {
+                eval_act[j] = eval[act[j]];
+            }
+            apply_p(pu, ispn_op, n, res, h_diag, o_diag, eval_act);
+            auto p_norm = res.l2norm(pu, ispn_op, n);
+            for (int j = 0; j < n; j++) {
+                p_norm[j] = 1.0 / p_norm[j];
+            }
+            normalize_res(pu, ispn_op, n, res, p_norm);
+
+            /* prevent numerical noise in the Gamma-point case */
+            if (std::is_same<T, double>::value && kp__->comm().rank() == 0) {
+                for (int j = 0; j < n; j++) {
+                    res.pw_coeffs(0).prime(0, j) = res.pw_coeffs(0).prime(0, j).real();
+                }
+            }
+
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                phi.copy_from(pu, n, res, ispn, 0, ispn, num_bands);
+            }
+
+            /* W = W - X (SX)^{H} W */
+            inner(pu, nc_mag ? 2 : 0, sphi, 0, num_bands, phi, num_bands, n, ovlp, 0, 0);
+            transform<T>(pu, ispn_op, -1.0, std::vector<Wave_functions*>({&phi}), 0, num_bands, ovlp, 0, 0, 1.0,
+                         {&phi}, num_bands, n);
+
+            /* apply Hamiltonian and S operators to W */
+            H__.apply_h_s<T>(kp__, ispn_op, num_bands, n, phi, &hphi, &sphi);
+
+            /* P = P - X (SX)^{H} P */
+            if (k > 0) {
+                inner(pu, nc_mag ? 2 : 0, sphi, 0, num_bands, phi, 2 * num_bands, num_bands, ovlp, 0, 0);
+                transform<T>(pu, ispn_op, -1.0, std::vector<Wave_functions*>({&phi, &hphi, &sphi}), 0, num_bands,
+                             ovlp, 0, 0, 1.0, {&phi, &hphi, &sphi}, 2 * num_bands, num_bands);
+            }
+            t2.stop();
+
+            utils::timer t4("sirius::Band::diag_pseudo_potential_ppcg|update");
+            /* Hamiltonian and overlap matrices in the basis {x_i, w_i, p_i} of each active band */
+            mdarray<T, 4> ho(3, 3, 2, n);
+            #pragma omp parallel for schedule(static)
+            for (int j = 0; j < n; j++) {
+                int col[] = {act[j], num_bands + j, 2 * num_bands + act[j]};
+                for (int a = 0; a < 3; a++) {
+                    for (int b = a; b < 3; b++) {
+                        ho(a, b, 0, j) = inner_local<T>(ispn_op, phi, col[a], hphi, col[b]);
+                        ho(a, b, 1, j) = inner_local<T>(ispn_op, phi, col[a], sphi, col[b]);
+                    }
+                }
+            }
+            phi.comm().allreduce(ho.template at<CPU>(), static_cast<int>(ho.size()));
+
+            /* X = X c_x + W c_w + P c_p, P = W c_w + P c_p */
+            mdarray<T, 2> c(3, n);
+            #pragma omp parallel for schedule(static)
+            for (int j = 0; j < n; j++) {
+                for (int a = 0; a < 3; a++) {
+                    for (int b = 0; b < a; b++) {
+                        ho(a, b, 0, j) = conj_val(ho(b, a, 0, j));
+                        ho(a, b, 1, j) = conj_val(ho(b, a, 1, j));
+                    }
+                }
+                small_rayleigh_ritz<T>(3, &ho(0, 0, 0, j), &ho(0, 0, 1, j), &c(0, j));
+
+                int i = act[j];
+                for (auto wf: {&phi, &hphi, &sphi}) {
+                    for (int ispn = 0; ispn < num_sc; ispn++) {
+                        auto& z = wf->pw_coeffs(ispn).prime();
+                        for (int ig = 0; ig < wf->pw_coeffs(ispn).num_rows_loc(); ig++) {
+                            auto p = c(1, j) * z(ig, num_bands + j) + c(2, j) * z(ig, 2 * num_bands + i);
+                            z(ig, i) = c(0, j) * z(ig, i) + p;
+                            z(ig, 2 * num_bands + i) = p;
+                        }
+                    }
+                }
+            }
+            t4.stop();
+
+            /* restore the orthonormality of X */
+            ortho_x();
+
+            /* full Rayleigh-Ritz step every few iterations */
+            if (itso.rr_period_ > 0 && (k + 1) % itso.rr_period_ == 0) {
+                rayleigh_ritz(true);
+            }
+
+            if (ctx_.control().verbosity_ >= 2 && kp__->comm().rank() == 0) {
+                printf("step: %i, number of active bands: %i\n", k, n);
+            }
+            niter++;
+        }
+
+        /* final Rayleigh-Ritz step gives the eigen-vectors and eigen-values */
+        rayleigh_ritz(false);
+
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            psi.copy_from(pu, num_bands, phi, ispn, 0, nc_mag ? ispn : ispin_step, 0);
+        }
+        for (int j = 0; j < num_bands; j++) {
+            kp__->band_energy(j, ispin_step) = eval[j];
+        }
+        if (ctx_.control().verbosity_ >= 4 && kp__->comm().rank() == 0) {
+            for (int i = 0; i < num_bands; i++) {
+                printf("eval[%i]=%20.16f\n", i, eval[i]);
+            }
+        }
+    } /* loop over ispin_step */
+    t3.stop();
+
+    kp__->beta_projectors().dismiss();
+
+    ctx_.mem_pool().reset<memory_t::host>();
+
+    return niter;
+}
+
 template <typename T>
 inline void Band::diag_pseudo_potential_chebyshev(K_point* kp__,
                                                   int ispn__,
@@ -56,11 +56,15 @@ inline void Band::initialize_subspace(K_point_set& kset__, Hamiltonian& H__) con
     for (int ikloc = 0; ikloc < kset__.spl_num_kpoints().local_size(); ikloc++) {
         int ik  = kset__.spl_num_kpoints(ikloc);
         auto kp = kset__[ik];
+        /* read wave-functions of the next k-point from the out-of-core store while this one is processed;
+           the wave-functions are modified here */
+        kset__.prefetch_wave_functions(ikloc, true);
         if (ctx_.gamma_point() && (ctx_.so_correction() == false)) {
             initialize_subspace<double>(kp, H__, N);
         } else {
             initialize_subspace<double_complex>(kp, H__, N);
         }
+        kp->page_out_wave_functions();
     }
     H__.dismiss();
     H__.local_op().dismiss();
@@ -285,7 +285,9 @@ inline int Band::residuals(K_point*             kp__,
                            Wave_functions&      opsi__,
                            Wave_functions&      res__,
                            mdarray<double, 2>&  h_diag__,
-                           mdarray<double, 1>&  o_diag__) const
+                           mdarray<double, 1>&  o_diag__,
+                           int                  num_locked__,
+                           std::vector<bool>*   converged__) const
 {
     PROFILE("sirius::Band::residuals");
 
@@ -294,6 +296,13 @@ inline int Band::residuals(K_point*             kp__,
     auto& itso = ctx_.iterative_solver_input();
     bool converge_by_energy = (itso.converge_by_energy_ == 1);
 
+    /* index of the first active band */
+    int nl = num_locked__;
+
+    if (converged__) {
+        converged__->assign(num_bands__, true);
+    }
+
     int n{0};
     if (converge_by_energy) {
 
@@ -303,11 +312,11 @@ inline int Band::residuals(K_point*             kp__,
             std::vector<int> ev_idx;
             int s = ispn__ == 2 ? 0 : ispn__;
             for (int i = 0; i < num_bands__; i++) {
-                double o1 = std::abs(kp__->band_occupancy(i, s) / ctx_.max_occupancy());
+                double o1 = std::abs(kp__->band_occupancy(nl + i, s) / ctx_.max_occupancy());
                 double o2 = std::abs(1 - o1);
 
                 double tol = o1 * tol__ + o2 * (tol__ + itso.empty_states_tolerance_);
-                if (std::abs(eval__[i] - eval_old__[i]) > tol) {
+                if (std::abs(eval__[nl + i] - eval_old__[nl + i]) > tol) {
                     ev_idx.push_back(i);
                 }
             }
@@ -325,7 +334,7 @@ inline int Band::residuals(K_point*             kp__,
             dmatrix<T> evec_tmp(N__, n, ctx_.blacs_grid(), bs, bs);
             int num_rows_local = evec_tmp.num_rows_local();
             for (int j = 0; j < n; j++) {
-                eval_tmp[j] = eval__[ev_idx[j]];
+                eval_tmp[j] = eval__[nl + ev_idx[j]];
                 if (ctx_.blacs_grid().comm().size() == 1) {
                     /* do a local copy */
                     std::copy(&evec__(0, ev_idx[j]), &evec__(0, ev_idx[j]) + num_rows_local, &evec_tmp(0, j));
@@ -345,7 +354,7 @@ inline int Band::residuals(K_point*             kp__,
                 evec_tmp.allocate(memory_t::device);
             }
             /* compute H\Psi_{i} = \sum_{mu} H\phi_{mu} * Z_{mu, i} and O\Psi_{i} = \sum_{mu} O\phi_{mu} * Z_{mu, i} */
-            transform<T>(ctx_.processing_unit(), ispn__, {&hphi__, &ophi__}, 0, N__, evec_tmp, 0, 0, {&hpsi__, &opsi__}, 0, n);
+            transform<T>(ctx_.processing_unit(), ispn__, {&hphi__, &ophi__}, nl, N__, evec_tmp, 0, 0, {&hpsi__, &opsi__}, 0, n);
 
             auto res_norm = residuals_aux(kp__, ispn__, n, eval_tmp, hpsi__, opsi__, res__, h_diag__, o_diag__);
 
@@ -354,6 +363,9 @@ inline int Band::residuals(K_point*             kp__,
             for (int i = 0; i < nmax; i++) {
                 /* take the residual if it's norm is above the threshold */
                 if (res_norm[i] > itso.residual_tolerance_) {
+                    if (converged__) {
+                        (*converged__)[ev_idx[i]] = false;
+                    }
                     /* shift unconverged residuals to the beginning of array */
                     if (n != i) {
                         int s0{0}, s1{1};
@@ -373,15 +385,19 @@ inline int Band::residuals(K_point*             kp__,
         }
     } else {
         /* compute H\Psi_{i} = \sum_{mu} H\phi_{mu} * Z_{mu, i} and O\Psi_{i} = \sum_{mu} O\phi_{mu} * Z_{mu, i} */
-        transform<T>(ctx_.processing_unit(), ispn__, {&hphi__, &ophi__}, 0, N__, evec__, 0, 0, {&hpsi__, &opsi__}, 0, num_bands__);
+        transform<T>(ctx_.processing_unit(), ispn__, {&hphi__, &ophi__}, nl, N__, evec__, 0, 0, {&hpsi__, &opsi__}, 0, num_bands__);
 
-        auto res_norm = residuals_aux(kp__, ispn__, num_bands__, eval__, hpsi__, opsi__, res__, h_diag__, o_diag__);
+        std::vector<double> eval_act(eval__.begin() + nl, eval__.begin() + nl + num_bands__);
+        auto res_norm = residuals_aux(kp__, ispn__, num_bands__, eval_act, hpsi__, opsi__, res__, h_diag__, o_diag__);
 
         for (int i = 0; i < num_bands__; i++) {
             //int s = ispn__ == 2 ? 0 : ispn__;
             double tol = itso.residual_tolerance_;// + 1e-3 * std::abs(kp__->band_occupancy(i + s * ctx_.num_fv_states()) / ctx_.max_occupancy() - 1);
             /* take the residual if its norm is above the threshold */
             if (res_norm[i] > tol) {
+                if (converged__) {
+                    (*converged__)[i] = false;
+                }
                 /* shift unconverged residuals to the beginning of array */
                 if (n != i) {
                     int s0{0}, s1{1};
@@ -28,7 +28,8 @@ inline void Band::set_subspace_mtrx(int N__,
                                     Wave_functions& phi__,
                                     Wave_functions& op_phi__,
                                     dmatrix<T>& mtrx__,
-                                    dmatrix<T>& mtrx_old__) const
+                                    dmatrix<T>& mtrx_old__,
+                                    int N0__) const
 {
     PROFILE("sirius::Band::set_subspace_mtrx");
 
@@ -38,7 +39,7 @@ inline void Band::set_subspace_mtrx(int N__,
     }
 
     /* copy old N x N distributed matrix */
-    if (N__ > 0) {
+    if (N__ > 0 && mtrx_old__.size()) {
         splindex<block_cyclic> spl_row(N__, mtrx__.blacs_grid().num_ranks_row(), mtrx__.blacs_grid().rank_row(),
                                        mtrx__.bs_row());
         splindex<block_cyclic> spl_col(N__, mtrx__.blacs_grid().num_ranks_col(), mtrx__.blacs_grid().rank_col(),
@@ -63,9 +64,14 @@ inline void Band::set_subspace_mtrx(int N__,
         }
     }
 
-    /* <{phi,phi_new}|Op|phi_new> */
-    inner(ctx_.processing_unit(), (ctx_.num_mag_dims() == 3) ? 2 : 0, phi__, 0, N__ + n__, op_phi__, N__, n__,
-          mtrx__, 0, N__);
+    /* <phi|Op|phi_new> */
+    if (N__ > 0) {
+        inner(ctx_.processing_unit(), (ctx_.num_mag_dims() == 3) ? 2 : 0, phi__, N0__, N__, op_phi__, N0__ + N__, n__,
+              mtrx__, 0, N__);
+    }
+    /* <phi_new|Op|phi_new> is Hermitian */
+    inner_herm(ctx_.processing_unit(), (ctx_.num_mag_dims() == 3) ? 2 : 0, phi__, N0__ + N__, op_phi__, N0__ + N__,
+               n__, mtrx__, N__, N__);
 
     /* restore lower part */
     if (N__ > 0) {
@@ -63,6 +63,10 @@ inline int Band::solve_pseudo_potential(K_point& kp__, Hamiltonian& hamiltonian_
         }
     } else if (itso.type_ == "davidson") {
         niter = diag_pseudo_potential_davidson<T>(&kp__, hamiltonian__);
+    } else if (itso.type_ == "lobpcg") {
+        niter = diag_pseudo_potential_lobpcg<T>(&kp__, hamiltonian__);
+    } else if (itso.type_ == "ppcg") {
+        niter = diag_pseudo_potential_ppcg<T>(&kp__, hamiltonian__);
     } else if (itso.type_ == "rmm-diis") {
         if (ctx_.num_mag_dims() != 3) {
             for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
@@ -126,6 +130,10 @@ inline void Band::solve(K_point_set& kset__, Hamiltonian& hamiltonian__, bool pr
         int ik  = kset__.spl_num_kpoints(ikloc);
         auto kp = kset__[ik];
 
+        /* read wave-functions of the next k-point from the out-of-core store while this one is processed;
+           the wave-functions are modified here */
+        kset__.prefetch_wave_functions(ikloc, true);
+
         if (ctx_.full_potential()) {
             solve_full_potential(*kp, hamiltonian__);
         } else {
@@ -135,6 +143,8 @@ inline void Band::solve(K_point_set& kset__, Hamiltonian& hamiltonian__, bool pr
                 num_dav_iter += solve_pseudo_potential<double_complex>(*kp, hamiltonian__);
             }
         }
+
+        kp->page_out_wave_functions();
     }
     kset__.comm().allreduce(&num_dav_iter, 1);
     if (ctx_.comm().rank() == 0 && !ctx_.full_potential() && ctx_.control().verbosity_ >= 1) {
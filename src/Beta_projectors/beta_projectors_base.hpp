@@ -76,6 +76,13 @@ class Beta_projectors_base
     /// Coordinates of G+k vectors used by GPU kernel.
     mdarray<double, 2> gkvec_coord_;
 
+    /// Integer coordinates of the G-vector part of the local G+k vectors.
+    /** Element (igk_loc, x) is the x-th coordinate; each coordinate is stored contiguously. */
+    mdarray<int, 2> gvec_loc_;
+
+    /// Real and imaginary parts of the phase factors of the local G+k vectors for one atom.
+    mdarray<double, 2> phase_gk_;
+
     /// Phase-factor independent coefficients of |beta> functions for atom types.
     std::array<matrix<double_complex>, N> pw_coeffs_t_;
 
@@ -83,6 +90,14 @@ class Beta_projectors_base
 
     matrix<double_complex> pw_coeffs_a_;
 
+    /// Plane-wave coefficients of the cached chunks of beta-projectors.
+    /** Element ichunk * N + j holds the result of generate(ichunk, j); chunks which don't fit into the memory
+     *  budget have empty matrices. The cache is allocated in prepare() and released in dismiss(). */
+    std::vector<matrix<double_complex>> pw_coeffs_a_cache_;
+
+    /// True if the corresponding element of pw_coeffs_a_cache_ is already generated.
+    std::vector<bool> pw_coeffs_a_cached_;
+
     std::vector<beta_chunk_t> beta_chunks_;
 
     int max_num_beta_;
@@ -199,6 +214,17 @@ class Beta_projectors_base
             pw_coeffs_t_[i] = matrix<double_complex>(num_gkvec_loc(), num_beta_t(), memory_t::host, "pw_coeffs_t_");
         }
 
+        if (ctx_.processing_unit() == CPU) {
+            gvec_loc_ = mdarray<int, 2>(num_gkvec_loc(), 3, memory_t::host, "gvec_loc_");
+            for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+                auto G = gkvec_.gvec(igk_[igk_loc]);
+                for (int x: {0, 1, 2}) {
+                    gvec_loc_(igk_loc, x) = G[x];
+                }
+            }
+            phase_gk_ = mdarray<double, 2>(num_gkvec_loc(), 2, memory_t::host, "phase_gk_");
+        }
+
         if (ctx_.processing_unit() == GPU) {
             gkvec_coord_ = mdarray<double, 2>(3, num_gkvec_loc(), ctx__.dual_memory_t());
             /* copy G+k vectors */
@@ -363,27 +389,78 @@ class Beta_projectors_base
     {
         PROFILE("sirius::Beta_projectors_base::generate");
 
+        /* chunks which fit into the memory budget are generated once and then taken from the cache */
+        if (ctx_.processing_unit() == CPU && !pw_coeffs_a_cache_.empty()) {
+            int idx = ichunk__ * N + j__;
+            if (pw_coeffs_a_cache_[idx].size()) {
+                pw_coeffs_a_ = matrix<double_complex>(pw_coeffs_a_cache_[idx].template at<CPU>(), num_gkvec_loc(),
+                                                      chunk(ichunk__).num_beta_);
+                if (pw_coeffs_a_cached_[idx]) {
+                    return;
+                }
+                pw_coeffs_a_cached_[idx] = true;
+            } else {
+                /* previous chunk might have been taken from the cache */
+                auto& buf = pw_coeffs_a_shared(num_gkvec_loc() * max_num_beta(), ctx_.dual_memory_t());
+                pw_coeffs_a_ = matrix<double_complex>(buf.template at<CPU>(), num_gkvec_loc(), max_num_beta());
+            }
+        }
+
         auto& pw_coeffs = pw_coeffs_a();
 
         switch (ctx_.processing_unit()) {
             case CPU: {
-                #pragma omp for
-                for (int i = 0; i < chunk(ichunk__).num_atoms_; i++) {
-                    int ia = chunk(ichunk__).desc_(beta_desc_idx::ia, i);
-
-                    double phase = twopi * dot(gkvec_.vk(), ctx_.unit_cell().atom(ia).position());
-                    double_complex phase_k = std::exp(double_complex(0.0, phase));
-
-                    std::vector<double_complex> phase_gk(num_gkvec_loc());
-                    for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
-                        auto G = gkvec_.gvec(igk_[igk_loc]);
-                        /* total phase e^{i(G+k)r_{\alpha}} */
-                        phase_gk[igk_loc] = std::conj(ctx_.gvec_phase_factor(G, ia) * phase_k);
-                    }
-                    for (int xi = 0; xi < chunk(ichunk__).desc_(beta_desc_idx::nbf, i); xi++) {
-                        for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
-                            pw_coeffs(igk_loc, chunk(ichunk__).desc_(beta_desc_idx::offset, i) + xi) = 
-                                pw_coeffs_t_[j__](igk_loc, chunk(ichunk__).desc_(beta_desc_idx::offset_t, i) + xi) * phase_gk[igk_loc];
+                auto& desc = chunk(ichunk__).desc_;
+                #pragma omp parallel
+                {
+                    /* each thread generates its own range of G+k vectors for all atoms of the chunk */
+                    splindex<block> spl_gk_t(num_gkvec_loc(), omp_get_num_threads(), omp_get_thread_num());
+                    int g0 = spl_gk_t.global_offset();
+                    int g1 = g0 + spl_gk_t.local_size();
+
+                    int const* gx = gvec_loc_.template at<CPU>(0, 0);
+                    int const* gy = gvec_loc_.template at<CPU>(0, 1);
+                    int const* gz = gvec_loc_.template at<CPU>(0, 2);
+                    double* ph_re = phase_gk_.template at<CPU>(0, 0);
+                    double* ph_im = phase_gk_.template at<CPU>(0, 1);
+
+                    for (int i = 0; i < chunk(ichunk__).num_atoms_; i++) {
+                        int ia = desc(beta_desc_idx::ia, i);
+
+                        double phase = twopi * dot(gkvec_.vk(), ctx_.unit_cell().atom(ia).position());
+                        double kr = std::cos(phase);
+                        double ki = std::sin(phase);
+
+                        /* real and imaginary parts of e^{i G_x r_{x}} are stored at pf[2 * (x + 3 * G_x)] */
+                        auto pf = reinterpret_cast<double const*>(&ctx_.phase_factors()(0, 0, ia));
+
+                        #pragma omp simd
+                        for (int igk_loc = g0; igk_loc < g1; igk_loc++) {
+                            int ox = 2 * (3 * gx[igk_loc]);
+                            int oy = 2 * (1 + 3 * gy[igk_loc]);
+                            int oz = 2 * (2 + 3 * gz[igk_loc]);
+                            /* e^{i G_x x} * e^{i G_y y} */
+                            double ar = pf[ox] * pf[oy] - pf[ox + 1] * pf[oy + 1];
+                            double ai = pf[ox] * pf[oy + 1] + pf[ox + 1] * pf[oy];
+                            /* e^{i G r} */
+                            double zr = ar * pf[oz] - ai * pf[oz + 1];
+                            double zi = ar * pf[oz + 1] + ai * pf[oz];
+                            /* conjugated total phase e^{i(G+k)r_{\alpha}} */
+                            ph_re[igk_loc] = zr * kr - zi * ki;
+                            ph_im[igk_loc] = -(zr * ki + zi * kr);
+                        }
+                        for (int xi = 0; xi < desc(beta_desc_idx::nbf, i); xi++) {
+                            auto in = reinterpret_cast<double const*>(
+                                pw_coeffs_t_[j__].template at<CPU>(0, desc(beta_desc_idx::offset_t, i) + xi));
+                            auto out = reinterpret_cast<double*>(
+                                pw_coeffs.template at<CPU>(0, desc(beta_desc_idx::offset, i) + xi));
+                            #pragma omp simd
+                            for (int igk_loc = g0; igk_loc < g1; igk_loc++) {
+                                double tr = in[2 * igk_loc];
+                                double ti = in[2 * igk_loc + 1];
+                                out[2 * igk_loc]     = tr * ph_re[igk_loc] - ti * ph_im[igk_loc];
+                                out[2 * igk_loc + 1] = tr * ph_im[igk_loc] + ti * ph_re[igk_loc];
+                            }
                         }
                     }
                 }
@@ -429,6 +506,26 @@ class Beta_projectors_base
                 pw_coeffs_t_[i].template copy<memory_t::host, memory_t::device>();
             }
         }
+
+        /* keep as many chunks as the memory budget allows */
+        if (ctx_.processing_unit() == CPU && pw_coeffs_a_cache_.empty() && ctx_.control().beta_cache_memory_mb_ > 0) {
+            size_t budget = static_cast<size_t>(ctx_.control().beta_cache_memory_mb_ * (1 << 20));
+            size_t used{0};
+            pw_coeffs_a_cache_ = std::vector<matrix<double_complex>>(num_chunks() * N);
+            pw_coeffs_a_cached_ = std::vector<bool>(num_chunks() * N, false);
+            for (int ichunk = 0; ichunk < num_chunks(); ichunk++) {
+                size_t sz = sizeof(double_complex) * num_gkvec_loc() * chunk(ichunk).num_beta_;
+                for (int j = 0; j < N; j++) {
+                    if (used + sz <= budget) {
+                        pw_coeffs_a_cache_[ichunk * N + j] = matrix<double_complex>(num_gkvec_loc(),
+                                                                                    chunk(ichunk).num_beta_,
+                                                                                    memory_t::host,
+                                                                                    "pw_coeffs_a_cache_");
+                        used += sz;
+                    }
+                }
+            }
+        }
     }
 
     void dismiss()
@@ -440,6 +537,13 @@ class Beta_projectors_base
                 pw_coeffs_t_[i].deallocate(memory_t::device);
             }
         }
+        if (!pw_coeffs_a_cache_.empty()) {
+            pw_coeffs_a_cache_.clear();
+            pw_coeffs_a_cached_.clear();
+            /* don't leave a pointer to the released cache */
+            auto& buf = pw_coeffs_a_shared(num_gkvec_loc() * max_num_beta(), ctx_.dual_memory_t());
+            pw_coeffs_a_ = matrix<double_complex>(buf.template at<CPU>(), num_gkvec_loc(), max_num_beta());
+        }
     }
 
     static void cleanup()
@@ -0,0 +1,484 @@
+// Copyright (c) 2013-2018 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file beta_projectors_rs.hpp
+ *
+ *  \brief Contains declaration and implementation of sirius::Beta_projectors_rs class.
+ */
+
+#ifndef __BETA_PROJECTORS_RS_HPP__
+#define __BETA_PROJECTORS_RS_HPP__
+
+#include <algorithm>
+#include "simulation_context.h"
+
+namespace sirius {
+
+/// Beta-projectors tabulated on the coarse FFT grid inside the projector spheres of atoms.
+/** For each atom the projectors are stored at the points of the local part of the coarse FFT grid for which
+ *  \f$ |{\bf r} + {\bf T} - {\bf r}_{\alpha}| < R_{\beta} \f$ together with the Bloch phase factor:
+ *  \f[
+ *    b_{\xi}^{\alpha}({\bf r}) = \beta_{\xi}({\bf r} + {\bf T} - {\bf r}_{\alpha}) e^{-i{\bf k}({\bf r} + {\bf T})}
+ *  \f]
+ *  With this the projections and the action of the non-local operators are computed directly on \f$ \phi({\bf r}) \f$:
+ *  \f[
+ *    \langle \beta_{\xi}^{\alpha} | \phi \rangle = \frac{\sqrt{\Omega}}{N} \sum_{\bf r} b_{\xi}^{\alpha *}({\bf r})
+ *      \phi({\bf r}) \quad \quad
+ *    f({\bf r}) \mathrel{+}= \sqrt{\Omega} \sum_{\xi} b_{\xi}^{\alpha}({\bf r}) c_{\xi}^{\alpha}
+ *  \f]
+ *  where \f$ \phi({\bf r}) \f$ is the output of the forward transformation of the plane-wave coefficients and
+ *  \f$ f({\bf r}) \f$ is the input of the backward (normalized) transformation. Storage and cost are proportional
+ *  to the number of atoms instead of the number of atoms times the number of G+k vectors.
+ *
+ *  The grid sums reproduce the plane-wave result if the Fourier components of the tabulated projectors are equal
+ *  to \f$ \beta_{\xi}({\bf G+k}) \f$ inside the G+k sphere and vanish for the wave-vectors which are aliased
+ *  onto this sphere. The coarse grid holds the sphere of radius \f$ 2 G_{k} \f$, so its reciprocal period is
+ *  larger than \f$ 4 G_{k} \f$ and the aliasing starts at \f$ 3 G_{k} \f$. The radial functions are filtered
+ *  in reciprocal space as in King-Smith, Payne and Lin, PRB 44, 13063 (1991):
+ *  \f[
+ *    \tilde \beta_{\ell}(r) = \frac{2}{\pi} \int_{0}^{3 G_{k}} \beta_{\ell}(q) f(q) j_{\ell}(qr) q^2 dq
+ *  \f]
+ *  where \f$ \beta_{\ell}(q) \f$ is the radial integral of the plane-wave projectors and \f$ f(q) \f$ is a
+ *  smooth step which is one for \f$ q < G_{k} \f$ and zero for \f$ q > 3 G_{k} \f$. The filtered functions
+ *  are truncated at the radius beyond which they are negligible; this radius is larger than the radius of the
+ *  original projectors.
+ */
+class Beta_projectors_rs
+{
+  private:
+
+    Simulation_context const& ctx_;
+
+    FFT3D const& fft_;
+
+    /// Indices of the local FFT grid points inside the projector sphere of each atom (sorted).
+    std::vector<std::vector<int>> idx_;
+
+    /// Extended coordinates of the FFT grid points inside the projector sphere of each atom.
+    /** The coordinates are not folded to the unit cell; the difference with the folded coordinates gives the
+     *  lattice translation T. */
+    std::vector<std::vector<vector3d<int>>> coord_;
+
+    /// Tabulated projectors for each atom.
+    std::vector<mdarray<double_complex, 2>> beta_r_;
+
+    /// Tabulated gradients of the projectors over the atomic positions for each atom.
+    std::array<std::vector<mdarray<double_complex, 2>>, 3> dbeta_r_;
+
+    /// Lattice coordinates of the k-point.
+    vector3d<double> vk_;
+
+    /// Radius of the projector sphere for each atom type.
+    std::vector<double> rcut_;
+
+    /// Filtered radial functions of the projectors for each atom type.
+    mdarray<Spline<double>, 2> beta_rf_;
+
+    /// True if the projections are real (Gamma-point case).
+    bool gamma_;
+
+    /// Relative threshold for the truncation of the filtered radial functions.
+    double rs_tol_{1e-6};
+
+    /// Step of the radial grid for the filtered radial functions.
+    double rs_step_{0.01};
+
+    /// Extent of the radial grid beyond the radius of the unfiltered projectors.
+    double rs_extent_{8};
+
+    /// Generate the filtered radial functions of the atom type and the radius of its projector sphere.
+    void generate_radial_functions(Atom_type const& type__)
+    {
+        int nrb = type__.num_beta_radial_functions();
+        if (!nrb) {
+            return;
+        }
+        int lmax = type__.indexr().lmax();
+
+        /* pass band of the filter (G+k sphere) and the beginning of the aliasing */
+        double q1 = ctx_.gk_cutoff();
+        double q2 = 3 * ctx_.gk_cutoff();
+
+        /* radius of the unfiltered projectors */
+        double r0{0};
+        for (int idxrf = 0; idxrf < nrb; idxrf++) {
+            auto& s = type__.beta_radial_function(idxrf);
+            for (int ir = s.num_points() - 1; ir >= 0; ir--) {
+                if (std::abs(s(ir)) > 1e-12) {
+                    r0 = std::max(r0, s[std::min(ir + 1, s.num_points() - 1)]);
+                    break;
+                }
+            }
+        }
+
+        /* filtered radial integrals beta(q) f(q) */
+        Radial_grid_lin<double> qgrid(static_cast<int>(ctx_.settings().nprii_beta_ * q2), 0, q2);
+        mdarray<double, 2> bq(qgrid.num_points(), nrb);
+        #pragma omp parallel for
+        for (int iq = 0; iq < qgrid.num_points(); iq++) {
+            /* smooth step: f(x) = 1 / (1 + exp(1 / (1 - x) - 1 / x)), x = (q - q1) / (q2 - q1) */
+            double x = (qgrid[iq] - q1) / (q2 - q1);
+            double f{1};
+            if (x >= 1) {
+                f = 0;
+            } else if (x > 0) {
+                f = 1.0 / (1 + std::exp(1 / (1 - x) - 1 / x));
+            }
+            Spherical_Bessel_functions jl(lmax, type__.radial_grid(), qgrid[iq]);
+            for (int idxrf = 0; idxrf < nrb; idxrf++) {
+                int l = type__.indexr(idxrf).l;
+                /* beta radial functions are stored as r * beta(r) */
+                bq(iq, idxrf) = (f == 0) ? 0 : f * sirius::inner(jl[l], type__.beta_radial_function(idxrf), 1);
+            }
+        }
+
+        /* transform back to real space on a linear grid which extends beyond the original radius */
+        Radial_grid_lin<double> rgrid(static_cast<int>((r0 + rs_extent_) / rs_step_) + 1, 0, r0 + rs_extent_);
+        for (int idxrf = 0; idxrf < nrb; idxrf++) {
+            beta_rf_(idxrf, type__.id()) = Spline<double>(rgrid);
+        }
+        #pragma omp parallel for
+        for (int ir = 0; ir < rgrid.num_points(); ir++) {
+            Spherical_Bessel_functions jl(lmax, qgrid, rgrid[ir]);
+            Spline<double> s(qgrid);
+            for (int idxrf = 0; idxrf < nrb; idxrf++) {
+                int l = type__.indexr(idxrf).l;
+                for (int iq = 0; iq < qgrid.num_points(); iq++) {
+                    s(iq) = bq(iq, idxrf) * jl[l](iq);
+                }
+                beta_rf_(idxrf, type__.id())(ir) = s.interpolate().integrate(2) * 2 / pi;
+            }
+        }
+
+        /* truncate the functions where they are smaller than the threshold */
+        double rcut{0};
+        for (int idxrf = 0; idxrf < nrb; idxrf++) {
+            auto& s = beta_rf_(idxrf, type__.id());
+            double vmax{0};
+            for (int ir = 0; ir < rgrid.num_points(); ir++) {
+                vmax = std::max(vmax, std::abs(s(ir)));
+            }
+            for (int ir = rgrid.num_points() - 1; ir >= 0; ir--) {
+                if (std::abs(s(ir)) > rs_tol_ * vmax) {
+                    rcut = std::max(rcut, rgrid[std::min(ir + 1, rgrid.num_points() - 1)]);
+                    break;
+                }
+            }
+            s.interpolate();
+        }
+        rcut_[type__.id()] = rcut;
+    }
+
+    /// Tabulate the projectors (x__ = -1) or their derivatives over the x__-th Cartesian component of the atomic position.
+    /** The derivative of \f$ \beta(|{\bf r}|) R_{\ell m}(\hat {\bf r}) \f$ with \f$ {\bf r} = {\bf r}_{j} + {\bf T}
+     *  - {\bf r}_{\alpha} \f$ over \f$ {\bf r}_{\alpha} \f$ is
+     *  \f[
+     *    -\beta'(r) \hat{\bf r} R_{\ell m}(\hat {\bf r}) - \beta(r) \nabla R_{\ell m}(\hat {\bf r})
+     *  \f]
+     */
+    void tabulate(int ia__, int x__, mdarray<double_complex, 2>& beta__) const
+    {
+        auto& uc   = ctx_.unit_cell();
+        auto& type = uc.atom(ia__).type();
+        auto pos   = uc.atom(ia__).position();
+        int nbf    = type.mt_basis_size();
+        int nrb    = type.num_beta_radial_functions();
+        int npt    = static_cast<int>(coord_[ia__].size());
+        int lmax   = type.indexr().lmax();
+        int lmmax  = utils::lmmax(lmax);
+
+        beta__ = mdarray<double_complex, 2>(npt, nbf);
+
+        std::vector<double> rlm(lmmax);
+        std::vector<double> rf(nrb);
+        std::vector<double> drf(nrb);
+        mdarray<double, 2> drlm(lmmax, 3);
+
+        for (int ip = 0; ip < npt; ip++) {
+            auto J = coord_[ia__][ip];
+            vector3d<double> vf(double(J[0]) / fft_.size(0), double(J[1]) / fft_.size(1), double(J[2]) / fft_.size(2));
+            auto vc = uc.get_cartesian_coordinates(vf - pos);
+            /* the gradient is continuous at the atom position; take it at a small distance in a general direction */
+            if (x__ >= 0 && vc.length() < 1e-10) {
+                vc = vector3d<double>(0.3, 0.5, 0.8) * 1e-10;
+            }
+            /* vs = {r, theta, phi} */
+            auto vs = SHT::spherical_coordinates(vc);
+            SHT::spherical_harmonics(lmax, vs[1], vs[2], &rlm[0]);
+            for (int idxrf = 0; idxrf < nrb; idxrf++) {
+                auto& s = beta_rf_(idxrf, type.id());
+                int ir  = s.index_of(vs[0]);
+                double dr = vs[0] - s[ir];
+                rf[idxrf] = s(ir, dr);
+                if (x__ >= 0) {
+                    drf[idxrf] = s.deriv(1, ir, dr);
+                }
+            }
+            if (x__ >= 0) {
+                SHT::dRlm_dr(lmax, vc, drlm);
+            }
+            double_complex phase = std::exp(double_complex(0, -twopi * dot(vk_, vf)));
+            for (int xi = 0; xi < nbf; xi++) {
+                int lm    = type.indexb(xi).lm;
+                int idxrf = type.indexb(xi).idxrf;
+                if (x__ < 0) {
+                    beta__(ip, xi) = phase * rf[idxrf] * rlm[lm];
+                } else {
+                    beta__(ip, xi) = -phase * (drf[idxrf] * rlm[lm] * vc[x__] / vs[0] + rf[idxrf] * drlm(lm, x__));
+                }
+            }
+        }
+    }
+
+    /// Compute the inner products of the tabulated functions with phi(r).
+    void inner(std::vector<mdarray<double_complex, 2>> const& beta__, double_complex const* phi_r__,
+               double_complex* beta_phi__) const
+    {
+        auto& uc    = ctx_.unit_cell();
+        double norm = std::sqrt(uc.omega()) / fft_.size();
+
+        #pragma omp parallel
+        {
+            std::vector<double_complex> phi_sph;
+            #pragma omp for schedule(dynamic, 1)
+            for (int ia = 0; ia < uc.num_atoms(); ia++) {
+                int nbf = uc.atom(ia).mt_basis_size();
+                int ofs = uc.atom(ia).offset_lo();
+                int npt = static_cast<int>(idx_[ia].size());
+                if (!npt) {
+                    std::fill(beta_phi__ + ofs, beta_phi__ + ofs + nbf, double_complex(0, 0));
+                    continue;
+                }
+                phi_sph.resize(npt);
+                for (int ip = 0; ip < npt; ip++) {
+                    phi_sph[ip] = phi_r__[idx_[ia][ip]];
+                }
+                for (int xi = 0; xi < nbf; xi++) {
+                    auto b = beta__[ia].at<CPU>(0, xi);
+                    double_complex z(0, 0);
+                    for (int ip = 0; ip < npt; ip++) {
+                        z += std::conj(b[ip]) * phi_sph[ip];
+                    }
+                    beta_phi__[ofs + xi] = z * norm;
+                    if (gamma_) {
+                        beta_phi__[ofs + xi] = beta_phi__[ofs + xi].real();
+                    }
+                }
+            }
+        }
+    }
+
+  public:
+
+    Beta_projectors_rs(Simulation_context const& ctx__, FFT3D const& fft__, vector3d<double> vk__)
+        : ctx_(ctx__)
+        , fft_(fft__)
+        , vk_(vk__)
+        , gamma_(ctx__.gamma_point())
+    {
+        PROFILE("sirius::Beta_projectors_rs");
+
+        auto& uc = ctx_.unit_cell();
+
+        if (fft_.num_ranks_y() > 1) {
+            TERMINATE("real-space beta-projectors require slab decomposition of the coarse FFT grid");
+        }
+
+        rcut_    = std::vector<double>(uc.num_atom_types(), 0);
+        beta_rf_ = mdarray<Spline<double>, 2>(uc.max_mt_radial_basis_size(), uc.num_atom_types());
+        for (int iat = 0; iat < uc.num_atom_types(); iat++) {
+            generate_radial_functions(uc.atom_type(iat));
+        }
+
+        idx_.resize(uc.num_atoms());
+        coord_.resize(uc.num_atoms());
+        beta_r_.resize(uc.num_atoms());
+
+        int z_off = fft_.offset_z();
+        int nz    = fft_.local_size_z();
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int ia = 0; ia < uc.num_atoms(); ia++) {
+            auto& type = uc.atom(ia).type();
+            double R   = rcut_[type.id()];
+            int nbf    = type.mt_basis_size();
+            if (!nbf) {
+                continue;
+            }
+            auto pos = uc.atom(ia).position();
+
+            /* extended grid coordinates of the points inside the sphere; the points are mapped to the unit cell
+             * and the lattice translation T is accounted for in the phase factor */
+            auto mod = [](int j, int n) { return ((j % n) + n) % n; };
+            std::vector<std::pair<int, vector3d<int>>> pts;
+            std::array<int, 3> j0, j1;
+            for (int x: {0, 1, 2}) {
+                vector3d<double> b(uc.reciprocal_lattice_vectors()(0, x), uc.reciprocal_lattice_vectors()(1, x),
+                                   uc.reciprocal_lattice_vectors()(2, x));
+                double e = R * b.length() / twopi;
+                j0[x] = static_cast<int>(std::floor((pos[x] - e) * fft_.size(x)));
+                j1[x] = static_cast<int>(std::ceil((pos[x] + e) * fft_.size(x)));
+            }
+            for (int J2 = j0[2]; J2 <= j1[2]; J2++) {
+                int i2 = mod(J2, fft_.size(2));
+                if (i2 < z_off || i2 >= z_off + nz) {
+                    continue;
+                }
+                for (int J1 = j0[1]; J1 <= j1[1]; J1++) {
+                    int i1 = mod(J1, fft_.size(1));
+                    for (int J0 = j0[0]; J0 <= j1[0]; J0++) {
+                        int i0 = mod(J0, fft_.size(0));
+                        vector3d<double> d(double(J0) / fft_.size(0) - pos[0], double(J1) / fft_.size(1) - pos[1],
+                                           double(J2) / fft_.size(2) - pos[2]);
+                        if (uc.get_cartesian_coordinates(d).length() < R) {
+                            pts.push_back({fft_.index_by_coord(i0, i1, i2 - z_off), vector3d<int>(J0, J1, J2)});
+                        }
+                    }
+                }
+            }
+            /* points of the sphere and of its periodic images can coincide; keep them as separate entries */
+            std::stable_sort(pts.begin(), pts.end(), [](std::pair<int, vector3d<int>> const& a,
+                                                        std::pair<int, vector3d<int>> const& b) {
+                return a.first < b.first;
+            });
+
+            int npt = static_cast<int>(pts.size());
+            idx_[ia].resize(npt);
+            coord_[ia].resize(npt);
+            for (int ip = 0; ip < npt; ip++) {
+                idx_[ia][ip]   = pts[ip].first;
+                coord_[ia][ip] = pts[ip].second;
+            }
+            tabulate(ia, -1, beta_r_[ia]);
+        }
+    }
+
+    /// Total number of beta-projectors.
+    inline int num_beta() const
+    {
+        return ctx_.unit_cell().mt_lo_basis_size();
+    }
+
+    /// Number of stored grid points over all atoms.
+    inline size_t num_points() const
+    {
+        size_t n{0};
+        for (auto& e: idx_) {
+            n += e.size();
+        }
+        return n;
+    }
+
+    /// Compute <beta|phi> for a single function phi(r) given on the local part of the coarse FFT grid.
+    /** The result is the local contribution and must be summed over the FFT communicator if it has more than
+     *  one rank. */
+    void inner(double_complex const* phi_r__, double_complex* beta_phi__) const
+    {
+        inner(beta_r_, phi_r__, beta_phi__);
+    }
+
+    /// Tabulate the gradients of the projectors over the atomic positions.
+    void generate_gradient()
+    {
+        PROFILE("sirius::Beta_projectors_rs::generate_gradient");
+
+        for (int x: {0, 1, 2}) {
+            dbeta_r_[x].resize(ctx_.unit_cell().num_atoms());
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int ia = 0; ia < ctx_.unit_cell().num_atoms(); ia++) {
+                if (ctx_.unit_cell().atom(ia).mt_basis_size()) {
+                    tabulate(ia, x, dbeta_r_[x][ia]);
+                }
+            }
+        }
+    }
+
+    /// Release the gradients of the projectors.
+    void dismiss_gradient()
+    {
+        for (int x: {0, 1, 2}) {
+            dbeta_r_[x].clear();
+        }
+    }
+
+    /// Compute <d beta / d r_{alpha,x}|phi> for a single function phi(r) given on the local part of the coarse FFT grid.
+    /** The gradients must be generated with generate_gradient(). */
+    void inner_gradient(int x__, double_complex const* phi_r__, double_complex* beta_phi__) const
+    {
+        inner(dbeta_r_[x__], phi_r__, beta_phi__);
+    }
+
+    /// Add sum_{xi} beta_{xi}(r) c_{xi} to the function f(r) given on the local part of the coarse FFT grid.
+    /** Threads own disjoint ranges of grid points, so the contributions of overlapping spheres are added without
+     *  synchronization. */
+    void add(double_complex const* coefs__, double_complex* f_r__) const
+    {
+        auto& uc    = ctx_.unit_cell();
+        double norm = std::sqrt(uc.omega());
+
+        #pragma omp parallel
+        {
+            int nt  = omp_get_num_threads();
+            int tid = omp_get_thread_num();
+            int ir0 = static_cast<int>(static_cast<int64_t>(fft_.local_size()) * tid / nt);
+            int ir1 = static_cast<int>(static_cast<int64_t>(fft_.local_size()) * (tid + 1) / nt);
+
+            for (int ia = 0; ia < uc.num_atoms(); ia++) {
+                int nbf = uc.atom(ia).mt_basis_size();
+                int ofs = uc.atom(ia).offset_lo();
+                auto& idx = idx_[ia];
+                int ip0 = static_cast<int>(std::lower_bound(idx.begin(), idx.end(), ir0) - idx.begin());
+                int ip1 = static_cast<int>(std::lower_bound(idx.begin(), idx.end(), ir1) - idx.begin());
+                if (ip0 == ip1) {
+                    continue;
+                }
+                for (int xi = 0; xi < nbf; xi++) {
+                    auto z = coefs__[ofs + xi] * norm;
+                    auto b = beta_r_[ia].at<CPU>(0, xi);
+                    for (int ip = ip0; ip < ip1; ip++) {
+                        f_r__[idx[ip]] += b[ip] * z;
+                    }
+                }
+            }
+        }
+    }
+
+    /// Apply the atom blocks of a non-local operator to <beta|phi>: c_{xi} = sum_{xi'} Op_{xi,xi'} <beta_{xi'}|phi>.
+    template <typename OP>
+    void apply_op(OP& op__, int ispn_block__, double_complex const* beta_phi__, double_complex* coefs__) const
+    {
+        auto& uc = ctx_.unit_cell();
+        #pragma omp parallel for schedule(static)
+        for (int ia = 0; ia < uc.num_atoms(); ia++) {
+            int nbf = uc.atom(ia).mt_basis_size();
+            int ofs = uc.atom(ia).offset_lo();
+            for (int xi1 = 0; xi1 < nbf; xi1++) {
+                double_complex z(0, 0);
+                for (int xi2 = 0; xi2 < nbf; xi2++) {
+                    z += double_complex(op__(xi1, xi2, ispn_block__, ia)) * beta_phi__[ofs + xi2];
+                }
+                coefs__[ofs + xi1] = z;
+            }
+        }
+    }
+};
+
+} // namespace sirius
+
+#endif // __BETA_PROJECTORS_RS_HPP__
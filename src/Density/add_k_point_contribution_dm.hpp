@@ -93,6 +93,58 @@ inline void Density::add_k_point_contribution_dm(K_point* kp__, mdarray<double_c
             return;
         }
 
+        /* <beta|psi> is computed with the same real-space beta-projectors which are used by the Hamiltonian */
+        if (ctx_.num_mag_dims() != 3 && kp__->beta_projectors_rs()) {
+            auto& beta_rs = *kp__->beta_projectors_rs();
+            auto& fft     = ctx_.fft_coarse();
+            int nbeta     = beta_rs.num_beta();
+
+            fft.prepare(kp__->gkvec_partition());
+
+            for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+                /* wave-functions are already swapped to the FFT-friendly distribution */
+                auto& psi    = kp__->spinor_wave_functions().pw_coeffs(ispn);
+                int nbnd_loc = psi.spl_num_col().local_size();
+
+                mdarray<double_complex, 2> beta_psi(nbeta, nbnd_loc);
+                for (int i = 0; i < nbnd_loc; i++) {
+                    fft.transform<1>(psi.extra().at<CPU>(0, i));
+                    beta_rs.inner(fft.buffer().at<CPU>(), &beta_psi(0, i));
+                }
+                if (fft.comm().size() > 1) {
+                    fft.comm().allreduce(beta_psi.at<CPU>(), static_cast<int>(beta_psi.size()));
+                }
+                /* projections are the same on all ranks of the FFT communicator; add them only once */
+                if (!nbnd_loc || fft.comm().rank() != 0) {
+                    continue;
+                }
+                #pragma omp parallel
+                {
+                    mdarray<double_complex, 2> bp2(unit_cell_.max_mt_basis_size(), nbnd_loc);
+                    #pragma omp for
+                    for (int ia = 0; ia < unit_cell_.num_atoms(); ia++) {
+                        int nbf  = unit_cell_.atom(ia).mt_basis_size();
+                        int offs = unit_cell_.atom(ia).offset_lo();
+                        if (!nbf) {
+                            continue;
+                        }
+                        for (int i = 0; i < nbnd_loc; i++) {
+                            double w = kp__->weight() * kp__->band_occupancy(psi.spl_num_col()[i], ispn);
+                            for (int xi = 0; xi < nbf; xi++) {
+                                bp2(xi, i) = std::conj(beta_psi(offs + xi, i)) * w;
+                            }
+                        }
+                        linalg<CPU>::gemm(0, 1, nbf, nbf, nbnd_loc, linalg_const<double_complex>::one(),
+                                          &beta_psi(offs, 0), beta_psi.ld(), &bp2(0, 0), bp2.ld(),
+                                          linalg_const<double_complex>::one(), &density_matrix__(0, 0, ispn, ia),
+                                          density_matrix__.ld());
+                    }
+                }
+            }
+            fft.dismiss();
+            return;
+        }
+
         kp__->beta_projectors().prepare();
 
         if (ctx_.num_mag_dims() != 3) {
@@ -45,6 +45,9 @@ inline void Density::add_k_point_contribution_rg(K_point* kp__)
 
     fft.prepare(kp__->gkvec_partition());
 
+    /* maximum number of bands transformed at once */
+    int nb_max = std::max(1, ctx_.control().fft_batch_size_);
+
     /* non-magnetic or collinear case */
     if (ctx_.num_mag_dims() != 3) {
         /* loop over pure spinor components */
@@ -54,6 +57,32 @@ inline void Density::add_k_point_contribution_rg(K_point* kp__)
                 continue;
             }
 
+            /* transform a block of bands at once */
+            if (fft.pu() == CPU) {
+                auto& psi = kp__->spinor_wave_functions().pw_coeffs(ispn);
+                int num_wf_loc = psi.spl_num_col().local_size();
+                std::vector<double> w(nb_max);
+                std::vector<double_complex*> buf(nb_max);
+                for (int i0 = 0; i0 < num_wf_loc; i0 += nb_max) {
+                    int nb = std::min(nb_max, num_wf_loc - i0);
+                    fft.transform_batch<1>(nb, psi.extra().template at<CPU>(0, i0), psi.extra().ld());
+                    for (int ib = 0; ib < nb; ib++) {
+                        w[ib]   = kp__->band_occupancy(psi.spl_num_col()[i0 + ib], ispn) * kp__->weight() / omega;
+                        buf[ib] = fft.buffer_batch(ib);
+                    }
+                    /* add to density */
+                    #pragma omp parallel for schedule(static)
+                    for (int ir = 0; ir < fft.local_size(); ir++) {
+                        double d{0};
+                        for (int ib = 0; ib < nb; ib++) {
+                            d += w[ib] * (std::pow(buf[ib][ir].real(), 2) + std::pow(buf[ib][ir].imag(), 2));
+                        }
+                        density_rg(ir, ispn) += d;
+                    }
+                }
+                continue;
+            }
+
             for (int i = 0; i < kp__->spinor_wave_functions().pw_coeffs(ispn).spl_num_col().local_size(); i++) {
                 int j = kp__->spinor_wave_functions().pw_coeffs(ispn).spl_num_col()[i];
                 double w = kp__->band_occupancy(j, ispn) * kp__->weight() / omega;
@@ -94,6 +123,42 @@ inline void Density::add_k_point_contribution_rg(K_point* kp__)
                 }
             }
         }
+    } else if (fft.pu() == CPU) { /* non-collinear case; a block of bands is transformed at once */
+        auto& psi_up = kp__->spinor_wave_functions().pw_coeffs(0);
+        auto& psi_dn = kp__->spinor_wave_functions().pw_coeffs(1);
+        int num_wf_loc = psi_up.spl_num_col().local_size();
+        /* real-space up- components of the block of bands */
+        mdarray<double_complex, 2> psi_r(fft.local_size(), nb_max);
+        std::vector<double> w(nb_max);
+        std::vector<double_complex*> buf(nb_max);
+        for (int i0 = 0; i0 < num_wf_loc; i0 += nb_max) {
+            int nb = std::min(nb_max, num_wf_loc - i0);
+            /* transform up- components of spinor functions to real space and save them */
+            fft.transform_batch<1>(nb, psi_up.extra().template at<CPU>(0, i0), psi_up.extra().ld());
+            for (int ib = 0; ib < nb; ib++) {
+                w[ib] = kp__->band_occupancy(psi_up.spl_num_col()[i0 + ib], 0) * kp__->weight() / omega;
+                std::memcpy(psi_r.at<CPU>(0, ib), fft.buffer_batch(ib), fft.local_size() * sizeof(double_complex));
+            }
+            /* transform dn- components of spinor functions */
+            fft.transform_batch<1>(nb, psi_dn.extra().template at<CPU>(0, i0), psi_dn.extra().ld());
+            for (int ib = 0; ib < nb; ib++) {
+                buf[ib] = fft.buffer_batch(ib);
+            }
+            #pragma omp parallel for schedule(static)
+            for (int ir = 0; ir < fft.local_size(); ir++) {
+                double r0{0}, r1{0};
+                double_complex z2{0};
+                for (int ib = 0; ib < nb; ib++) {
+                    r0 += (std::pow(psi_r(ir, ib).real(), 2) + std::pow(psi_r(ir, ib).imag(), 2)) * w[ib];
+                    r1 += (std::pow(buf[ib][ir].real(), 2) + std::pow(buf[ib][ir].imag(), 2)) * w[ib];
+                    z2 += psi_r(ir, ib) * std::conj(buf[ib][ir]) * w[ib];
+                }
+                density_rg(ir, 0) += r0;
+                density_rg(ir, 1) += r1;
+                density_rg(ir, 2) += 2.0 * std::real(z2);
+                density_rg(ir, 3) -= 2.0 * std::imag(z2);
+            }
+        }
     } else { /* non-collinear case */
         assert(kp__->spinor_wave_functions().pw_coeffs(0).spl_num_col().local_size() ==
                kp__->spinor_wave_functions().pw_coeffs(1).spl_num_col().local_size());
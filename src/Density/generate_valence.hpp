@@ -67,6 +67,10 @@ inline void Density::generate_valence(K_point_set& ks__)
         int ik = ks__.spl_num_kpoints(ikloc);
         auto kp = ks__[ik];
 
+        /* read wave-functions of the next k-point from the out-of-core store while this one is processed;
+           the wave-functions are only read here */
+        ks__.prefetch_wave_functions(ikloc, false);
+
         for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
             int nbnd = kp->num_occupied_bands(ispn);
             
@@ -105,6 +109,7 @@ inline void Density::generate_valence(K_point_set& ks__)
             }
         }
 #endif
+        kp->page_out_wave_functions();
     }
 
     if (density_matrix_.size()) {
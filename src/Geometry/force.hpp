@@ -94,6 +94,76 @@ class Force
 #endif
         }
 
+        /// Contribution of a k-point to the non-local forces computed with the real-space beta-projectors.
+        /** The expression is the same as in Non_local_functor; \f$ \langle \beta | \psi \rangle \f$ and
+         *  \f$ \langle \partial \beta / \partial \tau_{\alpha} | \psi \rangle \f$ are computed on the coarse FFT
+         *  grid with the projectors which are used by the Hamiltonian. */
+        void add_k_point_contribution_rs(K_point& kpoint__, mdarray<double, 2>& forces__) const
+        {
+            auto& uc      = ctx_.unit_cell();
+            auto& beta_rs = *kpoint__.beta_projectors_rs();
+            auto& fft     = ctx_.fft_coarse();
+            int nbeta     = beta_rs.num_beta();
+
+            beta_rs.generate_gradient();
+            fft.prepare(kpoint__.gkvec_partition());
+
+            for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+                int spin_factor = (ispn == 0 ? 1 : -1);
+
+                /* swap wave-functions to the FFT-friendly distribution */
+                auto& psi = kpoint__.spinor_wave_functions().pw_coeffs(ispn);
+                psi.remap_forward(CPU, kpoint__.num_occupied_bands(ispn));
+                int nbnd_loc = psi.spl_num_col().local_size();
+
+                /* <beta|psi> and <d beta / d tau_x|psi> */
+                mdarray<double_complex, 3> beta_psi(nbeta, nbnd_loc, 4);
+                for (int i = 0; i < nbnd_loc; i++) {
+                    fft.transform<1>(psi.extra().at<CPU>(0, i));
+                    beta_rs.inner(fft.buffer().at<CPU>(), &beta_psi(0, i, 0));
+                    for (int x: {0, 1, 2}) {
+                        beta_rs.inner_gradient(x, fft.buffer().at<CPU>(), &beta_psi(0, i, x + 1));
+                    }
+                }
+                if (fft.comm().size() > 1) {
+                    fft.comm().allreduce(beta_psi.at<CPU>(), static_cast<int>(beta_psi.size()));
+                }
+                /* projections are the same on all ranks of the FFT communicator; add them only once */
+                if (!nbnd_loc || fft.comm().rank() != 0) {
+                    continue;
+                }
+
+                #pragma omp parallel for
+                for (int ia = 0; ia < uc.num_atoms(); ia++) {
+                    int nbf  = uc.atom(ia).mt_basis_size();
+                    int offs = uc.atom(ia).offset_lo();
+                    int iat  = uc.atom(ia).type_id();
+                    for (int ibf = 0; ibf < nbf; ibf++) {
+                        for (int jbf = 0; jbf < nbf; jbf++) {
+                            /* Qij exists only in the case of ultrasoft/PAW */
+                            double qij = uc.atom(ia).type().augment() ? ctx_.augmentation_op(iat).q_mtrx(ibf, jbf) : 0.0;
+                            double dij = uc.atom(ia).d_mtrx(ibf, jbf, 0);
+                            if (ctx_.num_spins() == 2) {
+                                dij += spin_factor * uc.atom(ia).d_mtrx(ibf, jbf, 1);
+                            }
+                            /* - 2 Re[ occ(k,n) weight(k) beta_phi*(j,n) [ Dij - E(n)Qij] beta_grad_phi(i,n) ] */
+                            for (int i = 0; i < nbnd_loc; i++) {
+                                int ibnd = psi.spl_num_col()[i];
+                                auto z = -2.0 * kpoint__.band_occupancy(ibnd, ispn) * kpoint__.weight() *
+                                         std::conj(beta_psi(offs + jbf, i, 0)) *
+                                         (dij - kpoint__.band_energy(ibnd, ispn) * qij);
+                                for (int x: {0, 1, 2}) {
+                                    forces__(x, ia) += std::real(z * beta_psi(offs + ibf, i, x + 1));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            fft.dismiss();
+            beta_rs.dismiss_gradient();
+        }
+
         inline void symmetrize(mdarray<double, 2>& forces__) const
         {
             if (!ctx_.use_symmetry()) {
@@ -468,12 +538,17 @@ class Force
 
             for (int ikploc = 0; ikploc < spl_num_kp.local_size(); ikploc++) {
                 K_point* kp = kset_[spl_num_kp[ikploc]];
+                /* read wave-functions of the next k-point from the out-of-core store while this one is processed */
+                kset_.prefetch_wave_functions(ikploc, false);
 
-                if (ctx_.gamma_point()) {
+                if (kp->beta_projectors_rs()) {
+                    add_k_point_contribution_rs(*kp, forces_nonloc_);
+                } else if (ctx_.gamma_point()) {
                     add_k_point_contribution<double>(*kp, forces_nonloc_);
                 } else {
                     add_k_point_contribution<double_complex>(*kp, forces_nonloc_);
                 }
+                kp->page_out_wave_functions();
             }
 
             ctx_.comm().allreduce(&forces_nonloc_(0, 0), 3 * ctx_.unit_cell().num_atoms());
@@ -787,7 +862,12 @@ class Force
                 if (ctx_.num_mag_dims() == 3)
                     TERMINATE("Hubbard forces are only implemented for the simple hubbard correction.");
 
+                /* read wave-functions of the next k-point from the out-of-core store while this one is processed */
+                kset_.prefetch_wave_functions(ikloc, false);
+
                 hubbard_force_add_k_contribution_colinear(*kp, forces_hubbard_);
+
+                kp->page_out_wave_functions();
             }
             hamiltonian_.dismiss();
 
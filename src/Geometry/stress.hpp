@@ -217,6 +217,11 @@ class Stress {
         for (int ikloc = 0; ikloc < kset_.spl_num_kpoints().local_size(); ikloc++) {
             int ik = kset_.spl_num_kpoints(ikloc);
             auto kp = kset_[ik];
+            if (kp->beta_projectors_rs()) {
+                TERMINATE("stress is not implemented for the real-space beta-projectors");
+            }
+            /* read wave-functions of the next k-point from the out-of-core store while this one is processed */
+            kset_.prefetch_wave_functions(ikloc, false);
 #ifdef __GPU
             if (ctx_.processing_unit() == GPU && !keep_wf_on_gpu) {
                 int nbnd = ctx_.num_bands();
@@ -240,6 +245,7 @@ class Stress {
                 }
             }
 #endif
+            kp->page_out_wave_functions();
         }
 
         #pragma omp parallel
@@ -606,6 +612,8 @@ class Stress {
         for (int ikloc = 0; ikloc < kset_.spl_num_kpoints().local_size(); ikloc++) {
             int ik = kset_.spl_num_kpoints(ikloc);
             auto kp = kset_[ik];
+            /* read wave-functions of the next k-point from the out-of-core store while this one is processed */
+            kset_.prefetch_wave_functions(ikloc, false);
 
             for (int igloc = 0; igloc < kp->num_gkvec_loc(); igloc++) {
                 auto Gk = kp->gkvec().gkvec_cart<index_domain_t::local>(igloc);
@@ -628,6 +636,7 @@ class Stress {
                     }
                 }
             } // igloc
+            kp->page_out_wave_functions();
         } // ikloc
 
         ctx_.comm().allreduce(&stress_kin_(0, 0), 9);
@@ -927,10 +936,14 @@ class Stress {
             if (ctx_.num_mag_dims() == 3)
                 TERMINATE("Hubbard stress correction is only implemented for the simple hubbard correction.");
 
+            /* read wave-functions of the next k-point from the out-of-core store while this one is processed */
+            kset_.prefetch_wave_functions(ikloc, false);
+
             // compute the derivative of the occupancies numbers
             hamiltonian_.U().compute_occupancies_stress_derivatives(*kp__,
                                                                     hamiltonian_.Q<double_complex>(),
                                                                     dn_);
+            kp__->page_out_wave_functions();
             for (int dir1 = 0; dir1 < 3; dir1++) {
                 for (int dir2 = 0; dir2 < 3; dir2++) {
                     for (int ia1 = 0; ia1 < ctx_.unit_cell().num_atoms(); ia1++) {
@@ -58,6 +58,30 @@ void Hamiltonian::apply_h_s(K_point* kp__,
         }
     }
 
+    /* wave-functions stored in single precision: H and S are applied to a double precision copy of the block */
+    if (phi__.fp32() || (hphi__ != NULL && hphi__->fp32()) || (sphi__ != NULL && sphi__->fp32())) {
+        int num_sc = phi__.num_sc();
+        size_t sz = static_cast<size_t>(kp__->num_gkvec_loc()) * n__ * num_sc;
+        auto ptr = ctx_.mem_pool().allocate<double_complex, memory_t::host>(3 * sz);
+        Wave_functions phi(ptr, kp__->gkvec_partition(), n__, num_sc);
+        Wave_functions hphi(ptr + sz, kp__->gkvec_partition(), n__, num_sc);
+        Wave_functions sphi(ptr + 2 * sz, kp__->gkvec_partition(), n__, num_sc);
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            phi.copy_from(CPU, n__, phi__, ispn, N__, ispn, 0);
+        }
+        apply_h_s<T>(kp__, ispn__, 0, n__, phi, (hphi__ != NULL) ? &hphi : NULL, (sphi__ != NULL) ? &sphi : NULL);
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            if (hphi__ != NULL) {
+                hphi__->copy_from(CPU, n__, hphi, ispn, 0, ispn, N__);
+            }
+            if (sphi__ != NULL) {
+                sphi__->copy_from(CPU, n__, sphi, ispn, 0, ispn, N__);
+            }
+        }
+        ctx_.mem_pool().free<memory_t::host>(ptr);
+        return;
+    }
+
     double t1 = -omp_get_wtime();
 
     /* for the data remapping we need phi on CPU */
@@ -71,7 +95,19 @@ void Hamiltonian::apply_h_s(K_point* kp__,
     }
     #endif
 
-    if (hphi__ != NULL) {
+    /* beta-projectors tabulated in real space are applied together with the local part of Hamiltonian */
+    Beta_projectors_rs* beta_rs{nullptr};
+    if (ispn__ != 2 && ctx_.unit_cell().mt_lo_basis_size()) {
+        beta_rs = kp__->beta_projectors_rs();
+    }
+
+    if (beta_rs) {
+        /* set intial sphi */
+        if (sphi__ != NULL) {
+            sphi__->copy_from(ctx_.processing_unit(), n__, phi__, ispn__, N__, ispn__, N__);
+        }
+        local_op_->apply_h_s_rs(ispn__, phi__, hphi__, sphi__, N__, n__, *beta_rs, D<T>(), Q<T>());
+    } else if (hphi__ != NULL) {
         /* apply local part of Hamiltonian */
         local_op_->apply_h(ispn__, phi__, *hphi__, N__, n__);
         #ifdef __GPU
@@ -107,7 +143,7 @@ void Hamiltonian::apply_h_s(K_point* kp__,
     }
 
     /* set intial sphi */
-    for (int ispn = 0; (ispn < nsc) && (sphi__ != NULL); ispn++) {
+    for (int ispn = 0; (ispn < nsc) && (sphi__ != NULL) && !beta_rs; ispn++) {
         sphi__->copy_from(ctx_.processing_unit(), n__, phi__, ispn, N__, ispn, N__);
     }
 
@@ -116,7 +152,7 @@ void Hamiltonian::apply_h_s(K_point* kp__,
         return;
     }
 
-    for (int i = 0; i < kp__->beta_projectors().num_chunks(); i++) {
+    for (int i = 0; (i < kp__->beta_projectors().num_chunks()) && !beta_rs; i++) {
         /* generate beta-projectors for a block of atoms */
         kp__->beta_projectors().generate(i);
         /* non-collinear case */
@@ -125,33 +161,40 @@ void Hamiltonian::apply_h_s(K_point* kp__,
 
                 auto beta_phi = kp__->beta_projectors().inner<T>(i, phi__, ispn, N__, n__);
 
+                std::vector<non_local_block_t<T>> blocks;
                 if (hphi__) {
                     /* apply diagonal spin blocks */
-                    D<T>().apply(i, ispn, *hphi__, N__, n__, kp__->beta_projectors(), beta_phi);
+                    blocks.push_back({&D<T>(), ispn, hphi__});
                     /* apply non-diagonal spin blocks */
                     /* xor 3 operator will map 0 to 3 and 1 to 2 */
-                    D<T>().apply(i, ispn ^ 3, *hphi__, N__, n__, kp__->beta_projectors(), beta_phi);
+                    blocks.push_back({&D<T>(), ispn ^ 3, hphi__});
                 }
 
                 if (sphi__) {
                     /* apply Q operator (diagonal in spin) */
-                    Q<T>().apply(i, ispn, *sphi__, N__, n__, kp__->beta_projectors(), beta_phi);
+                    blocks.push_back({&Q<T>(), ispn, sphi__});
                     /* apply non-diagonal spin blocks */
                     if (ctx_.so_correction()) {
-                        Q<T>().apply(i, ispn ^ 3, *sphi__, N__, n__, kp__->beta_projectors(), beta_phi);
+                        blocks.push_back({&Q<T>(), ispn ^ 3, sphi__});
                     }
                 }
+                /* D and Q share one multiplication by the beta-projectors */
+                apply_dq(ctx_.mem_pool(), i, blocks, N__, n__, kp__->beta_projectors(), beta_phi);
             }
         } else { /* non-magnetic or collinear case */
 
             auto beta_phi = kp__->beta_projectors().inner<T>(i, phi__, ispn__, N__, n__);
+
+            std::vector<non_local_block_t<T>> blocks;
             if (hphi__) {
-                D<T>().apply(i, ispn__, *hphi__, N__, n__, kp__->beta_projectors(), beta_phi);
+                blocks.push_back({&D<T>(), ispn__, hphi__});
             }
 
             if (sphi__) {
-                Q<T>().apply(i, ispn__, *sphi__, N__, n__, kp__->beta_projectors(), beta_phi);
+                blocks.push_back({&Q<T>(), ispn__, sphi__});
             }
+            /* D and Q share one multiplication by the beta-projectors */
+            apply_dq(ctx_.mem_pool(), i, blocks, N__, n__, kp__->beta_projectors(), beta_phi);
         }
     }
 
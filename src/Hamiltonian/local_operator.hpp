@@ -26,6 +26,8 @@
 #define __LOCAL_OPERATOR_HPP__
 
 #include "Potential/potential.hpp"
+#include "Beta_projectors/beta_projectors_rs.hpp"
+#include "local_operator_kernels.hpp"
 
 #ifdef __GPU
 extern "C" void mul_by_veff_gpu(int ispn__, int size__, double* const* veff__, double_complex* buf__);
@@ -40,6 +42,9 @@ extern "C" void add_pw_ekin_gpu(int                   num_gvec__,
 
 namespace sirius {
 
+template <typename T>
+class Non_local_operator;
+
 /// Representation of the local operator.
 /** The following functionality is implementated:
  *    - application of the local part of Hamiltonian (kinetic + potential) to the wave-fucntions in the PP-PW case
@@ -79,6 +84,12 @@ class Local_operator
     /// Temporary array to store psi_{up}(r).
     mdarray<double_complex, 1> buf_rg_;
 
+    /// Single-precision copy of the effective potential components on a coarse FFT grid.
+    std::array<mdarray<float, 1>, 4> veff_vec_fp32_;
+
+    /// Single-precision plane-wave coefficients of a wave-function.
+    mdarray<std::complex<float>, 1> psi_fp32_;
+
     /// V(G=0) matrix elements.
     double v0_[2];
 
@@ -230,6 +241,20 @@ class Local_operator
                 }
             }
 
+            /* single-precision copy of the potential for the early SCF iterations */
+            if (ctx_.local_op_fp32()) {
+                for (int j = 0; j < ctx_.num_mag_dims() + 1; j++) {
+                    if (static_cast<int>(veff_vec_fp32_[j].size()) < fft_coarse_.local_size()) {
+                        veff_vec_fp32_[j] = mdarray<float, 1>(fft_coarse_.local_size(), memory_t::host,
+                                                              "Local_operator::veff_vec_fp32_");
+                    }
+                    #pragma omp parallel for schedule(static)
+                    for (int ir = 0; ir < fft_coarse_.local_size(); ir++) {
+                        veff_vec_fp32_[j][ir] = static_cast<float>(veff_vec_[j].f_rg(ir));
+                    }
+                }
+            }
+
             if (ctx_.control().print_checksum_) {
                 for (int j = 0; j < ctx_.num_mag_dims() + 1; j++) {
                     auto cs = veff_vec_[j].checksum_pw();
@@ -270,6 +295,9 @@ class Local_operator
         if (gkvec_p__.gvec().reduced() && static_cast<int>(vphi2_.size()) < ngv_fft) {
             vphi2_ = mdarray<double_complex, 1>(ngv_fft, memory_t::host, "Local_operator::vphi2");
         }
+        if (ctx_.local_op_fp32() && static_cast<int>(psi_fp32_.size()) < ngv_fft) {
+            psi_fp32_ = mdarray<std::complex<float>, 1>(ngv_fft, memory_t::host, "Local_operator::psi_fp32_");
+        }
 
         if (fft_coarse_.pu() == GPU) {
             pw_ekin_.allocate(memory_t::device);
@@ -319,11 +347,16 @@ class Local_operator
 
         num_applied(n__);
 
-        /* remap wave-functions */
+        /* remap wave-functions; on CPU the remapping is non-blocking and the bands are processed as soon as they
+         * arrive */
+        for (int ispn = 0; ispn < phi__.num_sc(); ispn++) {
+            if (fft_coarse_.pu() == CPU) {
+                phi__.pw_coeffs(ispn).remap_forward_begin(n__, idx0__);
+            } else {
+                phi__.pw_coeffs(ispn).remap_forward(fft_coarse_.pu(), n__, idx0__);
+            }
+        }
         for (int ispn = 0; ispn < phi__.num_sc(); ispn++) {
-
-            phi__.pw_coeffs(ispn).remap_forward(fft_coarse_.pu(), n__, idx0__);
-
             hphi__.pw_coeffs(ispn).set_num_extra(CPU, n__, idx0__);
             hphi__.pw_coeffs(ispn).extra().zero<memory_t::host | memory_t::device>();
         }
@@ -370,17 +403,13 @@ class Local_operator
             switch (fft_coarse_.pu()) {
                 case CPU: {
                     if (ispn_block < 2) {
-                        #pragma omp parallel for schedule(static)
-                        for (int ir = 0; ir < fft_coarse_.local_size(); ir++) {
-                            buf[ir] *= veff_vec_[ispn_block].f_rg(ir);
-                        }
+                        local_operator_kernels::mul_by_veff(fft_coarse_.local_size(),
+                                                            veff_vec_[ispn_block].f_rg().at<CPU>(), buf.at<CPU>());
                     } else {
                         double pref = (ispn_block == 2) ? -1 : 1;
-                        #pragma omp parallel for schedule(static)
-                        for (int ir = 0; ir < fft_coarse_.local_size(); ir++) {
-                            /* multiply by Bx +/- i*By */
-                            buf[ir] *= double_complex(veff_vec_[2].f_rg(ir), pref * veff_vec_[3].f_rg(ir));
-                        }
+                        /* multiply by Bx +/- i*By */
+                        local_operator_kernels::mul_by_bxy(fft_coarse_.local_size(), veff_vec_[2].f_rg().at<CPU>(),
+                                                           veff_vec_[3].f_rg().at<CPU>(), pref, buf.at<CPU>());
                     }
                     break;
                 }
@@ -460,45 +489,199 @@ class Local_operator
                 vphi1_.copy<memory_t::device, memory_t::host>();
             }
             /* CPU case */
+            auto& phi_extra  = phi__.pw_coeffs(ispn).extra();
+            auto& hphi_extra = hphi__.pw_coeffs(ispn).extra();
+            int ngv = gkvec_p_->gvec_count_fft();
             if (gamma) { /* update two wave functions */
-                if (ekin) {
-                    #pragma omp parallel for schedule(static)
-                    for (int ig = 0; ig < gkvec_p_->gvec_count_fft(); ig++) {
-                        hphi__.pw_coeffs(ispn).extra()(ig, 2 * i) += (phi__.pw_coeffs(ispn).extra()(ig, 2 * i) * pw_ekin_[ig] + vphi1_[ig]);
-                        hphi__.pw_coeffs(ispn).extra()(ig, 2 * i + 1) += (phi__.pw_coeffs(ispn).extra()(ig, 2 * i + 1) * pw_ekin_[ig] + vphi2_[ig]);
-                    }
-                } else {
-                    #pragma omp parallel for schedule(static)
-                    for (int ig = 0; ig < gkvec_p_->gvec_count_fft(); ig++) {
-                        hphi__.pw_coeffs(ispn).extra()(ig, 2 * i) += vphi1_[ig];
-                        hphi__.pw_coeffs(ispn).extra()(ig, 2 * i + 1) += vphi2_[ig];
-                    }
-                }
+                local_operator_kernels::add_pw_ekin(ngv, ekin, pw_ekin_.at<CPU>(), phi_extra.at<CPU>(0, 2 * i),
+                                                    vphi1_.at<CPU>(), hphi_extra.at<CPU>(0, 2 * i));
+                local_operator_kernels::add_pw_ekin(ngv, ekin, pw_ekin_.at<CPU>(), phi_extra.at<CPU>(0, 2 * i + 1),
+                                                    vphi2_.at<CPU>(), hphi_extra.at<CPU>(0, 2 * i + 1));
             } else { /* update single wave function */
-                if (ekin) {
-                    #pragma omp parallel for schedule(static)
-                    for (int ig = 0; ig < gkvec_p_->gvec_count_fft(); ig++) {
-                        hphi__.pw_coeffs(ispn).extra()(ig, i) += (phi__.pw_coeffs(ispn).extra()(ig, i) * pw_ekin_[ig] + vphi1_[ig]);
-                    }
-                } else {
-                    #pragma omp parallel for schedule(static)
-                    for (int ig = 0; ig < gkvec_p_->gvec_count_fft(); ig++) {
-                        hphi__.pw_coeffs(ispn).extra()(ig, i) += vphi1_[ig];
-                    }
-                }
+                local_operator_kernels::add_pw_ekin(ngv, ekin, pw_ekin_.at<CPU>(), phi_extra.at<CPU>(0, i),
+                                                    vphi1_.at<CPU>(), hphi_extra.at<CPU>(0, i));
             }
         };
         /* local number of wave-functions in extra-storage distribution */
         int num_wf_loc = phi__.pw_coeffs(0).spl_num_col().local_size();
 
+        /* wait until the local band i of phi is received */
+        auto wait_phi = [&phi__](int i)
+        {
+            for (int ispn = 0; ispn < phi__.num_sc(); ispn++) {
+                phi__.pw_coeffs(ispn).remap_forward_wait(i);
+            }
+        };
+
         int first{0};
-        /* If G-vectors are reduced, wave-functions are real and we can transform two of them at once.
-             * Non-collinear case is not treated here because nc wave-functions are complex and G+k vectors 
+        /* In the early SCF iterations the spin-collinear local operator is applied in single precision; the
+         * kinetic energy is always added in double precision. */
+        if (ctx_.local_op_fp32() && fft_coarse_.fp32_transform_available() && ispn__ != 2 &&
+            veff_vec_fp32_[ispn__].size()) {
+            auto& phi_extra  = phi__.pw_coeffs(ispn__).extra();
+            auto& hphi_extra = hphi__.pw_coeffs(ispn__).extra();
+            int ngv = gkvec_p_->gvec_count_fft();
+            for (int i = 0; i < num_wf_loc; i++) {
+                wait_phi(i);
+                /* phi(G) -> phi(r) */
+                #pragma omp parallel for schedule(static)
+                for (int ig = 0; ig < ngv; ig++) {
+                    psi_fp32_[ig] = std::complex<float>(phi_extra(ig, i));
+                }
+                fft_coarse_.transform_fp32<1>(psi_fp32_.at<CPU>());
+                /* multiply by effective potential */
+                auto& buf = fft_coarse_.buffer_fp32();
+                #pragma omp parallel for schedule(static)
+                for (int ir = 0; ir < fft_coarse_.local_size(); ir++) {
+                    buf[ir] *= veff_vec_fp32_[ispn__][ir];
+                }
+                /* V(r)phi(r) -> [V*phi](G) */
+                fft_coarse_.transform_fp32<-1>(psi_fp32_.at<CPU>());
+                /* add kinetic energy */
+                #pragma omp parallel for schedule(static)
+                for (int ig = 0; ig < ngv; ig++) {
+                    hphi_extra(ig, i) += phi_extra(ig, i) * pw_ekin_[ig] + double_complex(psi_fp32_[ig]);
+                }
+            }
+            first = num_wf_loc;
+        } else if (!gkvec_p_->gvec().reduced() && fft_coarse_.band_parallel_preferred(num_wf_loc)) {
+            /* On small grids each thread applies the local operator to its own bands with a serial FFT; this avoids
+             * the synchronisation of all threads after each step of the transformation. */
+            int nt = omp_get_max_threads();
+            int ngv = gkvec_p_->gvec_count_fft();
+            int nr  = fft_coarse_.local_size();
+            /* number of FFT buffer slots per thread */
+            int ns = (ispn__ == 2) ? 2 : 1;
+            fft_coarse_.reallocate_batch(ns * nt);
+            /* bands are taken by threads in arbitrary order */
+            wait_phi(num_wf_loc - 1);
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                #pragma omp for schedule(dynamic, 1)
+                for (int i = 0; i < num_wf_loc; i++) {
+                    if (ispn__ == 2) {
+                        auto& phi_u  = phi__.pw_coeffs(0).extra();
+                        auto& phi_d  = phi__.pw_coeffs(1).extra();
+                        auto& hphi_u = hphi__.pw_coeffs(0).extra();
+                        auto& hphi_d = hphi__.pw_coeffs(1).extra();
+                        /* phi_{u,d}(G) -> phi_{u,d}(r) */
+                        fft_coarse_.transform_in_thread<1>(2 * tid, phi_u.at<CPU>(0, i));
+                        fft_coarse_.transform_in_thread<1>(2 * tid + 1, phi_d.at<CPU>(0, i));
+                        /* apply V_{uu}, V_{ud}, V_{du} and V_{dd} */
+                        local_operator_kernels::mul_by_veff_spinor_range(
+                            0, nr, veff_vec_[0].f_rg().at<CPU>(), veff_vec_[1].f_rg().at<CPU>(),
+                            veff_vec_[2].f_rg().at<CPU>(), veff_vec_[3].f_rg().at<CPU>(),
+                            reinterpret_cast<double*>(fft_coarse_.buffer_batch(2 * tid)),
+                            reinterpret_cast<double*>(fft_coarse_.buffer_batch(2 * tid + 1)));
+                        /* [V*phi]_{u,d}(r) -> [V*phi]_{u,d}(G); hphi is zero at this point and is overwritten */
+                        fft_coarse_.transform_in_thread<-1>(2 * tid, hphi_u.at<CPU>(0, i));
+                        fft_coarse_.transform_in_thread<-1>(2 * tid + 1, hphi_d.at<CPU>(0, i));
+                        /* add kinetic energy */
+                        local_operator_kernels::add_pw_ekin_range<false>(
+                            0, ngv, 1.0, pw_ekin_.at<CPU>(), reinterpret_cast<double const*>(phi_u.at<CPU>(0, i)),
+                            nullptr, reinterpret_cast<double*>(hphi_u.at<CPU>(0, i)));
+                        local_operator_kernels::add_pw_ekin_range<false>(
+                            0, ngv, 1.0, pw_ekin_.at<CPU>(), reinterpret_cast<double const*>(phi_d.at<CPU>(0, i)),
+                            nullptr, reinterpret_cast<double*>(hphi_d.at<CPU>(0, i)));
+                    } else {
+                        auto& phi_extra  = phi__.pw_coeffs(ispn__).extra();
+                        auto& hphi_extra = hphi__.pw_coeffs(ispn__).extra();
+                        /* phi(G) -> phi(r) */
+                        fft_coarse_.transform_in_thread<1>(tid, phi_extra.at<CPU>(0, i));
+                        /* multiply by effective potential */
+                        local_operator_kernels::mul_by_veff_range(0, nr, veff_vec_[ispn__].f_rg().at<CPU>(),
+                                                                  reinterpret_cast<double*>(fft_coarse_.buffer_batch(tid)));
+                        /* V(r)phi(r) -> [V*phi](G); hphi is zero at this point and is overwritten */
+                        fft_coarse_.transform_in_thread<-1>(tid, hphi_extra.at<CPU>(0, i));
+                        /* add kinetic energy */
+                        local_operator_kernels::add_pw_ekin_range<false>(
+                            0, ngv, 1.0, pw_ekin_.at<CPU>(), reinterpret_cast<double const*>(phi_extra.at<CPU>(0, i)),
+                            nullptr, reinterpret_cast<double*>(hphi_extra.at<CPU>(0, i)));
+                    }
+                }
+            }
+            first = num_wf_loc;
+        } else if (fft_coarse_.pu() == CPU && !gkvec_p_->gvec().reduced() && ispn__ != 2) {
+            /* In the spin-collinear case with complex wave-functions a block of bands is transformed at once; this
+             * replaces the all-to-all calls of individual bands by a single exchange per block. */
+            auto& phi_extra  = phi__.pw_coeffs(ispn__).extra();
+            auto& hphi_extra = hphi__.pw_coeffs(ispn__).extra();
+            /* maximum number of wave-functions in a block */
+            int nb_max = std::max(1, ctx_.control().fft_batch_size_);
+            std::vector<double_complex*> buf(nb_max);
+            for (int i0 = 0; i0 < num_wf_loc; i0 += nb_max) {
+                int nb = std::min(nb_max, num_wf_loc - i0);
+                wait_phi(i0 + nb - 1);
+                /* phi(G) -> phi(r) for a block of wave-functions */
+                fft_coarse_.transform_batch<1>(nb, phi_extra.at<CPU>(0, i0), phi_extra.ld());
+                for (int ib = 0; ib < nb; ib++) {
+                    buf[ib] = fft_coarse_.buffer_batch(ib);
+                }
+                /* multiply by effective potential; each value of the potential is loaded once per block */
+                local_operator_kernels::mul_by_veff(fft_coarse_.local_size(), veff_vec_[ispn__].f_rg().at<CPU>(), nb,
+                                                    buf.data());
+                /* V(r)phi(r) -> [V*phi](G); hphi is zero at this point and is overwritten */
+                fft_coarse_.transform_batch<-1>(nb, hphi_extra.at<CPU>(0, i0), hphi_extra.ld());
+                /* add kinetic energy */
+                for (int ib = 0; ib < nb; ib++) {
+                    local_operator_kernels::add_pw_ekin(gkvec_p_->gvec_count_fft(), 1.0, pw_ekin_.at<CPU>(),
+                                                        phi_extra.at<CPU>(0, i0 + ib), nullptr,
+                                                        hphi_extra.at<CPU>(0, i0 + ib));
+                }
+            }
+            first = num_wf_loc;
+        } else if (fft_coarse_.pu() == CPU && ispn__ == 2) {
+            /* In the non-collinear case both spinor components of a block of bands are transformed together and
+             * the full 2x2 matrix of the potential is applied in one sweep; this requires two forward and two
+             * backward transformations per band. */
+            auto& phi_u  = phi__.pw_coeffs(0).extra();
+            auto& phi_d  = phi__.pw_coeffs(1).extra();
+            auto& hphi_u = hphi__.pw_coeffs(0).extra();
+            auto& hphi_d = hphi__.pw_coeffs(1).extra();
+            int ngv = gkvec_p_->gvec_count_fft();
+            /* maximum number of bands in a block */
+            int nb_max = std::max(1, ctx_.control().fft_batch_size_ / 2);
+            /* up- and dn- components of a band are stored one after another */
+            mdarray<double_complex, 2> psi(ngv, 2 * std::min(nb_max, std::max(1, num_wf_loc)), memory_t::host,
+                                           "Local_operator::apply_h::psi");
+            for (int i0 = 0; i0 < num_wf_loc; i0 += nb_max) {
+                int nb = std::min(nb_max, num_wf_loc - i0);
+                wait_phi(i0 + nb - 1);
+                for (int ib = 0; ib < nb; ib++) {
+                    std::copy(phi_u.at<CPU>(0, i0 + ib), phi_u.at<CPU>(0, i0 + ib) + ngv, psi.at<CPU>(0, 2 * ib));
+                    std::copy(phi_d.at<CPU>(0, i0 + ib), phi_d.at<CPU>(0, i0 + ib) + ngv, psi.at<CPU>(0, 2 * ib + 1));
+                }
+                /* phi_{u,d}(G) -> phi_{u,d}(r) */
+                fft_coarse_.transform_batch<1>(2 * nb, psi.at<CPU>(), psi.ld());
+                /* apply V_{uu}, V_{ud}, V_{du} and V_{dd} */
+                for (int ib = 0; ib < nb; ib++) {
+                    local_operator_kernels::mul_by_veff_spinor(fft_coarse_.local_size(), veff_vec_[0].f_rg().at<CPU>(),
+                                                               veff_vec_[1].f_rg().at<CPU>(),
+                                                               veff_vec_[2].f_rg().at<CPU>(),
+                                                               veff_vec_[3].f_rg().at<CPU>(),
+                                                               fft_coarse_.buffer_batch(2 * ib),
+                                                               fft_coarse_.buffer_batch(2 * ib + 1));
+                }
+                /* [V*phi]_{u,d}(r) -> [V*phi]_{u,d}(G) */
+                fft_coarse_.transform_batch<-1>(2 * nb, psi.at<CPU>(), psi.ld());
+                /* add kinetic energy */
+                for (int ib = 0; ib < nb; ib++) {
+                    local_operator_kernels::add_pw_ekin(ngv, 1.0, pw_ekin_.at<CPU>(), phi_u.at<CPU>(0, i0 + ib),
+                                                        psi.at<CPU>(0, 2 * ib), hphi_u.at<CPU>(0, i0 + ib));
+                    local_operator_kernels::add_pw_ekin(ngv, 1.0, pw_ekin_.at<CPU>(), phi_d.at<CPU>(0, i0 + ib),
+                                                        psi.at<CPU>(0, 2 * ib + 1), hphi_d.at<CPU>(0, i0 + ib));
+                }
+            }
+            first = num_wf_loc;
+        } else if (gkvec_p_->gvec().reduced()) {
+            /* If G-vectors are reduced, wave-functions are real and we can transform two of them at once.
+             * Non-collinear case is not treated here because nc wave-functions are complex and G+k vectors
              * can't be reduced */
-        if (gkvec_p_->gvec().reduced()) {
             int npairs = num_wf_loc / 2;
             /* Gamma-point case can only be non-magnetic or spin-collinear */
             for (int i = 0; i < npairs; i++) {
+                wait_phi(2 * i + 1);
                 /* phi(G) -> phi(r) */
                 phi_to_r(i, ispn__, true);
                 /* multiply by effective potential */
@@ -514,6 +697,7 @@ class Local_operator
 
         /* if we don't have G-vector reductions, first = 0 and we start a normal loop */
         for (int i = first; i < num_wf_loc; i++) {
+            wait_phi(i);
 
             /* non-collinear case */
             /* 2x2 Hamiltonian in applied to spinor wave-functions
@@ -537,7 +721,7 @@ class Local_operator
                  * | 3 | 1 |
                  * .---.---.
                  */
-            if (ispn__ == 2) {
+            if (ispn__ == 2) { /* GPU case; on CPU the spinors are handled by the batched branch above */
                 /* phi_u(G) -> phi_u(r) */
                 phi_to_r(i, 0);
                 /* save phi_u(r) */
@@ -634,11 +818,115 @@ class Local_operator
             }
         }
 
+        /* complete the remapping of phi (all bands have been received at this point) */
+        for (int ispn = 0; ispn < phi__.num_sc(); ispn++) {
+            phi__.pw_coeffs(ispn).remap_forward_end();
+        }
+
         for (int ispn = 0; ispn < hphi__.num_sc(); ispn++) {
             hphi__.pw_coeffs(ispn).remap_backward(ctx_.processing_unit(), n__, idx0__);
         }
     }
 
+    /// Apply local part of Hamiltonian together with the non-local D and Q operators in real space.
+    /** \param [in]    ispn    Index of spin (0 or 1).
+     *  \param [in]    phi     Input wave-functions.
+     *  \param [out]   hphi    Hamiltonian applied to wave-functions or nullptr.
+     *  \param [inout] sphi    S operator applied to wave-functions or nullptr; on input it must contain phi.
+     *  \param [in]    idx0    Starting index of wave-functions.
+     *  \param [in]    n       Number of wave-functions.
+     *  \param [in]    beta_rs Beta-projectors tabulated on the coarse FFT grid.
+     *  \param [in]    d_op    D-operator.
+     *  \param [in]    q_op    Q-operator.
+     *
+     *  The projections <beta|phi> are taken from the same phi(r) which is multiplied by the effective potential,
+     *  and the D-operator contribution is added to V(r)phi(r) before the backward transformation. The Q-operator
+     *  contribution requires one more backward transformation per band.
+     */
+    template <typename T>
+    void apply_h_s_rs(int ispn__, Wave_functions& phi__, Wave_functions* hphi__, Wave_functions* sphi__,
+                      int idx0__, int n__, Beta_projectors_rs const& beta_rs__, Non_local_operator<T>& d_op__,
+                      Non_local_operator<T>& q_op__)
+    {
+        PROFILE("sirius::Local_operator::apply_h_s_rs");
+
+        if (!gkvec_p_) {
+            TERMINATE("Local operator is not prepared");
+        }
+        if (fft_coarse_.pu() != CPU || ispn__ == 2) {
+            TERMINATE("real-space beta-projectors are implemented for spin-collinear case on CPU");
+        }
+
+        bool apply_q = (sphi__ != nullptr) && !q_op__.is_null();
+
+        if (hphi__ != nullptr) {
+            num_applied(n__);
+        }
+
+        /* remap wave-functions */
+        phi__.pw_coeffs(ispn__).remap_forward(CPU, n__, idx0__);
+        if (hphi__ != nullptr) {
+            hphi__->pw_coeffs(ispn__).set_num_extra(CPU, n__, idx0__);
+            hphi__->pw_coeffs(ispn__).extra().zero<memory_t::host>();
+        }
+        if (apply_q) {
+            sphi__->pw_coeffs(ispn__).remap_forward(CPU, n__, idx0__);
+        }
+
+        int nbeta = beta_rs__.num_beta();
+        std::vector<double_complex> beta_phi(nbeta);
+        std::vector<double_complex> coefs(nbeta);
+
+        auto& comm = fft_coarse_.comm();
+        int ngv    = gkvec_p_->gvec_count_fft();
+
+        auto& phi_extra = phi__.pw_coeffs(ispn__).extra();
+
+        /* local number of wave-functions in extra-storage distribution */
+        int num_wf_loc = phi__.pw_coeffs(ispn__).spl_num_col().local_size();
+
+        for (int i = 0; i < num_wf_loc; i++) {
+            /* phi(G) -> phi(r) */
+            fft_coarse_.transform<1>(phi_extra.at<CPU>(0, i));
+            /* <beta|phi> */
+            beta_rs__.inner(fft_coarse_.buffer().at<CPU>(), beta_phi.data());
+            if (comm.size() > 1) {
+                comm.allreduce(beta_phi.data(), nbeta);
+            }
+            if (hphi__ != nullptr) {
+                auto& hphi_extra = hphi__->pw_coeffs(ispn__).extra();
+                /* multiply by effective potential */
+                local_operator_kernels::mul_by_veff(fft_coarse_.local_size(), veff_vec_[ispn__].f_rg().at<CPU>(),
+                                                    fft_coarse_.buffer().at<CPU>());
+                /* add D|beta><beta|phi> */
+                beta_rs__.apply_op(d_op__, ispn__, beta_phi.data(), coefs.data());
+                beta_rs__.add(coefs.data(), fft_coarse_.buffer().at<CPU>());
+                /* [V*phi + D*phi](G) */
+                fft_coarse_.transform<-1>(vphi1_.at<CPU>());
+                /* add kinetic energy */
+                local_operator_kernels::add_pw_ekin(ngv, 1.0, pw_ekin_.at<CPU>(), phi_extra.at<CPU>(0, i),
+                                                    vphi1_.at<CPU>(), hphi_extra.at<CPU>(0, i));
+            }
+            if (apply_q) {
+                auto& sphi_extra = sphi__->pw_coeffs(ispn__).extra();
+                /* Q|beta><beta|phi> */
+                fft_coarse_.buffer().zero();
+                beta_rs__.apply_op(q_op__, ispn__, beta_phi.data(), coefs.data());
+                beta_rs__.add(coefs.data(), fft_coarse_.buffer().at<CPU>());
+                fft_coarse_.transform<-1>(vphi1_.at<CPU>());
+                local_operator_kernels::add_pw_ekin(ngv, 0.0, pw_ekin_.at<CPU>(), phi_extra.at<CPU>(0, i),
+                                                    vphi1_.at<CPU>(), sphi_extra.at<CPU>(0, i));
+            }
+        }
+
+        if (hphi__ != nullptr) {
+            hphi__->pw_coeffs(ispn__).remap_backward(CPU, n__, idx0__);
+        }
+        if (apply_q) {
+            sphi__->pw_coeffs(ispn__).remap_backward(CPU, n__, idx0__);
+        }
+    }
+
     void apply_h_o(int             N__,
                    int             n__,
                    Wave_functions& phi__,
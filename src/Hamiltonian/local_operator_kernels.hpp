@@ -0,0 +1,328 @@
+// Copyright (c) 2013-2018 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file local_operator_kernels.hpp
+ *
+ *  \brief CPU kernels of the local part of the Hamiltonian.
+ *
+ *  The kernels work on raw contiguous arrays of interleaved (std::complex) or split (real and imaginary parts
+ *  stored separately) data. Interleaved complex data is processed with AVX-512 or AVX2 intrinsics when the
+ *  compiler targets these instruction sets; otherwise a scalar loop is left to the compiler. Each kernel is a single
+ *  OpenMP-parallel sweep over the arrays. The kernels are the CPU counterparts of mul_by_veff_gpu() and
+ *  add_pw_ekin_gpu().
+ */
+
+#ifndef __LOCAL_OPERATOR_KERNELS_HPP__
+#define __LOCAL_OPERATOR_KERNELS_HPP__
+
+#include <omp.h>
+#include <complex>
+#include <algorithm>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace sirius {
+
+namespace local_operator_kernels {
+
+/// Run a function on the contiguous ranges [i0, i1) of the index space [0, n) assigned to OpenMP threads.
+/** The ranges start at multiples of 8 elements, so that each thread stays on its own cache lines. */
+template <typename F>
+inline void parallel_for_range(int n__, F&& f__)
+{
+    #pragma omp parallel
+    {
+        int nt    = omp_get_num_threads();
+        int tid   = omp_get_thread_num();
+        int chunk = ((n__ + nt - 1) / nt + 7) / 8 * 8;
+        int i0    = std::min(n__, tid * chunk);
+        int i1    = std::min(n__, i0 + chunk);
+        if (i1 > i0) {
+            f__(i0, i1);
+        }
+    }
+}
+
+/// Multiply a range of complex values by a real function: buf[i] *= v[i].
+/** Real and imaginary parts are interleaved in buf. */
+inline void mul_by_veff_range(int i0__, int i1__, double const* v__, double* buf__)
+{
+    int i = i0__;
+#if defined(__AVX512F__)
+    __m512i idx = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+    for (; i + 4 <= i1__; i += 4) {
+        __m512d v = _mm512_permutexvar_pd(idx, _mm512_castpd256_pd512(_mm256_loadu_pd(v__ + i)));
+        _mm512_storeu_pd(buf__ + 2 * i, _mm512_mul_pd(_mm512_loadu_pd(buf__ + 2 * i), v));
+    }
+#elif defined(__AVX2__)
+    for (; i + 2 <= i1__; i += 2) {
+        __m256d v = _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(v__ + i)), 0x50);
+        _mm256_storeu_pd(buf__ + 2 * i, _mm256_mul_pd(_mm256_loadu_pd(buf__ + 2 * i), v));
+    }
+#endif
+    for (; i < i1__; i++) {
+        buf__[2 * i]     *= v__[i];
+        buf__[2 * i + 1] *= v__[i];
+    }
+}
+
+/// Multiply a range of complex values by a complex function: buf[i] *= (a[i] + i * pref * b[i]).
+inline void mul_by_cmplx_range(int i0__, int i1__, double const* a__, double const* b__, double pref__, double* buf__)
+{
+    int i = i0__;
+#if defined(__AVX512F__)
+    __m512i idx   = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+    __m512d vpref = _mm512_set1_pd(pref__);
+    for (; i + 4 <= i1__; i += 4) {
+        __m512d a  = _mm512_permutexvar_pd(idx, _mm512_castpd256_pd512(_mm256_loadu_pd(a__ + i)));
+        __m512d b  = _mm512_mul_pd(vpref, _mm512_permutexvar_pd(idx, _mm512_castpd256_pd512(_mm256_loadu_pd(b__ + i))));
+        __m512d z  = _mm512_loadu_pd(buf__ + 2 * i);
+        /* swap real and imaginary parts */
+        __m512d zs = _mm512_permute_pd(z, 0x55);
+        /* (re * a - im * b, im * a + re * b) */
+        _mm512_storeu_pd(buf__ + 2 * i, _mm512_fmaddsub_pd(z, a, _mm512_mul_pd(zs, b)));
+    }
+#elif defined(__AVX2__)
+    __m256d vpref = _mm256_set1_pd(pref__);
+    for (; i + 2 <= i1__; i += 2) {
+        __m256d a  = _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(a__ + i)), 0x50);
+        __m256d b  = _mm256_mul_pd(vpref, _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(b__ + i)), 0x50));
+        __m256d z  = _mm256_loadu_pd(buf__ + 2 * i);
+        __m256d zs = _mm256_permute_pd(z, 0x5);
+        _mm256_storeu_pd(buf__ + 2 * i, _mm256_addsub_pd(_mm256_mul_pd(z, a), _mm256_mul_pd(zs, b)));
+    }
+#endif
+    for (; i < i1__; i++) {
+        double re = buf__[2 * i];
+        double im = buf__[2 * i + 1];
+        double b  = pref__ * b__[i];
+        buf__[2 * i]     = re * a__[i] - im * b;
+        buf__[2 * i + 1] = im * a__[i] + re * b;
+    }
+}
+
+/// Apply the 2x2 matrix of the potential to a range of spinor components in place.
+/** Computes
+ *  \f[
+ *    \psi_u \leftarrow V_{uu} \psi_u + (B_x - i B_y) \psi_d, \quad
+ *    \psi_d \leftarrow (B_x + i B_y) \psi_u + V_{dd} \psi_d
+ *  \f]
+ *  Real and imaginary parts are interleaved in psi_u and psi_d.
+ */
+inline void mul_by_veff_spinor_range(int i0__, int i1__, double const* vuu__, double const* vdd__, double const* bx__,
+                                     double const* by__, double* psi_u__, double* psi_d__)
+{
+    int i = i0__;
+#if defined(__AVX512F__)
+    __m512i idx = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+    auto dup    = [&](double const* x) { return _mm512_permutexvar_pd(idx, _mm512_castpd256_pd512(_mm256_loadu_pd(x))); };
+    for (; i + 4 <= i1__; i += 4) {
+        __m512d vuu = dup(vuu__ + i);
+        __m512d vdd = dup(vdd__ + i);
+        __m512d bx  = dup(bx__ + i);
+        __m512d by  = dup(by__ + i);
+        __m512d u   = _mm512_loadu_pd(psi_u__ + 2 * i);
+        __m512d d   = _mm512_loadu_pd(psi_d__ + 2 * i);
+        /* swap real and imaginary parts */
+        __m512d us = _mm512_permute_pd(u, 0x55);
+        __m512d ds = _mm512_permute_pd(d, 0x55);
+        /* (Bx - i By) * psi_d and (Bx + i By) * psi_u */
+        __m512d bd = _mm512_fmaddsub_pd(d, bx, _mm512_mul_pd(ds, _mm512_sub_pd(_mm512_setzero_pd(), by)));
+        __m512d bu = _mm512_fmaddsub_pd(u, bx, _mm512_mul_pd(us, by));
+        _mm512_storeu_pd(psi_u__ + 2 * i, _mm512_fmadd_pd(vuu, u, bd));
+        _mm512_storeu_pd(psi_d__ + 2 * i, _mm512_fmadd_pd(vdd, d, bu));
+    }
+#elif defined(__AVX2__)
+    auto dup = [&](double const* x) { return _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(x)), 0x50); };
+    for (; i + 2 <= i1__; i += 2) {
+        __m256d vuu = dup(vuu__ + i);
+        __m256d vdd = dup(vdd__ + i);
+        __m256d bx  = dup(bx__ + i);
+        __m256d by  = dup(by__ + i);
+        __m256d u   = _mm256_loadu_pd(psi_u__ + 2 * i);
+        __m256d d   = _mm256_loadu_pd(psi_d__ + 2 * i);
+        __m256d us  = _mm256_permute_pd(u, 0x5);
+        __m256d ds  = _mm256_permute_pd(d, 0x5);
+        __m256d bd  = _mm256_addsub_pd(_mm256_mul_pd(d, bx), _mm256_mul_pd(ds, _mm256_sub_pd(_mm256_setzero_pd(), by)));
+        __m256d bu  = _mm256_addsub_pd(_mm256_mul_pd(u, bx), _mm256_mul_pd(us, by));
+        _mm256_storeu_pd(psi_u__ + 2 * i, _mm256_add_pd(_mm256_mul_pd(vuu, u), bd));
+        _mm256_storeu_pd(psi_d__ + 2 * i, _mm256_add_pd(_mm256_mul_pd(vdd, d), bu));
+    }
+#endif
+    for (; i < i1__; i++) {
+        double ur = psi_u__[2 * i];
+        double ui = psi_u__[2 * i + 1];
+        double dr = psi_d__[2 * i];
+        double di = psi_d__[2 * i + 1];
+        psi_u__[2 * i]     = vuu__[i] * ur + bx__[i] * dr + by__[i] * di;
+        psi_u__[2 * i + 1] = vuu__[i] * ui + bx__[i] * di - by__[i] * dr;
+        psi_d__[2 * i]     = vdd__[i] * dr + bx__[i] * ur - by__[i] * ui;
+        psi_d__[2 * i + 1] = vdd__[i] * di + bx__[i] * ui + by__[i] * ur;
+    }
+}
+
+/// Add kinetic and potential terms to a range of plane-wave coefficients: hphi[i] += alpha * ekin[i] * phi[i] + vphi[i].
+/** If with_vphi is false, vphi is not accessed and only the kinetic term is added. */
+template <bool with_vphi>
+inline void add_pw_ekin_range(int i0__, int i1__, double alpha__, double const* ekin__, double const* phi__,
+                              double const* vphi__, double* hphi__)
+{
+    int i = i0__;
+#if defined(__AVX512F__)
+    __m512i idx    = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+    __m512d valpha = _mm512_set1_pd(alpha__);
+    for (; i + 4 <= i1__; i += 4) {
+        __m512d e = _mm512_permutexvar_pd(idx, _mm512_castpd256_pd512(_mm256_loadu_pd(ekin__ + i)));
+        __m512d h = _mm512_loadu_pd(hphi__ + 2 * i);
+        if (with_vphi) {
+            h = _mm512_add_pd(h, _mm512_loadu_pd(vphi__ + 2 * i));
+        }
+        h = _mm512_fmadd_pd(_mm512_mul_pd(e, valpha), _mm512_loadu_pd(phi__ + 2 * i), h);
+        _mm512_storeu_pd(hphi__ + 2 * i, h);
+    }
+#elif defined(__AVX2__)
+    __m256d valpha = _mm256_set1_pd(alpha__);
+    for (; i + 2 <= i1__; i += 2) {
+        __m256d e = _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(ekin__ + i)), 0x50);
+        __m256d h = _mm256_loadu_pd(hphi__ + 2 * i);
+        if (with_vphi) {
+            h = _mm256_add_pd(h, _mm256_loadu_pd(vphi__ + 2 * i));
+        }
+        h = _mm256_add_pd(h, _mm256_mul_pd(_mm256_mul_pd(e, valpha), _mm256_loadu_pd(phi__ + 2 * i)));
+        _mm256_storeu_pd(hphi__ + 2 * i, h);
+    }
+#endif
+    for (; i < i1__; i++) {
+        double e = alpha__ * ekin__[i];
+        hphi__[2 * i]     += e * phi__[2 * i];
+        hphi__[2 * i + 1] += e * phi__[2 * i + 1];
+        if (with_vphi) {
+            hphi__[2 * i]     += vphi__[2 * i];
+            hphi__[2 * i + 1] += vphi__[2 * i + 1];
+        }
+    }
+}
+
+/// Multiply complex function by the effective potential in place: buf(r) *= V(r).
+inline void mul_by_veff(int n__, double const* veff__, std::complex<double>* buf__)
+{
+    parallel_for_range(n__, [&](int i0, int i1) {
+        mul_by_veff_range(i0, i1, veff__, reinterpret_cast<double*>(buf__));
+    });
+}
+
+/// Multiply complex function stored as separate real and imaginary parts by the effective potential in place.
+inline void mul_by_veff(int n__, double const* veff__, double* re__, double* im__)
+{
+    parallel_for_range(n__, [&](int i0, int i1) {
+        #pragma omp simd
+        for (int i = i0; i < i1; i++) {
+            re__[i] *= veff__[i];
+            im__[i] *= veff__[i];
+        }
+    });
+}
+
+/// Multiply a block of complex functions by the effective potential in place.
+/** Each value of the potential is loaded once for the whole block. */
+inline void mul_by_veff(int n__, double const* veff__, int nb__, std::complex<double>* const* buf__)
+{
+    parallel_for_range(n__, [&](int i0, int i1) {
+        /* process the range in pieces that stay in L1 cache */
+        const int piece = 512;
+        for (int j0 = i0; j0 < i1; j0 += piece) {
+            int j1 = std::min(i1, j0 + piece);
+            for (int ib = 0; ib < nb__; ib++) {
+                mul_by_veff_range(j0, j1, veff__, reinterpret_cast<double*>(buf__[ib]));
+            }
+        }
+    });
+}
+
+/// Multiply complex function by the off-diagonal magnetic field in place: buf(r) *= (Bx(r) + i * pref * By(r)).
+inline void mul_by_bxy(int n__, double const* bx__, double const* by__, double pref__, std::complex<double>* buf__)
+{
+    parallel_for_range(n__, [&](int i0, int i1) {
+        mul_by_cmplx_range(i0, i1, bx__, by__, pref__, reinterpret_cast<double*>(buf__));
+    });
+}
+
+/// Apply the full 2x2 potential matrix to the spinor components of a wave-function in one sweep.
+/** \param [in]    n     Number of real-space points.
+ *  \param [in]    vuu   Potential of the up-up block (V + Bz).
+ *  \param [in]    vdd   Potential of the dn-dn block (V - Bz).
+ *  \param [in]    bx    x-component of the magnetic field.
+ *  \param [in]    by    y-component of the magnetic field.
+ *  \param [inout] psi_u Up-component of the spinor.
+ *  \param [inout] psi_d Dn-component of the spinor.
+ */
+inline void mul_by_veff_spinor(int n__, double const* vuu__, double const* vdd__, double const* bx__,
+                               double const* by__, std::complex<double>* psi_u__, std::complex<double>* psi_d__)
+{
+    parallel_for_range(n__, [&](int i0, int i1) {
+        mul_by_veff_spinor_range(i0, i1, vuu__, vdd__, bx__, by__, reinterpret_cast<double*>(psi_u__),
+                                 reinterpret_cast<double*>(psi_d__));
+    });
+}
+
+/// Add kinetic energy and potential terms to the plane-wave coefficients in one sweep.
+/** \param [in]    n     Number of plane-wave coefficients.
+ *  \param [in]    alpha Scaling factor of the kinetic energy (0 or 1).
+ *  \param [in]    ekin  Kinetic energy of plane waves.
+ *  \param [in]    phi   Plane-wave coefficients of the wave-function.
+ *  \param [in]    vphi  Plane-wave coefficients of V*phi or nullptr if V*phi is already stored in hphi.
+ *  \param [inout] hphi  Plane-wave coefficients of H*phi.
+ *
+ *  Computes hphi(G) += alpha * ekin(G) * phi(G) + vphi(G).
+ */
+inline void add_pw_ekin(int n__, double alpha__, double const* ekin__, std::complex<double> const* phi__,
+                        std::complex<double> const* vphi__, std::complex<double>* hphi__)
+{
+    parallel_for_range(n__, [&](int i0, int i1) {
+        auto phi  = reinterpret_cast<double const*>(phi__);
+        auto vphi = reinterpret_cast<double const*>(vphi__);
+        auto hphi = reinterpret_cast<double*>(hphi__);
+        if (vphi) {
+            add_pw_ekin_range<true>(i0, i1, alpha__, ekin__, phi, vphi, hphi);
+        } else {
+            add_pw_ekin_range<false>(i0, i1, alpha__, ekin__, phi, vphi, hphi);
+        }
+    });
+}
+
+/// Add kinetic energy term to the plane-wave coefficients stored as separate real and imaginary parts.
+inline void add_pw_ekin(int n__, double alpha__, double const* ekin__, double const* phi_re__, double const* phi_im__,
+                        double const* vphi_re__, double const* vphi_im__, double* hphi_re__, double* hphi_im__)
+{
+    parallel_for_range(n__, [&](int i0, int i1) {
+        #pragma omp simd
+        for (int i = i0; i < i1; i++) {
+            double e = alpha__ * ekin__[i];
+            hphi_re__[i] += e * phi_re__[i] + vphi_re__[i];
+            hphi_im__[i] += e * phi_im__[i] + vphi_im__[i];
+        }
+    });
+}
+
+} // namespace local_operator_kernels
+
+} // namespace sirius
+
+#endif // __LOCAL_OPERATOR_KERNELS_HPP__
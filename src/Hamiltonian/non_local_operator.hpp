@@ -27,6 +27,7 @@
 
 #include "Beta_projectors/beta_projectors.hpp"
 #include "simulation_context.h"
+#include "non_local_operator_kernels.hpp"
 
 namespace sirius {
 
@@ -96,6 +97,49 @@ class Non_local_operator
                                    matrix<T>& beta_phi__,
                                    int i);
 
+        /// Compute O * <beta|phi> for the atoms of a chunk on CPU.
+        /** The result is stored in a (num_beta x n) matrix with the leading dimension equal to the number of
+         *  beta-projectors in the chunk. */
+        template <int N>
+        inline void apply_to_beta_phi(int chunk__,
+                                      int ispn_block__,
+                                      int n__,
+                                      Beta_projectors_base<N>& beta_,
+                                      matrix<T>& beta_phi__,
+                                      T* op_beta_phi__)
+        {
+            int nbeta = beta_.chunk(chunk__).num_beta_;
+            int na    = beta_.chunk(chunk__).num_atoms_;
+            /* split the columns into blocks if there are fewer atoms than threads */
+            int nblk = std::max(1, std::min((n__ + 15) / 16, (omp_get_max_threads() + na - 1) / na));
+
+            #pragma omp parallel for schedule(static)
+            for (int t = 0; t < na * nblk; t++) {
+                int i  = t / nblk;
+                int j0 = n__ * (t % nblk) / nblk;
+                int j1 = n__ * (t % nblk + 1) / nblk;
+                /* number of beta functions for a given atom */
+                int nbf  = beta_.chunk(chunk__).desc_(beta_desc_idx::nbf, i);
+                int offs = beta_.chunk(chunk__).desc_(beta_desc_idx::offset, i);
+                int ia   = beta_.chunk(chunk__).desc_(beta_desc_idx::ia, i);
+                non_local_operator_kernels::apply_atom_block(nbf, j1 - j0,
+                                                             op_.template at<CPU>(packed_mtrx_offset_(ia), ispn_block__),
+                                                             beta_phi__.template at<CPU>(offs, j0), nbeta,
+                                                             op_beta_phi__ + offs + static_cast<size_t>(nbeta) * j0,
+                                                             nbeta);
+            }
+        }
+
+        inline bool is_null() const
+        {
+            return is_null_;
+        }
+
+        inline device_t pu() const
+        {
+            return pu_;
+        }
+
         inline T operator()(int xi1__, int xi2__, int ia__)
         {
             return (*this)(xi1__, xi2__, 0, ia__);
@@ -138,26 +182,24 @@ inline void Non_local_operator<double_complex>::apply(int chunk__,
         #endif
     }
     /* compute O * <beta|phi> for atoms in a chunk */
-    #pragma omp parallel for
-    for (int i = 0; i < beta_.chunk(chunk__).num_atoms_; i++) {
-        /* number of beta functions for a given atom */
-        int nbf  = beta_.chunk(chunk__).desc_(beta_desc_idx::nbf, i);
-        int offs = beta_.chunk(chunk__).desc_(beta_desc_idx::offset, i);
-        int ia   = beta_.chunk(chunk__).desc_(beta_desc_idx::ia, i);
-        switch (pu_) {
-            case CPU: {
-                linalg<CPU>::gemm(0, 0, nbf, n__, nbf, op_.at<CPU>(packed_mtrx_offset_(ia), ispn_block__), nbf,
-                                  beta_phi__.at<CPU>(offs, 0), nbeta, work_.at<CPU>(offs), nbeta);
-
-                break;
-            }
-            case GPU: {
-                #ifdef __GPU
+    switch (pu_) {
+        case CPU: {
+            apply_to_beta_phi(chunk__, ispn_block__, n__, beta_, beta_phi__, work_.at<CPU>());
+            break;
+        }
+        case GPU: {
+            #ifdef __GPU
+            #pragma omp parallel for
+            for (int i = 0; i < beta_.chunk(chunk__).num_atoms_; i++) {
+                /* number of beta functions for a given atom */
+                int nbf  = beta_.chunk(chunk__).desc_(beta_desc_idx::nbf, i);
+                int offs = beta_.chunk(chunk__).desc_(beta_desc_idx::offset, i);
+                int ia   = beta_.chunk(chunk__).desc_(beta_desc_idx::ia, i);
                 linalg<GPU>::gemm(0, 0, nbf, n__, nbf, op_.at<GPU>(packed_mtrx_offset_(ia), ispn_block__), nbf,
                                   beta_phi__.at<GPU>(offs, 0), nbeta, work_.at<GPU>(offs), nbeta, omp_get_thread_num());
-                #endif
-                break;
             }
+            #endif
+            break;
         }
     }
 
@@ -296,26 +338,24 @@ inline void Non_local_operator<double>::apply(int chunk__,
     }
 
     /* compute O * <beta|phi> */
-    #pragma omp parallel for
-    for (int i = 0; i < beta_.chunk(chunk__).num_atoms_; i++) {
-        /* number of beta functions for a given atom */
-        int nbf  = beta_.chunk(chunk__).desc_(beta_desc_idx::nbf, i);
-        int offs = beta_.chunk(chunk__).desc_(beta_desc_idx::offset, i);
-        int ia   = beta_.chunk(chunk__).desc_(beta_desc_idx::ia, i);
-
-        switch (pu_) {
-            case CPU: {
-                linalg<CPU>::gemm(0, 0, nbf, n__, nbf, op_.at<CPU>(packed_mtrx_offset_(ia), ispn_block__), nbf,
-                                  beta_phi__.at<CPU>(offs, 0), nbeta, work_.at<CPU>(offs), nbeta);
-                break;
-            }
-            case GPU: {
-                #ifdef __GPU
+    switch (pu_) {
+        case CPU: {
+            apply_to_beta_phi(chunk__, ispn_block__, n__, beta_, beta_phi__, work_.at<CPU>());
+            break;
+        }
+        case GPU: {
+            #ifdef __GPU
+            #pragma omp parallel for
+            for (int i = 0; i < beta_.chunk(chunk__).num_atoms_; i++) {
+                /* number of beta functions for a given atom */
+                int nbf  = beta_.chunk(chunk__).desc_(beta_desc_idx::nbf, i);
+                int offs = beta_.chunk(chunk__).desc_(beta_desc_idx::offset, i);
+                int ia   = beta_.chunk(chunk__).desc_(beta_desc_idx::ia, i);
                 linalg<GPU>::gemm(0, 0, nbf, n__, nbf, op_.at<GPU>(packed_mtrx_offset_(ia), ispn_block__), nbf,
                                   beta_phi__.at<GPU>(offs, 0), nbeta, work_.at<GPU>(offs), nbeta, omp_get_thread_num());
-                break;
-                #endif
             }
+            #endif
+            break;
         }
     }
 
@@ -358,6 +398,90 @@ inline void Non_local_operator<double>::apply_one_atom(int chunk__,
 {
 }
 
+/// Spin block of a non-local operator and the wave-functions to which the result is added.
+template <typename T>
+struct non_local_block_t
+{
+    /// Non-local operator (D or Q).
+    Non_local_operator<T>* op_;
+    /// Spin block of the operator; the first bit is the spin component of op_phi which is updated.
+    int ispn_block_;
+    /// Output wave-functions.
+    Wave_functions* op_phi_;
+};
+
+/// Apply D and Q operators to the same <beta|phi> with a single multiplication by the beta-projectors.
+/** The products O * <beta|phi> of all blocks are stacked into one (num_beta x n * num_blocks) matrix which is
+ *  multiplied by <G+k|beta> in one GEMM; the panels of the result are then added to hphi and sphi. Compared to the
+ *  separate Non_local_operator::apply() calls the large matrix of beta-projectors is passed only once. On GPU the
+ *  operators are applied one by one. The work buffer is taken from the memory pool and released on exit. */
+template <typename T, int N>
+inline void apply_dq(memory_pool& mp__,
+                     int chunk__,
+                     std::vector<non_local_block_t<T>> const& blocks__,
+                     int idx0__,
+                     int n__,
+                     Beta_projectors_base<N>& beta_,
+                     matrix<T>& beta_phi__)
+{
+    PROFILE("sirius::apply_dq");
+
+    std::vector<non_local_block_t<T>> blocks;
+    for (auto& b: blocks__) {
+        if (!b.op_->is_null()) {
+            blocks.push_back(b);
+        }
+    }
+    if (blocks.empty()) {
+        return;
+    }
+
+    if (blocks[0].op_->pu() == GPU || blocks.size() == 1) {
+        for (auto& b: blocks) {
+            b.op_->apply(chunk__, b.ispn_block_, *b.op_phi_, idx0__, n__, beta_, beta_phi__);
+        }
+        return;
+    }
+
+    /* in case of real wave-functions the complex coefficients are treated as pairs of real numbers */
+    int nc = std::is_same<T, double>::value ? 2 : 1;
+
+    auto& beta_gk     = beta_.pw_coeffs_a();
+    int num_gkvec_loc = beta_.num_gkvec_loc();
+    int nbeta         = beta_.chunk(chunk__).num_beta_;
+    int nb            = static_cast<int>(blocks.size());
+
+    T* work = mp__.allocate<T, memory_t::host>(static_cast<size_t>(nbeta) * n__ * nb +
+                                               static_cast<size_t>(nc) * num_gkvec_loc * n__ * nb);
+    T* op_phi = work + static_cast<size_t>(nbeta) * n__ * nb;
+
+    /* compute [O_1 * <beta|phi> | O_2 * <beta|phi> | ...] */
+    for (int ib = 0; ib < nb; ib++) {
+        blocks[ib].op_->apply_to_beta_phi(chunk__, blocks[ib].ispn_block_, n__, beta_, beta_phi__,
+                                          work + static_cast<size_t>(nbeta) * n__ * ib);
+    }
+
+    /* compute <G+k|beta> * [O_1 * <beta|phi> | O_2 * <beta|phi> | ...] */
+    linalg<CPU>::gemm(0, 0, nc * num_gkvec_loc, n__ * nb, nbeta, linalg_const<T>::one(),
+                      reinterpret_cast<T*>(beta_gk.template at<CPU>()), nc * num_gkvec_loc, work, nbeta,
+                      linalg_const<T>::zero(), op_phi, nc * num_gkvec_loc);
+
+    /* add panels to the output wave-functions */
+    for (int ib = 0; ib < nb; ib++) {
+        auto& wf = blocks[ib].op_phi_->pw_coeffs(blocks[ib].ispn_block_ & 1).prime();
+        int ld = nc * wf.ld();
+        T* out = reinterpret_cast<T*>(wf.template at<CPU>(0, idx0__));
+        T const* in = op_phi + static_cast<size_t>(nc) * num_gkvec_loc * n__ * ib;
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n__; i++) {
+            for (int ig = 0; ig < nc * num_gkvec_loc; ig++) {
+                out[ig + static_cast<size_t>(ld) * i] += in[ig + static_cast<size_t>(nc) * num_gkvec_loc * i];
+            }
+        }
+    }
+    mp__.free<memory_t::host>(work);
+}
+
 template <typename T>
 class D_operator : public Non_local_operator<T>
 {
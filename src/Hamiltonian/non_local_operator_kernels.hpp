@@ -0,0 +1,139 @@
+// Copyright (c) 2013-2018 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file non_local_operator_kernels.hpp
+ *
+ *  \brief CPU kernels for the atomic blocks of the non-local operators.
+ *
+ *  The D and Q operators are block-diagonal in atoms; each block is a small (nbf x nbf) matrix, where nbf is the
+ *  number of beta-projectors of the atom. The product of a block with a panel of <beta|phi> is too small to
+ *  amortize the overhead of a BLAS call, so the common block sizes are handled by loops with the size known at
+ *  compile time. Other sizes fall back to BLAS.
+ */
+
+#ifndef __NON_LOCAL_OPERATOR_KERNELS_HPP__
+#define __NON_LOCAL_OPERATOR_KERNELS_HPP__
+
+#include <complex>
+#include "linalg.hpp"
+
+namespace sirius {
+
+namespace non_local_operator_kernels {
+
+/// Compute C = A * B for a (NBF x NBF) real matrix A and n columns of B.
+template <int NBF>
+inline void small_gemm(int n__, double const* a__, double const* b__, int ldb__, double* c__, int ldc__)
+{
+    for (int j = 0; j < n__; j++) {
+        double const* b = b__ + static_cast<size_t>(ldb__) * j;
+        double c[NBF];
+        for (int i = 0; i < NBF; i++) {
+            c[i] = 0;
+        }
+        for (int k = 0; k < NBF; k++) {
+            double bk = b[k];
+            #pragma omp simd
+            for (int i = 0; i < NBF; i++) {
+                c[i] += a__[i + k * NBF] * bk;
+            }
+        }
+        double* cj = c__ + static_cast<size_t>(ldc__) * j;
+        for (int i = 0; i < NBF; i++) {
+            cj[i] = c[i];
+        }
+    }
+}
+
+/// Compute C = A * B for a (NBF x NBF) complex matrix A and n columns of B.
+/** The matrix A is split into real and imaginary parts once, so that the inner loop is vectorized without
+ *  shuffles; the complex products are expanded explicitly. */
+template <int NBF>
+inline void small_gemm(int n__, std::complex<double> const* a__, std::complex<double> const* b__, int ldb__,
+                       std::complex<double>* c__, int ldc__)
+{
+    double are[NBF * NBF];
+    double aim[NBF * NBF];
+    for (int i = 0; i < NBF * NBF; i++) {
+        are[i] = a__[i].real();
+        aim[i] = a__[i].imag();
+    }
+    for (int j = 0; j < n__; j++) {
+        std::complex<double> const* b = b__ + static_cast<size_t>(ldb__) * j;
+        double cre[NBF];
+        double cim[NBF];
+        for (int i = 0; i < NBF; i++) {
+            cre[i] = 0;
+            cim[i] = 0;
+        }
+        for (int k = 0; k < NBF; k++) {
+            double bre = b[k].real();
+            double bim = b[k].imag();
+            #pragma omp simd
+            for (int i = 0; i < NBF; i++) {
+                cre[i] += are[i + k * NBF] * bre - aim[i + k * NBF] * bim;
+                cim[i] += are[i + k * NBF] * bim + aim[i + k * NBF] * bre;
+            }
+        }
+        std::complex<double>* cj = c__ + static_cast<size_t>(ldc__) * j;
+        for (int i = 0; i < NBF; i++) {
+            cj[i] = std::complex<double>(cre[i], cim[i]);
+        }
+    }
+}
+
+/// Compute C = A * B for the atomic block A of size (nbf x nbf) and n columns of B.
+/** The block sizes 4 (s, p), 8 (two s, p channels), 13 (two s, p and one d channel), 18 (two s, p, d channels)
+ *  and 26 (two s, p, d channels and one f channel) are specialized at compile time. */
+template <typename T>
+inline void apply_atom_block(int nbf__, int n__, T const* a__, T const* b__, int ldb__, T* c__, int ldc__)
+{
+    switch (nbf__) {
+        case 4: {
+            small_gemm<4>(n__, a__, b__, ldb__, c__, ldc__);
+            break;
+        }
+        case 8: {
+            small_gemm<8>(n__, a__, b__, ldb__, c__, ldc__);
+            break;
+        }
+        case 13: {
+            small_gemm<13>(n__, a__, b__, ldb__, c__, ldc__);
+            break;
+        }
+        case 18: {
+            small_gemm<18>(n__, a__, b__, ldb__, c__, ldc__);
+            break;
+        }
+        case 26: {
+            small_gemm<26>(n__, a__, b__, ldb__, c__, ldc__);
+            break;
+        }
+        default: {
+            linalg<CPU>::gemm(0, 0, nbf__, n__, nbf__, a__, nbf__, b__, ldb__, c__, ldc__);
+            break;
+        }
+    }
+}
+
+} // namespace non_local_operator_kernels
+
+} // namespace sirius
+
+#endif // __NON_LOCAL_OPERATOR_KERNELS_HPP__
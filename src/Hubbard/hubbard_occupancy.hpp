@@ -81,6 +81,8 @@ void Hubbard::hubbard_compute_occupation_numbers(K_point_set& kset_)
     for (int ikloc = 0; ikloc < kset_.spl_num_kpoints().local_size(); ikloc++) {
         int  ik = kset_.spl_num_kpoints(ikloc);
         auto kp = kset_[ik];
+        /* read wave-functions of the next k-point from the out-of-core store while this one is processed */
+        kset_.prefetch_wave_functions(ikloc, false);
         #ifdef __GPU
         if (ctx_.processing_unit() == GPU) {
             for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
@@ -129,6 +131,7 @@ void Hubbard::hubbard_compute_occupation_numbers(K_point_set& kset_)
             dm.copy<memory_t::device, memory_t::host>();
         }
         #endif
+        kp->page_out_wave_functions();
 
         // compute O'_{nk,j} = O_{nk,j} * f_{nk}
         // NO summation over band yet
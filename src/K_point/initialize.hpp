@@ -158,6 +158,10 @@ inline void K_point::initialize()
         spinor_wave_functions_ = std::unique_ptr<Wave_functions>(new Wave_functions(gkvec_partition(), nst, ctx_.num_spins()));
     }
 
+    /* new wave-functions are not yet in the out-of-core store */
+    wf_store_     = nullptr;
+    wf_store_idx_ = -1;
+
     if (ctx_.processing_unit() == GPU && keep_wf_on_gpu) {
         /* allocate GPU memory */
         for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
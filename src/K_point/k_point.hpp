@@ -27,6 +27,7 @@
 
 #include "matching_coefficients.h"
 #include "Beta_projectors/beta_projectors.hpp"
+#include "Beta_projectors/beta_projectors_rs.hpp"
 #include "wave_functions.hpp"
 
 namespace sirius {
@@ -83,6 +84,12 @@ class K_point
         /// Two-component (spinor) wave functions describing the bands.
         std::unique_ptr<Wave_functions> spinor_wave_functions_{nullptr};
 
+        /// Out-of-core store of the spinor wave functions (not used if null).
+        Wave_functions_store* wf_store_{nullptr};
+
+        /// Index of the spinor wave functions in the out-of-core store.
+        int wf_store_idx_{-1};
+
         /// Two-component (spinor) hubbard wave functions where the S matrix is applied (if ppus).
         std::unique_ptr<Wave_functions> hubbard_wave_functions_{nullptr};
 
@@ -167,6 +174,10 @@ class K_point
         /** Used to setup the full Hamiltonian in PP-PW case (for verification purpose only) */
         std::unique_ptr<Beta_projectors> beta_projectors_col_{nullptr};
 
+        /// Beta projectors tabulated on the coarse real-space grid.
+        /** Created only if the real-space application of the non-local operator is requested. */
+        std::unique_ptr<Beta_projectors_rs> beta_projectors_rs_{nullptr};
+
         /// Preconditioner matrix for Chebyshev solver.
         mdarray<double_complex, 3> p_mtrx_;
 
@@ -304,6 +315,13 @@ class K_point
 
                 }
 
+                /* the cases which are not supported by the real-space projectors are sorted out by
+                   Simulation_context::initialize() */
+                if (ctx_.control().beta_real_space_) {
+                    beta_projectors_rs_ = std::unique_ptr<Beta_projectors_rs>(
+                        new Beta_projectors_rs(ctx_, ctx_.fft_coarse(), vk_));
+                }
+
                 //if (false) {
                 //    p_mtrx_ = mdarray<double_complex, 3>(unit_cell_.max_mt_basis_size(), unit_cell_.max_mt_basis_size(), unit_cell_.num_atom_types());
                 //    p_mtrx_.zero();
@@ -483,11 +501,41 @@ class K_point
             return *fv_states_;
         }
 
+        /// Return the spinor wave functions; they are paged in from the out-of-core store if necessary.
+        /** Wave functions which are paged in here are considered modified and are written back when paged out;
+         *  use prefetch_wave_functions() to page them in for reading only. */
         inline Wave_functions& spinor_wave_functions()
         {
+            if (wf_store_) {
+                wf_store_->page_in(wf_store_idx_, !wf_store_->is_resident(wf_store_idx_));
+            }
             return *spinor_wave_functions_;
         }
 
+        /// Keep the spinor wave functions in the out-of-core store.
+        inline void set_wf_store(Wave_functions_store& wf_store__)
+        {
+            wf_store_     = &wf_store__;
+            wf_store_idx_ = wf_store__.add(*spinor_wave_functions_);
+        }
+
+        /// Release the memory of the spinor wave functions; modified wave functions are written to the out-of-core store.
+        inline void page_out_wave_functions()
+        {
+            if (wf_store_) {
+                wf_store_->page_out(wf_store_idx_);
+            }
+        }
+
+        /// Start reading the spinor wave functions from the out-of-core store.
+        /** If modify is false, the wave functions must not be changed until they are paged out. */
+        inline void prefetch_wave_functions(bool modify__)
+        {
+            if (wf_store_) {
+                wf_store_->prefetch(wf_store_idx_, modify__);
+            }
+        }
+
         inline Wave_functions& hubbard_wave_functions()
         {
             return *hubbard_wave_functions_;
@@ -767,6 +815,12 @@ class K_point
             assert(beta_projectors_ != nullptr);
             return *beta_projectors_col_;
         }
+
+        /// Real-space beta projectors or nullptr if the plane-wave representation is used.
+        Beta_projectors_rs* beta_projectors_rs()
+        {
+            return beta_projectors_rs_.get();
+        }
 };
 
 //== void K_point::check_alm(int num_gkvec_loc, int ia, mdarray<double_complex, 2>& alm)
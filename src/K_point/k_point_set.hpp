@@ -56,6 +56,10 @@ class K_point_set
 
     Unit_cell& unit_cell_;
 
+    /// Out-of-core store of the wave-functions of local k-points.
+    /** Declared after the list of k-points so that the pending I/O is completed before the k-points are destroyed. */
+    std::unique_ptr<Wave_functions_store> wf_store_{nullptr};
+
     K_point_set(K_point_set& src) = delete;
 
     void create_k_mesh(vector3d<int> k_grid__,
@@ -200,10 +204,24 @@ class K_point_set
             spl_num_kpoints_ = splindex<chunk>(num_kpoints(), comm().size(), comm().rank(), counts);
         }
 
+        wf_store_.reset();
+
         for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
             kpoints_[spl_num_kpoints_[ikloc]]->initialize();
         }
 
+        /* wave-functions of the k-points which are not being processed are kept in the scratch file */
+        if (!ctx_.control().wf_scratch_path_.empty() && ctx_.processing_unit() == CPU) {
+            wf_store_ = std::unique_ptr<Wave_functions_store>(new Wave_functions_store(ctx_.control().wf_scratch_path_));
+            for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+                kpoints_[spl_num_kpoints_[ikloc]]->set_wf_store(*wf_store_);
+                kpoints_[spl_num_kpoints_[ikloc]]->page_out_wave_functions();
+            }
+            if (ctx_.control().verbosity_ > 0 && ctx_.comm().rank() == 0) {
+                printf("size of the wave-functions scratch file: %12.4f GB\n", wf_store_->size() / double(1 << 30));
+            }
+        }
+
         if (ctx_.control().verbosity_ > 0) {
             print_info();
         }
@@ -227,6 +245,16 @@ class K_point_set
         }
     }
 
+    /// Start reading the wave-functions of the local k-point and of the next one from the out-of-core store.
+    /** This is used in the loops over local k-points: the wave-functions of the next k-point are read while the
+     *  current one is processed. Wave-functions prefetched with modify = false must not be changed. */
+    inline void prefetch_wave_functions(int ikloc__, bool modify__)
+    {
+        for (int i = ikloc__; i < std::min(ikloc__ + 2, spl_num_kpoints_.local_size()); i++) {
+            kpoints_[spl_num_kpoints_[i]]->prefetch_wave_functions(modify__);
+        }
+    }
+
     /// Get a list of band energies for a given k-point index.
     std::vector<double> get_band_energies(int ik__, int ispn__)
     {
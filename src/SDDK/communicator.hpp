@@ -100,6 +100,15 @@ struct mpi_type_wrapper<std::complex<double>>
     }
 };
 
+template <>
+struct mpi_type_wrapper<std::complex<float>>
+{
+    static MPI_Datatype kind()
+    {
+        return MPI_CXX_FLOAT_COMPLEX;
+    }
+};
+
 template <>
 struct mpi_type_wrapper<int>
 {
@@ -706,6 +715,73 @@ class Communicator
 #endif
     }
 
+    /// Start non-blocking all-to-all exchange.
+    /** Count and displacement arrays must stay valid until the returned request is completed. */
+    template <typename T>
+    Request ialltoall(T const* sendbuf__,
+                      int const* sendcounts__,
+                      int const* sdispls__,
+                      T* recvbuf__,
+                      int const* recvcounts__,
+                      int const* rdispls__) const
+    {
+        Request req;
+#if defined(__GPU_NVTX_MPI)
+        acc::begin_range_marker("MPI_Ialltoallv");
+#endif
+        CALL_MPI(MPI_Ialltoallv, (sendbuf__, sendcounts__, sdispls__, mpi_type_wrapper<T>::kind(), recvbuf__,
+                                  recvcounts__, rdispls__, mpi_type_wrapper<T>::kind(), mpi_comm(), &req.handler()));
+#if defined(__GPU_NVTX_MPI)
+        acc::end_range_marker();
+#endif
+        return std::move(req);
+    }
+
+    /// All-to-all exchange with per-rank MPI datatypes.
+    /** Displacements are given in bytes. */
+    void alltoall(void const* sendbuf__,
+                  int const* sendcounts__,
+                  int const* sdispls__,
+                  MPI_Datatype const* sendtypes__,
+                  void* recvbuf__,
+                  int const* recvcounts__,
+                  int const* rdispls__,
+                  MPI_Datatype const* recvtypes__) const
+    {
+#if defined(__GPU_NVTX_MPI)
+        acc::begin_range_marker("MPI_Alltoallw");
+#endif
+        CALL_MPI(MPI_Alltoallw, (sendbuf__, sendcounts__, sdispls__, sendtypes__, recvbuf__, recvcounts__, rdispls__,
+                                 recvtypes__, mpi_comm()));
+#if defined(__GPU_NVTX_MPI)
+        acc::end_range_marker();
+#endif
+    }
+
+    /// Start non-blocking all-to-all exchange with per-rank MPI datatypes.
+    /** Displacements are given in bytes. Count, displacement and datatype arrays must stay valid until the returned
+     *  request is completed. */
+    Request ialltoall(void const* sendbuf__,
+                      int const* sendcounts__,
+                      int const* sdispls__,
+                      MPI_Datatype const* sendtypes__,
+                      void* recvbuf__,
+                      int const* recvcounts__,
+                      int const* rdispls__,
+                      MPI_Datatype const* recvtypes__) const
+    {
+        Request req;
+#if defined(__GPU_NVTX_MPI)
+        acc::begin_range_marker("MPI_Ialltoallw");
+#endif
+        CALL_MPI(MPI_Ialltoallw, (sendbuf__, sendcounts__, sdispls__, sendtypes__, recvbuf__, recvcounts__, rdispls__,
+                                  recvtypes__, mpi_comm(), &req.handler()));
+#if defined(__GPU_NVTX_MPI)
+        acc::end_range_marker();
+#endif
+        return std::move(req);
+    }
+
     //==alltoall_descriptor map_alltoall(std::vector<int> local_sizes_in, std::vector<int> local_sizes_out) const
     //=={
     //==    alltoall_descriptor a2a;
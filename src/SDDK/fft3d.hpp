@@ -89,6 +89,9 @@ class FFT3D: public FFT3D_grid
         /// Main processing unit of this FFT.
         device_t pu_;
 
+        /// Planner flags for all FFTW plans of this FFT driver.
+        unsigned int fftw_plan_flags_;
+
         /// Split z-direction.
         splindex<block> spl_z_;
 
@@ -98,6 +101,53 @@ class FFT3D: public FFT3D_grid
         /// Offset in the global z-dimension.
         int offset_z_;
 
+        /// Number of ranks in y-dimension of the pencil decomposition (one in case of slab decomposition).
+        int num_ranks_y_{1};
+
+        /// Communicator between ranks which share the same z-slab in the pencil decomposition.
+        Communicator comm_xy_;
+
+        /// Split y-direction of the real-space pencils.
+        splindex<block> spl_y_;
+
+        /// Split x-direction of the intermediate y-pencils.
+        splindex<block> spl_x_;
+
+        /// Local size of y-dimension of FFT buffer.
+        int local_size_y_;
+
+        /// Offset in the global y-dimension.
+        int offset_y_{0};
+
+        /// Local z-columns sent to (backward transform) or received from (forward transform) each rank of comm_xy_.
+        /** Index 0 is used by the backward transform and index 1 by the forward transform. The backward list also
+         *  contains the columns whose {-x,-y} mirror belongs to the x-range of a rank in case of reduced G-vectors. */
+        std::array<std::vector<std::vector<int>>, 2> pencil_local_zcols_;
+
+        /// Global indices of z-columns received from (backward transform) or sent to (forward transform) each rank.
+        std::array<std::vector<std::vector<int>>, 2> pencil_remote_zcols_;
+
+        /// Full z-columns of the local G-vector columns in the pencil decomposition.
+        mdarray<double_complex, 1> pencil_zcol_buf_;
+
+        /// Intermediate y-pencils: element {y, x_loc, z_loc} is stored at y + ny * (x_loc + nx_loc * z_loc).
+        mdarray<double_complex, 1> pencil_y_buf_;
+
+        /// Send and receive buffers of the pencil transposes.
+        mdarray<double_complex, 1> pencil_send_buf_;
+        mdarray<double_complex, 1> pencil_recv_buf_;
+
+        /// Temporary real-space buffer for the transformation of two real functions in the pencil decomposition.
+        mdarray<double_complex, 1> pencil_tmp_buf_;
+
+        /// FFTW plans for 1D transformations of y-pencils of one local z-plane.
+        fftw_plan plan_backward_y_pencil_{nullptr};
+        fftw_plan plan_forward_y_pencil_{nullptr};
+
+        /// FFTW plans for 1D transformations of x-rows of one local z-plane.
+        fftw_plan plan_backward_x_pencil_{nullptr};
+        fftw_plan plan_forward_x_pencil_{nullptr};
+
         /// Main input/output buffer.
         mdarray<double_complex, 1> fft_buffer_;
 
@@ -107,24 +157,93 @@ class FFT3D: public FFT3D_grid
         /// Auxiliary array in case of simultaneous transformation of two wave-functions.
         mdarray<double_complex, 1> fft_buffer_aux2_;
 
+        /// Real-space buffer for the batched transformation of a block of functions.
+        /** Function ib of the block occupies local_size() elements starting from ib * local_size(). The buffer is
+         *  also used as a temporary storage for the all-to-all exchange of z-columns. */
+        mdarray<double_complex, 1> fft_buffer_batch_;
+
+        /// Auxiliary array to store z-sticks of a block of functions.
+        mdarray<double_complex, 1> fft_buffer_aux_batch_;
+
+        /// Maximum number of functions which can be stored in the batch buffers.
+        int num_batch_max_{0};
+
+        /// Size of the auxiliary z-stick storage of a single function in the batch.
+        size_t aux_batch_stride_{0};
+
+        /// Number of functions in a chunk of the pipelined batched transformation.
+        /** If positive, the z-columns of a block of functions are exchanged chunk by chunk with the non-blocking
+         *  all-to-all which is overlapped with the transformation of the next chunk. */
+        int pipeline_chunk_size_{0};
+
         /// Internal buffer for independent z-transforms.
+        /** Each thread holds a zero-padded block of zcol_block_size_ z-columns stored one after another. */
         std::vector<double_complex*> fftw_buffer_z_;
 
         /// Internal buffer for independent {xy}-transforms.
         std::vector<double_complex*> fftw_buffer_xy_;
 
-        /// FFTW plan for 1D backward transformation.
+        /// FFTW plan for batched 1D backward transformation of a block of z-columns.
         std::vector<fftw_plan> plan_backward_z_;
 
         /// FFTW plan for 2D backward transformation.
         std::vector<fftw_plan> plan_backward_xy_;
 
-        /// FFTW plan for 1D forward transformation.
+        /// FFTW plan for batched 1D forward transformation of a block of z-columns.
         std::vector<fftw_plan> plan_forward_z_;
 
+        /// Number of z-columns in a block transformed by a single batched FFTW plan.
+        int zcol_block_size_{0};
+
+        /// Maximum size of the thread-private block of z-columns (in number of elements).
+        static const int zcol_block_max_elements_{1 << 15};
+
+        /// Maximum number of real-space points per thread for which the band-parallel transformation is preferred.
+        static const int band_parallel_max_points_{1 << 15};
+
         /// FFTW plan for 2D forward transformation.
         std::vector<fftw_plan> plan_forward_xy_;
 
+        /// FFTW plan for 2D c2r transformation of a real function.
+        std::vector<fftw_plan> plan_backward_xy_c2r_;
+
+        /// FFTW plan for 2D r2c transformation of a real function.
+        std::vector<fftw_plan> plan_forward_xy_r2c_;
+
+        /// FFTW plan for batched 1D backward transformation of all x-rows of the xy-plane.
+        std::vector<fftw_plan> plan_backward_x_;
+
+        /// FFTW plan for batched 1D forward transformation of all x-rows of the xy-plane.
+        std::vector<fftw_plan> plan_forward_x_;
+
+        /// FFTW plans for batched 1D backward transformation of non-empty y-columns (one plan per range of columns).
+        std::vector<std::vector<fftw_plan>> plan_backward_y_;
+
+        /// FFTW plans for batched 1D forward transformation of non-empty y-columns (one plan per range of columns).
+        std::vector<std::vector<fftw_plan>> plan_forward_y_;
+
+        /// True if the xy-transform is split into 1D transforms of non-empty y-columns followed by x-transforms.
+        /** This is set in prepare() when the z-columns of the G-vector set occupy only a fraction of x-coordinates. */
+        bool use_pruned_xy_{false};
+
+        /// Real-space buffer of the single-precision transformation (see transform_fp32()).
+        mdarray<std::complex<float>, 1> fft_buffer_fp32_;
+
+        /// Auxiliary array to store z-sticks of the single-precision transformation.
+        mdarray<std::complex<float>, 1> fft_buffer_aux_fp32_;
+
+#ifdef __FFTWF
+        /// Thread-private buffers of the single-precision z- and xy-transforms.
+        std::vector<std::complex<float>*> fftwf_buffer_z_;
+        std::vector<std::complex<float>*> fftwf_buffer_xy_;
+
+        /// Single-precision FFTW plans of the z- and xy-transforms.
+        std::vector<fftwf_plan> planf_backward_z_;
+        std::vector<fftwf_plan> planf_forward_z_;
+        std::vector<fftwf_plan> planf_backward_xy_;
+        std::vector<fftwf_plan> planf_forward_xy_;
+#endif
+
         /// True if GPU-direct is enabled.
         bool is_gpu_direct_{false};
 
@@ -236,17 +355,17 @@ class FFT3D: public FFT3D_grid
         {
             PROFILE("sddk::FFT3D::transform_z_serial");
 
-            int num_zcol_local = gvec_partition_->zcol_count_fft();
-            double norm = 1.0 / size();
-
-            bool is_reduced = gvec_partition_->gvec().reduced();
-
             assert(static_cast<int>(fft_buffer_aux__.size()) >= gvec_partition_->zcol_count_fft() * size(2));
 
             /* input/output data buffer is on GPU */
             if (data_ptr_type == GPU) {
                 utils::timer t("sddk::FFT3D::transform_z_serial|gpu");
 #ifdef __GPU
+                int num_zcol_local = gvec_partition_->zcol_count_fft();
+                double norm = 1.0 / size();
+
+                bool is_reduced = gvec_partition_->gvec().reduced();
+
                 switch (direction) {
                     case 1: {
                         /* load all columns into FFT buffer */
@@ -329,78 +448,154 @@ class FFT3D: public FFT3D_grid
 
             if (data_ptr_type == CPU) {
                 utils::timer t("sddk::FFT3D::transform_z_serial|cpu");
-                #pragma omp parallel
-                {
-                    int tid = omp_get_thread_num();
-                    #pragma omp for schedule(dynamic, 1)
-                    for (int i = 0; i < num_zcol_local; i++) {
+                transform_z_cpu<direction>(1, data__, 0, fft_buffer_aux__.at<CPU>());
+            }
+        }
+
+        /// CPU implementation of the 1D transformation of local z-columns for a block of functions.
+        /** \param [in]    num_bands Number of functions in the block.
+         *  \param [inout] data      Plane-wave coefficients of the functions.
+         *  \param [in]    ld        Leading dimension of the data array (distance between functions).
+         *  \param [inout] aux       Auxiliary buffer with the z-columns prepared for the all-to-all exchange.
+         *
+         *  Chunk of z-columns addressed to rank r starts at num_bands * offs(r) * num_zcol_local and contains the
+         *  slices of all local columns of the first function, followed by the slices of the second function, etc.
+         *  For a single function this is the layout of transform_z_serial(). In the pencil decomposition full
+         *  z-columns are stored one after another. */
+        template <int direction>
+        void transform_z_cpu(int num_bands__, double_complex* data__, int ld__, double_complex* aux__)
+        {
+            int num_zcol_local = gvec_partition_->zcol_count_fft();
+
+            int zcol_block_size = zcol_block_size_;
+            int num_blocks = (num_zcol_local + zcol_block_size - 1) / zcol_block_size;
+
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                #pragma omp for schedule(dynamic, 1)
+                for (int ibb = 0; ibb < num_bands__ * num_blocks; ibb++) {
+                    /* index of the function */
+                    int b = ibb / num_blocks;
+                    /* index of the block of columns */
+                    int ib = ibb % num_blocks;
+                    transform_z_block<direction>(tid, num_bands__, b, ib * zcol_block_size,
+                                                 data__ + static_cast<size_t>(ld__) * b, aux__);
+                }
+            }
+        }
+
+        /// Transform a block of local z-columns of one function of the block on the calling thread.
+        /** \param [in]    tid       Index of the thread-private buffer and plans.
+         *  \param [in]    num_bands Number of functions in the block.
+         *  \param [in]    b         Index of the function in the block.
+         *  \param [in]    i0        Local index of the first column.
+         *  \param [inout] data      Plane-wave coefficients of the function.
+         *  \param [inout] aux       Auxiliary buffer of the block (see transform_z_cpu()). */
+        template <int direction>
+        void transform_z_block(int tid__, int num_bands__, int b__, int i0__, double_complex* data__,
+                               double_complex* aux__)
+        {
+            int num_zcol_local = gvec_partition_->zcol_count_fft();
+            double norm = 1.0 / size();
+
+            bool is_reduced = gvec_partition_->gvec().reduced();
+
+            int zcol_block_size = zcol_block_size_;
+            /* number of columns in the block */
+            int nc = std::min(zcol_block_size, num_zcol_local - i0__);
+
+            /* in the pencil decomposition full z-columns are stored one after another */
+            int num_zslabs = is_pencil() ? 1 : comm_.size();
+            auto zslab_size   = [&](int r) { return is_pencil() ? size(2) : spl_z_.local_size(r); };
+            auto zslab_offset = [&](int r) { return is_pencil() ? 0 : spl_z_.global_offset(r); };
+
+            /* thread-private block of z-columns */
+            double_complex* buf = fftw_buffer_z_[tid__];
+
+            switch (direction) {
+                case 1: {
+                    /* clear z buffer; the unused part of the last block is also transformed */
+                    std::fill(buf, buf + zcol_block_size * size(2), 0);
+
+                    for (int j = 0; j < nc; j++) {
                         /* global index of column */
-                        int icol = gvec_partition_->idx_zcol<index_domain_t::local>(i);
+                        int icol = gvec_partition_->idx_zcol<index_domain_t::local>(i0__ + j);
                         /* offset of the PW coeffs in the input/output data buffer */
                         int data_offset = gvec_partition_->zcol_offs(icol);
+                        auto& zcol = gvec_partition_->gvec().zcol(icol);
 
-                        switch (direction) {
-                            case 1: {
-                                /* clear z buffer */
-                                std::fill(fftw_buffer_z_[tid], fftw_buffer_z_[tid] + size(2), 0);
-                                /* load z column  of PW coefficients into buffer */
-                                for (size_t j = 0; j < gvec_partition_->gvec().zcol(icol).z.size(); j++) {
-                                    int z = coord_by_freq<2>(gvec_partition_->gvec().zcol(icol).z[j]);
-                                    fftw_buffer_z_[tid][z] = data__[data_offset + j];
-                                }
-
-                                /* column with {x,y} = {0,0} has only non-negative z components */
-                                if (is_reduced && !icol) {
-                                    /* load remaining part of {0,0,z} column */
-                                    for (size_t j = 0; j < gvec_partition_->gvec().zcol(icol).z.size(); j++) {
-                                        int z = coord_by_freq<2>(-gvec_partition_->gvec().zcol(icol).z[j]);
-                                        fftw_buffer_z_[tid][z] = std::conj(data__[data_offset + j]);
-                                    }
-                                }
+                        /* load z column of PW coefficients into buffer */
+                        for (size_t k = 0; k < zcol.z.size(); k++) {
+                            int z = coord_by_freq<2>(zcol.z[k]);
+                            buf[j * size(2) + z] = data__[data_offset + k];
+                        }
 
-                                /* perform local FFT transform of a column */
-                                fftw_execute(plan_backward_z_[tid]);
+                        /* column with {x,y} = {0,0} has only non-negative z components */
+                        if (is_reduced && !icol) {
+                            /* load remaining part of {0,0,z} column */
+                            for (size_t k = 0; k < zcol.z.size(); k++) {
+                                int z = coord_by_freq<2>(-zcol.z[k]);
+                                buf[j * size(2) + z] = std::conj(data__[data_offset + k]);
+                            }
+                        }
+                    }
 
-                                /* redistribute z-column for a forthcoming all-to-all or just load the
-                                 * full column into auxiliary buffer in serial case */
-                                for (int r = 0; r < comm_.size(); r++) {
-                                    int lsz  = spl_z_.local_size(r);
-                                    int offs = spl_z_.global_offset(r);
+                    /* perform local FFT transform of a block of columns */
+                    fftw_execute(plan_backward_z_[tid__]);
 
-                                    std::copy(&fftw_buffer_z_[tid][offs],
-                                              &fftw_buffer_z_[tid][offs] + lsz,
-                                              &fft_buffer_aux__[offs * num_zcol_local + i * lsz]);
-                                }
-                                break;
+                    /* redistribute z-columns for a forthcoming all-to-all or just load the
+                     * full columns into auxiliary buffer in serial case */
+                    for (int j = 0; j < nc; j++) {
+                        int i = b__ * num_zcol_local + i0__ + j;
+                        for (int r = 0; r < num_zslabs; r++) {
+                            int lsz  = zslab_size(r);
+                            int offs = zslab_offset(r);
 
-                            }
-                            case -1: {
-                                /* collect full z-column or just load it from the auxiliary buffer is serial case */
-                                for (int r = 0; r < comm_.size(); r++) {
-                                    int lsz  = spl_z_.local_size(r);
-                                    int offs = spl_z_.global_offset(r);
+                            std::copy(&buf[j * size(2) + offs],
+                                      &buf[j * size(2) + offs] + lsz,
+                                      &aux__[num_bands__ * offs * num_zcol_local + i * lsz]);
+                        }
+                    }
+                    break;
 
-                                    std::copy(&fft_buffer_aux__[offs * num_zcol_local + i * lsz],
-                                              &fft_buffer_aux__[offs * num_zcol_local + i * lsz] + lsz,
-                                              &fftw_buffer_z_[tid][offs]);
-                                }
+                }
+                case -1: {
+                    /* collect full z-columns or just load them from the auxiliary buffer is serial case */
+                    for (int j = 0; j < nc; j++) {
+                        int i = b__ * num_zcol_local + i0__ + j;
+                        for (int r = 0; r < num_zslabs; r++) {
+                            int lsz  = zslab_size(r);
+                            int offs = zslab_offset(r);
+
+                            std::copy(&aux__[num_bands__ * offs * num_zcol_local + i * lsz],
+                                      &aux__[num_bands__ * offs * num_zcol_local + i * lsz] + lsz,
+                                      &buf[j * size(2) + offs]);
+                        }
+                    }
+                    /* clear the unused part of the last block */
+                    std::fill(buf + nc * size(2), buf + zcol_block_size * size(2), 0);
 
-                                /* perform local FFT transform of a column */
-                                fftw_execute(plan_forward_z_[tid]);
+                    /* perform local FFT transform of a block of columns */
+                    fftw_execute(plan_forward_z_[tid__]);
 
-                                /* save z column of PW coefficients */
-                                for (size_t j = 0; j < gvec_partition_->gvec().zcol(icol).z.size(); j++) {
-                                    int z = coord_by_freq<2>(gvec_partition_->gvec().zcol(icol).z[j]);
-                                    data__[data_offset + j] = fftw_buffer_z_[tid][z] * norm;
-                                }
+                    for (int j = 0; j < nc; j++) {
+                        /* global index of column */
+                        int icol = gvec_partition_->idx_zcol<index_domain_t::local>(i0__ + j);
+                        /* offset of the PW coeffs in the input/output data buffer */
+                        int data_offset = gvec_partition_->zcol_offs(icol);
+                        auto& zcol = gvec_partition_->gvec().zcol(icol);
 
-                                break;
-                            }
-                            default: {
-                                TERMINATE("wrong direction");
-                            }
+                        /* save z column of PW coefficients */
+                        for (size_t k = 0; k < zcol.z.size(); k++) {
+                            int z = coord_by_freq<2>(zcol.z[k]);
+                            data__[data_offset + k] = buf[j * size(2) + z] * norm;
                         }
                     }
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
                 }
             }
         }
@@ -526,6 +721,268 @@ class FFT3D: public FFT3D_grid
             }
         }
 
+        /// Pointer to the auxiliary z-stick storage of a chunk of functions starting from function ib.
+        inline double_complex* aux_batch(int ib__)
+        {
+            return fft_buffer_aux_batch_.at<CPU>(aux_batch_stride_ * ib__);
+        }
+
+        /// Setup the all-to-all exchange of z-columns for a chunk of functions.
+        /** \param [in]  num_bands Number of functions in the chunk.
+         *  \param [in]  direction Direction of the transformation.
+         *  \param [out] send      Send counts and offsets.
+         *  \param [out] recv      Receive counts and offsets. */
+        void batch_a2a_descriptors(int num_bands__, int direction__, block_data_descriptor& send__,
+                                   block_data_descriptor& recv__) const
+        {
+            int rank = comm_.rank();
+
+            send__ = block_data_descriptor(comm_.size());
+            recv__ = block_data_descriptor(comm_.size());
+            for (int r = 0; r < comm_.size(); r++) {
+                if (direction__ == 1) {
+                    send__.counts[r] = num_bands__ * spl_z_.local_size(r)    * gvec_partition_->zcol_count_fft(rank);
+                    recv__.counts[r] = num_bands__ * spl_z_.local_size(rank) * gvec_partition_->zcol_count_fft(r);
+                } else {
+                    send__.counts[r] = num_bands__ * spl_z_.local_size(rank) * gvec_partition_->zcol_count_fft(r);
+                    recv__.counts[r] = num_bands__ * spl_z_.local_size(r)    * gvec_partition_->zcol_count_fft(rank);
+                }
+            }
+            send__.calc_offsets();
+            recv__.calc_offsets();
+        }
+
+        /// Copy a chunk of z-columns between the all-to-all layout and the layout of transform_xy_batch().
+        /** In the all-to-all layout the sticks received from rank r are stored in a contiguous piece of the
+         *  real-space batch buffer, function after function. After repacking, the sticks of function ib of the chunk
+         *  start at ib * num_zcol * local_size_z_, i.e. each function has the layout of a single-function transform. */
+        template <int direction>
+        void repack_batch(int ib0__, int num_bands__)
+        {
+            PROFILE("sddk::FFT3D::repack_batch");
+
+            int num_zcol = gvec_partition_->gvec().num_zcol();
+
+            double_complex* a2a_buf = buffer_batch(ib0__);
+            double_complex* aux_buf = aux_batch(ib0__);
+
+            #pragma omp parallel for schedule(static)
+            for (int ib = 0; ib < num_bands__; ib++) {
+                for (int r = 0; r < comm_.size(); r++) {
+                    int zoffs = gvec_partition_->zcol_offset_fft(r);
+                    int zcnt  = gvec_partition_->zcol_count_fft(r);
+                    double_complex* a2a_ptr = &a2a_buf[local_size_z_ * (num_bands__ * zoffs + ib * zcnt)];
+                    double_complex* xy_ptr  = &aux_buf[local_size_z_ * (ib * num_zcol + zoffs)];
+                    if (direction == 1) {
+                        std::copy(a2a_ptr, a2a_ptr + zcnt * local_size_z_, xy_ptr);
+                    } else {
+                        std::copy(xy_ptr, xy_ptr + zcnt * local_size_z_, a2a_ptr);
+                    }
+                }
+            }
+        }
+
+        /// Apply 2D FFT transformation to z-columns of a chunk of functions.
+        template <int direction>
+        void transform_xy_batch(int ib0__, int num_bands__)
+        {
+            PROFILE("sddk::FFT3D::transform_xy_batch");
+
+            int num_zcol = gvec_partition_->gvec().num_zcol();
+
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                #pragma omp for schedule(static)
+                for (int k = 0; k < num_bands__ * local_size_z_; k++) {
+                    int ib = k / local_size_z_;
+                    int iz = k % local_size_z_;
+                    /* z-sticks of the function */
+                    double_complex* aux = aux_batch(ib0__) + static_cast<size_t>(ib) * num_zcol * local_size_z_;
+                    transform_xy_plane<direction>(tid, iz, aux, buffer_batch(ib0__ + ib));
+                }
+            }
+        }
+
+        /// Apply 2D FFT transformation to one z-plane of a function on the calling thread.
+        /** \param [in]    tid Index of the thread-private buffer and plans.
+         *  \param [in]    iz  Local index of the z-plane.
+         *  \param [inout] aux Local z-sticks of the function.
+         *  \param [inout] rg  Real-space values of the function. */
+        template <int direction>
+        void transform_xy_plane(int tid__, int iz__, double_complex* aux__, double_complex* rg__)
+        {
+            int size_xy = size(0) * size(1);
+            int num_zcol = gvec_partition_->gvec().num_zcol();
+
+            int is_reduced = gvec_partition_->gvec().reduced();
+
+            /* xy-plane of the function */
+            double_complex* fft_buf = rg__ + iz__ * size_xy;
+            switch (direction) {
+                case 1: {
+                    /* clear xy-buffer */
+                    std::fill(fftw_buffer_xy_[tid__], fftw_buffer_xy_[tid__] + size_xy, 0);
+                    /* load z-columns into proper location */
+                    for (int i = 0; i < num_zcol; i++) {
+                        fftw_buffer_xy_[tid__][z_col_pos_(i, 0)] = aux__[iz__ + i * local_size_z_];
+
+                        if (is_reduced && i) {
+                            fftw_buffer_xy_[tid__][z_col_pos_(i, 1)] = std::conj(fftw_buffer_xy_[tid__][z_col_pos_(i, 0)]);
+                        }
+                    }
+
+                    /* execute local FFT transform */
+                    execute_xy<1>(tid__);
+
+                    /* copy xy plane to the real-space buffer */
+                    std::copy(fftw_buffer_xy_[tid__], fftw_buffer_xy_[tid__] + size_xy, fft_buf);
+                    break;
+                }
+                case -1: {
+                    /* copy xy plane from the real-space buffer */
+                    std::copy(fft_buf, fft_buf + size_xy, fftw_buffer_xy_[tid__]);
+
+                    /* execute local FFT transform */
+                    execute_xy<-1>(tid__);
+
+                    /* get z-columns */
+                    for (int i = 0; i < num_zcol; i++) {
+                        aux__[iz__ + i * local_size_z_] = fftw_buffer_xy_[tid__][z_col_pos_(i, 0)];
+                    }
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+        /// Allocate thread-private buffers and create batched FFTW plans for the z-transform.
+        /** Local z-columns are split in blocks between threads; the block size is chosen to balance the columns
+         *  between threads and to keep the block in the cache. */
+        void create_z_plans(Gvec_partition const& gvp__)
+        {
+            int nt = omp_get_max_threads();
+            zcol_block_size_ = std::max(1, std::min((gvp__.zcol_count_fft() + nt - 1) / nt,
+                                                    zcol_block_max_elements_ / size(2)));
+
+            int n[] = {size(2)};
+            for (int i = 0; i < nt; i++) {
+                fftw_buffer_z_[i] = (double_complex*)fftw_malloc(zcol_block_size_ * size(2) * sizeof(double_complex));
+                auto ptr = (fftw_complex*)fftw_buffer_z_[i];
+                plan_backward_z_[i] = fftw_plan_many_dft(1, n, zcol_block_size_, ptr, NULL, 1, size(2), ptr, NULL, 1,
+                                                         size(2), FFTW_BACKWARD, fftw_plan_flags_);
+                plan_forward_z_[i] = fftw_plan_many_dft(1, n, zcol_block_size_, ptr, NULL, 1, size(2), ptr, NULL, 1,
+                                                        size(2), FFTW_FORWARD, fftw_plan_flags_);
+            }
+        }
+
+        /// Destroy batched FFTW plans of the z-transform and release thread-private buffers.
+        void destroy_z_plans()
+        {
+            for (int i = 0; i < omp_get_max_threads(); i++) {
+                fftw_destroy_plan(plan_backward_z_[i]);
+                fftw_destroy_plan(plan_forward_z_[i]);
+                fftw_free(fftw_buffer_z_[i]);
+                fftw_buffer_z_[i] = nullptr;
+            }
+            zcol_block_size_ = 0;
+        }
+
+        /// Create plans for the pruned xy-transform.
+        /** The y-columns of the xy-plane which contain z-columns of the G-vector set are grouped in contiguous ranges
+         *  of x-coordinate; each range is transformed with a single batched 1D FFTW plan. */
+        void create_pruned_xy_plans(Gvec_partition const& gvp__)
+        {
+            /* mark x-coordinates of non-empty y-columns */
+            std::vector<int> is_used(size(0), 0);
+            for (int i = 0; i < gvp__.gvec().num_zcol(); i++) {
+                is_used[z_col_pos_(i, 0) % size(0)] = 1;
+                if (gvp__.gvec().reduced()) {
+                    is_used[z_col_pos_(i, 1) % size(0)] = 1;
+                }
+            }
+            int num_x_used = std::accumulate(is_used.begin(), is_used.end(), 0);
+
+            /* pruned transform makes sense only when some of the y-columns are empty */
+            use_pruned_xy_ = (num_x_used < size(0));
+            if (!use_pruned_xy_) {
+                return;
+            }
+
+            /* get contiguous ranges of non-empty y-columns */
+            std::vector<std::pair<int, int>> x_ranges;
+            for (int x = 0; x < size(0); x++) {
+                if (is_used[x]) {
+                    if (x_ranges.empty() || x_ranges.back().first + x_ranges.back().second != x) {
+                        x_ranges.push_back(std::make_pair(x, 0));
+                    }
+                    x_ranges.back().second++;
+                }
+            }
+
+            int n[] = {size(1)};
+            for (int i = 0; i < omp_get_max_threads(); i++) {
+                for (auto& xr: x_ranges) {
+                    auto ptr = (fftw_complex*)(fftw_buffer_xy_[i] + xr.first);
+                    plan_backward_y_[i].push_back(fftw_plan_many_dft(1, n, xr.second, ptr, NULL, size(0), 1, ptr, NULL,
+                                                                     size(0), 1, FFTW_BACKWARD, fftw_plan_flags_));
+                    plan_forward_y_[i].push_back(fftw_plan_many_dft(1, n, xr.second, ptr, NULL, size(0), 1, ptr, NULL,
+                                                                    size(0), 1, FFTW_FORWARD, fftw_plan_flags_));
+                }
+            }
+        }
+
+        /// Destroy plans of the pruned xy-transform.
+        void destroy_pruned_xy_plans()
+        {
+            for (int i = 0; i < omp_get_max_threads(); i++) {
+                for (auto& p: plan_backward_y_[i]) {
+                    fftw_destroy_plan(p);
+                }
+                for (auto& p: plan_forward_y_[i]) {
+                    fftw_destroy_plan(p);
+                }
+                plan_backward_y_[i].clear();
+                plan_forward_y_[i].clear();
+            }
+            use_pruned_xy_ = false;
+        }
+
+        /// Execute 2D FFT of the xy-plane stored in the thread-private buffer.
+        /** In the pruned mode the backward transform is done as 1D transforms of the non-empty y-columns followed by
+         *  the full x-transforms; the forward transform is done in the opposite order. Empty y-columns stay zero after
+         *  the y-transform and the output of the forward transform is needed only at the positions of z-columns. */
+        template <int direction>
+        inline void execute_xy(int tid__)
+        {
+            switch (direction) {
+                case 1: {
+                    if (use_pruned_xy_) {
+                        for (auto& p: plan_backward_y_[tid__]) {
+                            fftw_execute(p);
+                        }
+                        fftw_execute(plan_backward_x_[tid__]);
+                    } else {
+                        fftw_execute(plan_backward_xy_[tid__]);
+                    }
+                    break;
+                }
+                case -1: {
+                    if (use_pruned_xy_) {
+                        fftw_execute(plan_forward_x_[tid__]);
+                        for (auto& p: plan_forward_y_[tid__]) {
+                            fftw_execute(p);
+                        }
+                    } else {
+                        fftw_execute(plan_forward_xy_[tid__]);
+                    }
+                    break;
+                }
+            }
+        }
+
         /// Apply 2D FFT transformation to z-columns of one complex function.
         template <int direction>
         void transform_xy(mdarray<double_complex, 1>& fft_buffer_aux__)
@@ -594,7 +1051,7 @@ class FFT3D: public FFT3D_grid
                                 }
 
                                 /* execute local FFT transform */
-                                fftw_execute(plan_backward_xy_[tid]);
+                                execute_xy<1>(tid);
 
                                 /* copy xy plane to the main FFT buffer */
                                 std::copy(fftw_buffer_xy_[tid], fftw_buffer_xy_[tid] + size_xy, &fft_buffer_[iz * size_xy]);
@@ -606,7 +1063,7 @@ class FFT3D: public FFT3D_grid
                                 std::copy(&fft_buffer_[iz * size_xy], &fft_buffer_[iz * size_xy] + size_xy, fftw_buffer_xy_[tid]);
 
                                 /* execute local FFT transform */
-                                fftw_execute(plan_forward_xy_[tid]);
+                                execute_xy<-1>(tid);
 
                                 /* get z-columns */
                                 for (int i = 0; i < gvec_partition_->gvec().num_zcol(); i++) {
@@ -703,7 +1160,7 @@ class FFT3D: public FFT3D_grid
                                 }
 
                                 /* execute local FFT transform */
-                                fftw_execute(plan_backward_xy_[tid]);
+                                execute_xy<1>(tid);
 
                                 /* copy xy plane to the main FFT buffer */
                                 std::copy(fftw_buffer_xy_[tid], fftw_buffer_xy_[tid] + size_xy, &fft_buffer_[iz * size_xy]);
@@ -715,7 +1172,7 @@ class FFT3D: public FFT3D_grid
                                 std::copy(&fft_buffer_[iz * size_xy], &fft_buffer_[iz * size_xy] + size_xy, fftw_buffer_xy_[tid]);
 
                                 /* execute local FFT transform */
-                                fftw_execute(plan_forward_xy_[tid]);
+                                execute_xy<-1>(tid);
 
                                 /* get z-columns */
                                 for (int i = 0; i < gvec_partition_->gvec().num_zcol(); i++) {
@@ -737,55 +1194,717 @@ class FFT3D: public FFT3D_grid
             }
         }
 
-    public:
-
-        /// Constructor.
-        FFT3D(std::array<int, 3>  initial_dims__,
-              Communicator const& comm__,
-              device_t            pu__)
-            : FFT3D_grid(initial_dims__)
-            , comm_(comm__)
-            , pu_(pu__)
+#ifdef __FFTWF
+        /// Create buffers and plans of the single-precision transformation.
+        /** The plans are created on the first call to transform_fp32() and destroyed by dismiss(). The z-columns are
+         *  transformed in blocks of the same size as in the double-precision transform. */
+        void create_fp32_plans()
         {
-            PROFILE("sddk::FFT3D::FFT3D");
-
-            /* split z-direction */
-            spl_z_        = splindex<block>(size(2), comm_.size(), comm_.rank());
-            local_size_z_ = spl_z_.local_size();
-            offset_z_     = spl_z_.global_offset();
-
-            if (pu_ == CPU) {
-                host_memory_type_ = memory_t::host;
-            } else {
-                host_memory_type_ = memory_t::host_pinned;
+            size_t sz_aux = std::max(size(2) * gvec_partition_->zcol_count_fft(),
+                                     local_size_z_ * gvec_partition_->gvec().num_zcol());
+            if (fft_buffer_aux_fp32_.size() < sz_aux) {
+                fft_buffer_aux_fp32_ = mdarray<std::complex<float>, 1>(sz_aux, memory_t::host, "FFT3D.fft_buffer_aux_fp32_");
+            }
+            if (fft_buffer_fp32_.size() < static_cast<size_t>(local_size())) {
+                fft_buffer_fp32_ = mdarray<std::complex<float>, 1>(local_size(), memory_t::host, "FFT3D.fft_buffer_fp32_");
             }
 
-            /* allocate main buffer */
-            fft_buffer_ = mdarray<double_complex, 1>(local_size(), host_memory_type_, "FFT3D.fft_buffer_");
+            int nt = omp_get_max_threads();
+            int n[] = {size(2)};
+            for (int i = 0; i < nt; i++) {
+                auto zbuf = (std::complex<float>*)fftwf_malloc(zcol_block_size_ * size(2) * sizeof(std::complex<float>));
+                auto xybuf = (std::complex<float>*)fftwf_malloc(size(0) * size(1) * sizeof(std::complex<float>));
+                fftwf_buffer_z_.push_back(zbuf);
+                fftwf_buffer_xy_.push_back(xybuf);
+
+                auto zptr = (fftwf_complex*)zbuf;
+                planf_backward_z_.push_back(fftwf_plan_many_dft(1, n, zcol_block_size_, zptr, NULL, 1, size(2), zptr, NULL,
+                                                                1, size(2), FFTW_BACKWARD, fftw_plan_flags_));
+                planf_forward_z_.push_back(fftwf_plan_many_dft(1, n, zcol_block_size_, zptr, NULL, 1, size(2), zptr, NULL,
+                                                               1, size(2), FFTW_FORWARD, fftw_plan_flags_));
+                auto xyptr = (fftwf_complex*)xybuf;
+                planf_backward_xy_.push_back(fftwf_plan_dft_2d(size(1), size(0), xyptr, xyptr, FFTW_BACKWARD,
+                                                               fftw_plan_flags_));
+                planf_forward_xy_.push_back(fftwf_plan_dft_2d(size(1), size(0), xyptr, xyptr, FFTW_FORWARD,
+                                                              fftw_plan_flags_));
+            }
+        }
 
-            /* allocate 1d and 2d buffers */
-            for (int i = 0; i < omp_get_max_threads(); i++) {
-                fftw_buffer_z_.push_back((double_complex*)fftw_malloc(size(2) * sizeof(double_complex)));
-                fftw_buffer_xy_.push_back((double_complex*)fftw_malloc(size(0) * size(1) * sizeof(double_complex)));
+        /// Destroy buffers and plans of the single-precision transformation.
+        void destroy_fp32_plans()
+        {
+            for (size_t i = 0; i < planf_backward_xy_.size(); i++) {
+                fftwf_destroy_plan(planf_backward_z_[i]);
+                fftwf_destroy_plan(planf_forward_z_[i]);
+                fftwf_destroy_plan(planf_backward_xy_[i]);
+                fftwf_destroy_plan(planf_forward_xy_[i]);
+                fftwf_free(fftwf_buffer_z_[i]);
+                fftwf_free(fftwf_buffer_xy_[i]);
             }
+            planf_backward_z_.clear();
+            planf_forward_z_.clear();
+            planf_backward_xy_.clear();
+            planf_forward_xy_.clear();
+            fftwf_buffer_z_.clear();
+            fftwf_buffer_xy_.clear();
+        }
 
-            plan_forward_z_   = std::vector<fftw_plan>(omp_get_max_threads());
-            plan_forward_xy_  = std::vector<fftw_plan>(omp_get_max_threads());
-            plan_backward_z_  = std::vector<fftw_plan>(omp_get_max_threads());
-            plan_backward_xy_ = std::vector<fftw_plan>(omp_get_max_threads());
+        /// Single-precision 1D transformation of local z-columns.
+        /** The layout of the auxiliary buffer is the same as in transform_z_cpu() for a single function. */
+        template <int direction>
+        void transform_z_fp32(std::complex<float>* data__, std::complex<float>* aux__)
+        {
+            PROFILE("sddk::FFT3D::transform_z_fp32");
 
+            int num_zcol_local = gvec_partition_->zcol_count_fft();
+            float norm = 1.0 / size();
+
+            bool is_reduced = gvec_partition_->gvec().reduced();
+
+            int zcol_block_size = zcol_block_size_;
+            int num_blocks = (num_zcol_local + zcol_block_size - 1) / zcol_block_size;
+
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                std::complex<float>* buf = fftwf_buffer_z_[tid];
+                #pragma omp for schedule(dynamic, 1)
+                for (int ib = 0; ib < num_blocks; ib++) {
+                    int i0 = ib * zcol_block_size;
+                    int nc = std::min(zcol_block_size, num_zcol_local - i0);
+
+                    switch (direction) {
+                        case 1: {
+                            std::fill(buf, buf + zcol_block_size * size(2), 0);
+                            for (int j = 0; j < nc; j++) {
+                                int icol = gvec_partition_->idx_zcol<index_domain_t::local>(i0 + j);
+                                int data_offset = gvec_partition_->zcol_offs(icol);
+                                auto& zcol = gvec_partition_->gvec().zcol(icol);
+                                for (size_t k = 0; k < zcol.z.size(); k++) {
+                                    buf[j * size(2) + coord_by_freq<2>(zcol.z[k])] = data__[data_offset + k];
+                                }
+                                /* column with {x,y} = {0,0} has only non-negative z components */
+                                if (is_reduced && !icol) {
+                                    for (size_t k = 0; k < zcol.z.size(); k++) {
+                                        buf[j * size(2) + coord_by_freq<2>(-zcol.z[k])] = std::conj(data__[data_offset + k]);
+                                    }
+                                }
+                            }
+                            fftwf_execute(planf_backward_z_[tid]);
+                            for (int j = 0; j < nc; j++) {
+                                for (int r = 0; r < comm_.size(); r++) {
+                                    int lsz  = spl_z_.local_size(r);
+                                    int offs = spl_z_.global_offset(r);
+                                    std::copy(&buf[j * size(2) + offs], &buf[j * size(2) + offs] + lsz,
+                                              &aux__[offs * num_zcol_local + (i0 + j) * lsz]);
+                                }
+                            }
+                            break;
+                        }
+                        case -1: {
+                            for (int j = 0; j < nc; j++) {
+                                for (int r = 0; r < comm_.size(); r++) {
+                                    int lsz  = spl_z_.local_size(r);
+                                    int offs = spl_z_.global_offset(r);
+                                    std::copy(&aux__[offs * num_zcol_local + (i0 + j) * lsz],
+                                              &aux__[offs * num_zcol_local + (i0 + j) * lsz] + lsz,
+                                              &buf[j * size(2) + offs]);
+                                }
+                            }
+                            std::fill(buf + nc * size(2), buf + zcol_block_size * size(2), 0);
+                            fftwf_execute(planf_forward_z_[tid]);
+                            for (int j = 0; j < nc; j++) {
+                                int icol = gvec_partition_->idx_zcol<index_domain_t::local>(i0 + j);
+                                int data_offset = gvec_partition_->zcol_offs(icol);
+                                auto& zcol = gvec_partition_->gvec().zcol(icol);
+                                for (size_t k = 0; k < zcol.z.size(); k++) {
+                                    data__[data_offset + k] = buf[j * size(2) + coord_by_freq<2>(zcol.z[k])] * norm;
+                                }
+                            }
+                            break;
+                        }
+                        default: {
+                            TERMINATE("wrong direction");
+                        }
+                    }
+                }
+            }
+        }
+
+        /// Single-precision 2D transformation of the local z-slab.
+        template <int direction>
+        void transform_xy_fp32(std::complex<float>* aux__)
+        {
+            PROFILE("sddk::FFT3D::transform_xy_fp32");
+
+            int size_xy = size(0) * size(1);
+            int num_zcol = gvec_partition_->gvec().num_zcol();
+            bool is_reduced = gvec_partition_->gvec().reduced();
+
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                std::complex<float>* buf = fftwf_buffer_xy_[tid];
+                #pragma omp for schedule(static)
+                for (int iz = 0; iz < local_size_z_; iz++) {
+                    switch (direction) {
+                        case 1: {
+                            std::fill(buf, buf + size_xy, 0);
+                            for (int i = 0; i < num_zcol; i++) {
+                                buf[z_col_pos_(i, 0)] = aux__[iz + i * local_size_z_];
+                                if (is_reduced && i) {
+                                    buf[z_col_pos_(i, 1)] = std::conj(buf[z_col_pos_(i, 0)]);
+                                }
+                            }
+                            fftwf_execute(planf_backward_xy_[tid]);
+                            std::copy(buf, buf + size_xy, &fft_buffer_fp32_[iz * size_xy]);
+                            break;
+                        }
+                        case -1: {
+                            std::copy(&fft_buffer_fp32_[iz * size_xy], &fft_buffer_fp32_[iz * size_xy] + size_xy, buf);
+                            fftwf_execute(planf_forward_xy_[tid]);
+                            for (int i = 0; i < num_zcol; i++) {
+                                aux__[iz + i * local_size_z_] = buf[z_col_pos_(i, 0)];
+                            }
+                            break;
+                        }
+                        default: {
+                            TERMINATE("wrong direction");
+                        }
+                    }
+                }
+            }
+        }
+#endif
+
+        /// Apply 2D c2r / r2c FFT transformation to z-columns of a real function.
+        /** Only the y-columns with x-coordinate in [0, size(0) / 2] are needed for the c2r transform; each of them is
+         *  either a z-column of the reduced G-vector set or its {-x,-y} mirror. The real-space xy-planes are
+         *  transformed in place of the output array. */
+        template <int direction>
+        void transform_xy_real(mdarray<double_complex, 1>& fft_buffer_aux__, double* f_rg__)
+        {
+            PROFILE("sddk::FFT3D::transform_xy_real");
+
+            int size_xy = size(0) * size(1);
+            /* leading dimension of the half-complex xy-plane */
+            int nxh = size(0) / 2 + 1;
+            int num_zcol = gvec_partition_->gvec().num_zcol();
+
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                double_complex* buf = fftw_buffer_xy_[tid];
+                #pragma omp for schedule(static)
+                for (int iz = 0; iz < local_size_z_; iz++) {
+                    switch (direction) {
+                        case 1: {
+                            /* clear half-complex xy-buffer */
+                            std::fill(buf, buf + nxh * size(1), 0);
+                            /* load z-columns into proper location */
+                            for (int i = 0; i < num_zcol; i++) {
+                                int x = z_col_pos_(i, 0) % size(0);
+                                int y = z_col_pos_(i, 0) / size(0);
+                                if (x < nxh) {
+                                    buf[x + nxh * y] = fft_buffer_aux__[iz + i * local_size_z_];
+                                }
+                                if (i) {
+                                    x = z_col_pos_(i, 1) % size(0);
+                                    y = z_col_pos_(i, 1) / size(0);
+                                    if (x < nxh) {
+                                        buf[x + nxh * y] = std::conj(fft_buffer_aux__[iz + i * local_size_z_]);
+                                    }
+                                }
+                            }
+                            /* execute c2r transform; output goes directly to the real-space array */
+                            fftw_execute_dft_c2r(plan_backward_xy_c2r_[tid], (fftw_complex*)buf, &f_rg__[iz * size_xy]);
+                            break;
+                        }
+                        case -1: {
+                            /* execute r2c transform; real-space array is preserved */
+                            fftw_execute_dft_r2c(plan_forward_xy_r2c_[tid], &f_rg__[iz * size_xy], (fftw_complex*)buf);
+                            /* get z-columns */
+                            for (int i = 0; i < num_zcol; i++) {
+                                int x = z_col_pos_(i, 0) % size(0);
+                                int y = z_col_pos_(i, 0) / size(0);
+                                if (x < nxh) {
+                                    fft_buffer_aux__[iz + i * local_size_z_] = buf[x + nxh * y];
+                                } else {
+                                    /* mirror column is in the stored half of the plane */
+                                    x = z_col_pos_(i, 1) % size(0);
+                                    y = z_col_pos_(i, 1) / size(0);
+                                    fft_buffer_aux__[iz + i * local_size_z_] = std::conj(buf[x + nxh * y]);
+                                }
+                            }
+                            break;
+                        }
+                        default: {
+                            TERMINATE("wrong direction");
+                        }
+                    }
+                }
+            }
+        }
+
+        /// True if the pencil decomposition is used.
+        inline bool is_pencil() const
+        {
+            return num_ranks_y_ > 1;
+        }
+
+        /// Position of a z-column in the y-pencil buffer or -1 if the column is not in the local x-range.
+        inline int pencil_ypos(int xy__) const
+        {
+            int x = xy__ % size(0) - spl_x_.global_offset();
+            int y = xy__ / size(0);
+            return (x >= 0 && x < spl_x_.local_size()) ? y + size(1) * x : -1;
+        }
+
+        /// Build the lists of z-columns exchanged between the full columns and the y-pencils.
+        void prepare_pencil(Gvec_partition const& gvp__)
+        {
+            int p2 = num_ranks_y_;
+            int num_zcol_local = gvp__.zcol_count_fft();
+            bool is_reduced = gvp__.gvec().reduced();
+
+            /* range of x-coordinates of y-pencils of a rank in comm_xy_ */
+            auto in_xrange = [&](int xy, int j) {
+                int x = xy % size(0) - spl_x_.global_offset(j);
+                return (x >= 0 && x < spl_x_.local_size(j));
+            };
+
+            for (int d = 0; d < 2; d++) {
+                pencil_local_zcols_[d] = std::vector<std::vector<int>>(p2);
+                pencil_remote_zcols_[d] = std::vector<std::vector<int>>(comm_.size());
+            }
+
+            int offs = gvp__.zcol_offset_fft(comm_.rank());
+            for (int j = 0; j < p2; j++) {
+                for (int i = 0; i < num_zcol_local; i++) {
+                    int c = offs + i;
+                    if (in_xrange(z_col_pos_(c, 0), j)) {
+                        pencil_local_zcols_[0][j].push_back(i);
+                        pencil_local_zcols_[1][j].push_back(i);
+                    } else if (is_reduced && c && in_xrange(z_col_pos_(c, 1), j)) {
+                        pencil_local_zcols_[0][j].push_back(i);
+                    }
+                }
+            }
+
+            int ry = comm_xy_.rank();
+            for (int r = 0; r < comm_.size(); r++) {
+                for (int i = 0; i < gvp__.zcol_count_fft(r); i++) {
+                    int c = gvp__.zcol_offset_fft(r) + i;
+                    if (in_xrange(z_col_pos_(c, 0), ry)) {
+                        pencil_remote_zcols_[0][r].push_back(c);
+                        pencil_remote_zcols_[1][r].push_back(c);
+                    } else if (is_reduced && c && in_xrange(z_col_pos_(c, 1), ry)) {
+                        pencil_remote_zcols_[0][r].push_back(c);
+                    }
+                }
+            }
+
+            /* size of the buffers for the exchange of z-columns; the lists of the backward transform are the longest
+             * and the roles of the send and receive buffers are swapped in the forward transform */
+            size_t sz_loc{0};
+            size_t sz_rem{0};
+            for (int r = 0; r < comm_.size(); r++) {
+                sz_loc += pencil_local_zcols_[0][r % p2].size() * spl_z_.local_size(r / p2);
+                sz_rem += pencil_remote_zcols_[0][r].size() * local_size_z_;
+            }
+            /* size of the buffers for the transpose between y-pencils and x-rows */
+            size_t sz_xy = static_cast<size_t>(spl_x_.local_size()) * size(1) * local_size_z_;
+            size_t sz = std::max(std::max<size_t>(1, local_size()), std::max(sz_xy, std::max(sz_loc, sz_rem)));
+            if (pencil_send_buf_.size() < sz) {
+                pencil_send_buf_ = mdarray<double_complex, 1>(sz, memory_t::host, "FFT3D.pencil_send_buf_");
+            }
+            if (pencil_recv_buf_.size() < sz) {
+                pencil_recv_buf_ = mdarray<double_complex, 1>(sz, memory_t::host, "FFT3D.pencil_recv_buf_");
+            }
+            size_t sz_zcol = std::max<size_t>(1, static_cast<size_t>(size(2)) * num_zcol_local);
+            if (pencil_zcol_buf_.size() < sz_zcol) {
+                pencil_zcol_buf_ = mdarray<double_complex, 1>(sz_zcol, memory_t::host, "FFT3D.pencil_zcol_buf_");
+            }
+        }
+
+        /// Exchange z-columns between the full local columns and the local z-slab of y-pencils.
+        /** In the backward transform each rank receives the z-slice of the columns whose x-coordinate (or x-coordinate
+         *  of the {-x,-y} mirror for reduced G-vectors) belongs to its x-range; in the forward transform the slices
+         *  travel back. The exchange is done over the full FFT communicator. */
+        template <int direction>
+        void pencil_transpose_zcol()
+        {
+            PROFILE("sddk::FFT3D::pencil_transpose_zcol");
+
+            int p2 = num_ranks_y_;
+            int d  = (direction == 1) ? 0 : 1;
+            int ny = size(1);
+            size_t ystride = static_cast<size_t>(spl_x_.local_size()) * ny;
+            bool is_reduced = gvec_partition_->gvec().reduced();
+
+            /* descriptors of the local full columns and of the remote columns */
+            block_data_descriptor loc(comm_.size());
+            block_data_descriptor rem(comm_.size());
+            for (int r = 0; r < comm_.size(); r++) {
+                loc.counts[r] = static_cast<int>(pencil_local_zcols_[d][r % p2].size()) * spl_z_.local_size(r / p2);
+                rem.counts[r] = static_cast<int>(pencil_remote_zcols_[d][r].size()) * local_size_z_;
+            }
+            loc.calc_offsets();
+            rem.calc_offsets();
+
+            double_complex* zbuf = pencil_zcol_buf_.at<CPU>();
+            double_complex* ybuf = pencil_y_buf_.at<CPU>();
+
+            switch (direction) {
+                case 1: {
+                    #pragma omp parallel for schedule(static)
+                    for (int r = 0; r < comm_.size(); r++) {
+                        int lsz  = spl_z_.local_size(r / p2);
+                        int offs = spl_z_.global_offset(r / p2);
+                        auto& cols = pencil_local_zcols_[d][r % p2];
+                        for (size_t k = 0; k < cols.size(); k++) {
+                            std::copy(&zbuf[cols[k] * size(2) + offs], &zbuf[cols[k] * size(2) + offs] + lsz,
+                                      &pencil_send_buf_[loc.offsets[r] + k * lsz]);
+                        }
+                    }
+                    comm_.alltoall(pencil_send_buf_.at<CPU>(), &loc.counts[0], &loc.offsets[0],
+                                   pencil_recv_buf_.at<CPU>(), &rem.counts[0], &rem.offsets[0]);
+
+                    std::fill(ybuf, ybuf + ystride * local_size_z_, 0);
+                    /* each position of the y-pencils is written by one column */
+                    #pragma omp parallel for schedule(static)
+                    for (int r = 0; r < comm_.size(); r++) {
+                        auto& cols = pencil_remote_zcols_[d][r];
+                        for (size_t k = 0; k < cols.size(); k++) {
+                            int c  = cols[k];
+                            int p0 = pencil_ypos(z_col_pos_(c, 0));
+                            int p1 = (is_reduced && c) ? pencil_ypos(z_col_pos_(c, 1)) : -1;
+                            double_complex const* v = &pencil_recv_buf_[rem.offsets[r] + k * local_size_z_];
+                            for (int iz = 0; iz < local_size_z_; iz++) {
+                                if (p0 >= 0) {
+                                    ybuf[p0 + iz * ystride] = v[iz];
+                                }
+                                if (p1 >= 0) {
+                                    ybuf[p1 + iz * ystride] = std::conj(v[iz]);
+                                }
+                            }
+                        }
+                    }
+                    break;
+                }
+                case -1: {
+                    #pragma omp parallel for schedule(static)
+                    for (int r = 0; r < comm_.size(); r++) {
+                        auto& cols = pencil_remote_zcols_[d][r];
+                        for (size_t k = 0; k < cols.size(); k++) {
+                            int p0 = pencil_ypos(z_col_pos_(cols[k], 0));
+                            for (int iz = 0; iz < local_size_z_; iz++) {
+                                pencil_send_buf_[rem.offsets[r] + k * local_size_z_ + iz] = ybuf[p0 + iz * ystride];
+                            }
+                        }
+                    }
+                    comm_.alltoall(pencil_send_buf_.at<CPU>(), &rem.counts[0], &rem.offsets[0],
+                                   pencil_recv_buf_.at<CPU>(), &loc.counts[0], &loc.offsets[0]);
+
+                    #pragma omp parallel for schedule(static)
+                    for (int r = 0; r < comm_.size(); r++) {
+                        int lsz  = spl_z_.local_size(r / p2);
+                        int offs = spl_z_.global_offset(r / p2);
+                        auto& cols = pencil_local_zcols_[d][r % p2];
+                        for (size_t k = 0; k < cols.size(); k++) {
+                            std::copy(&pencil_recv_buf_[loc.offsets[r] + k * lsz],
+                                      &pencil_recv_buf_[loc.offsets[r] + k * lsz] + lsz,
+                                      &zbuf[cols[k] * size(2) + offs]);
+                        }
+                    }
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+        /// Transpose the local z-slab between y-pencils and x-rows of the FFT buffer.
+        /** The exchange is done between the ranks of comm_xy_ which share the same z-slab. */
+        template <int direction>
+        void pencil_transpose_xy()
+        {
+            PROFILE("sddk::FFT3D::pencil_transpose_xy");
+
+            int p2 = num_ranks_y_;
+            int nx = size(0);
+            int ny = size(1);
+            int nx_loc = spl_x_.local_size();
+
+            /* descriptors of the y-pencils and of the x-rows */
+            block_data_descriptor ypen(p2);
+            block_data_descriptor xrow(p2);
+            for (int j = 0; j < p2; j++) {
+                ypen.counts[j] = nx_loc * spl_y_.local_size(j) * local_size_z_;
+                xrow.counts[j] = spl_x_.local_size(j) * local_size_y_ * local_size_z_;
+            }
+            ypen.calc_offsets();
+            xrow.calc_offsets();
+
+            double_complex* ybuf = pencil_y_buf_.at<CPU>();
+
+            /* pack (backward) or unpack (forward) the y-pencils */
+            auto copy_ypen = [&](double_complex* buf, bool pack) {
+                #pragma omp parallel for schedule(static)
+                for (int iz = 0; iz < local_size_z_; iz++) {
+                    for (int j = 0; j < p2; j++) {
+                        int ny_j = spl_y_.local_size(j);
+                        int y0_j = spl_y_.global_offset(j);
+                        for (int x = 0; x < nx_loc; x++) {
+                            double_complex* p = &buf[ypen.offsets[j] + ny_j * (x + nx_loc * iz)];
+                            double_complex* q = &ybuf[y0_j + ny * (x + nx_loc * iz)];
+                            if (pack) {
+                                std::copy(q, q + ny_j, p);
+                            } else {
+                                std::copy(p, p + ny_j, q);
+                            }
+                        }
+                    }
+                }
+            };
+
+            /* pack (forward) or unpack (backward) the x-rows of the FFT buffer */
+            auto copy_xrow = [&](double_complex* buf, bool pack) {
+                #pragma omp parallel for schedule(static)
+                for (int iz = 0; iz < local_size_z_; iz++) {
+                    for (int j = 0; j < p2; j++) {
+                        int nx_j = spl_x_.local_size(j);
+                        int x0_j = spl_x_.global_offset(j);
+                        for (int x = 0; x < nx_j; x++) {
+                            for (int y = 0; y < local_size_y_; y++) {
+                                double_complex& p = buf[xrow.offsets[j] + y + local_size_y_ * (x + nx_j * iz)];
+                                double_complex& q = fft_buffer_[x0_j + x + nx * (y + local_size_y_ * iz)];
+                                if (pack) {
+                                    p = q;
+                                } else {
+                                    q = p;
+                                }
+                            }
+                        }
+                    }
+                }
+            };
+
+            switch (direction) {
+                case 1: {
+                    copy_ypen(pencil_send_buf_.at<CPU>(), true);
+                    comm_xy_.alltoall(pencil_send_buf_.at<CPU>(), &ypen.counts[0], &ypen.offsets[0],
+                                      pencil_recv_buf_.at<CPU>(), &xrow.counts[0], &xrow.offsets[0]);
+                    copy_xrow(pencil_recv_buf_.at<CPU>(), false);
+                    break;
+                }
+                case -1: {
+                    copy_xrow(pencil_send_buf_.at<CPU>(), true);
+                    comm_xy_.alltoall(pencil_send_buf_.at<CPU>(), &xrow.counts[0], &xrow.offsets[0],
+                                      pencil_recv_buf_.at<CPU>(), &ypen.counts[0], &ypen.offsets[0]);
+                    copy_ypen(pencil_recv_buf_.at<CPU>(), false);
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+        /// Transform a single function in the pencil decomposition.
+        /** Backward transform: local z-columns are transformed, z-slices of the columns are sent to the ranks
+         *  holding the y-pencils of the corresponding x-range, y-pencils are transformed, transposed within the z-slab
+         *  into x-rows and the x-rows are transformed. The forward transform is done in the opposite order. */
+        template <int direction>
+        void transform_pencil(double_complex* data__)
+        {
+            PROFILE("sddk::FFT3D::transform_pencil");
+
+            size_t ystride = static_cast<size_t>(spl_x_.local_size()) * size(1);
+            size_t xstride = static_cast<size_t>(size(0)) * local_size_y_;
+
+            switch (direction) {
+                case 1: {
+                    transform_z_cpu<1>(1, data__, 0, pencil_zcol_buf_.at<CPU>());
+                    pencil_transpose_zcol<1>();
+                    #pragma omp parallel for schedule(static)
+                    for (int iz = 0; iz < (plan_backward_y_pencil_ ? local_size_z_ : 0); iz++) {
+                        auto ptr = (fftw_complex*)pencil_y_buf_.at<CPU>(iz * ystride);
+                        fftw_execute_dft(plan_backward_y_pencil_, ptr, ptr);
+                    }
+                    pencil_transpose_xy<1>();
+                    #pragma omp parallel for schedule(static)
+                    for (int iz = 0; iz < (plan_backward_x_pencil_ ? local_size_z_ : 0); iz++) {
+                        auto ptr = (fftw_complex*)fft_buffer_.at<CPU>(iz * xstride);
+                        fftw_execute_dft(plan_backward_x_pencil_, ptr, ptr);
+                    }
+                    break;
+                }
+                case -1: {
+                    #pragma omp parallel for schedule(static)
+                    for (int iz = 0; iz < (plan_forward_x_pencil_ ? local_size_z_ : 0); iz++) {
+                        auto ptr = (fftw_complex*)fft_buffer_.at<CPU>(iz * xstride);
+                        fftw_execute_dft(plan_forward_x_pencil_, ptr, ptr);
+                    }
+                    pencil_transpose_xy<-1>();
+                    #pragma omp parallel for schedule(static)
+                    for (int iz = 0; iz < (plan_forward_y_pencil_ ? local_size_z_ : 0); iz++) {
+                        auto ptr = (fftw_complex*)pencil_y_buf_.at<CPU>(iz * ystride);
+                        fftw_execute_dft(plan_forward_y_pencil_, ptr, ptr);
+                    }
+                    pencil_transpose_zcol<-1>();
+                    transform_z_cpu<-1>(1, data__, 0, pencil_zcol_buf_.at<CPU>());
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+    public:
+
+        /// Constructor.
+        /** \param [in] initial_dims     Minimum dimensions of the FFT grid.
+         *  \param [in] comm             Communicator for the parallel FFT.
+         *  \param [in] pu               Main processing unit.
+         *  \param [in] fftw_plan_flags  Planner flags of FFTW plans (FFTW_ESTIMATE, FFTW_MEASURE or FFTW_PATIENT).
+         *  \param [in] num_ranks_y      Number of ranks in y-dimension of the pencil decomposition.
+         *
+         *  Measured plans are much more expensive to create; use them together with the FFTW wisdom
+         *  (see import_fftw_wisdom() and export_fftw_wisdom()) to avoid re-planning in the subsequent runs.
+         *
+         *  If num_ranks_y is larger than one, the ranks are arranged in a (comm.size() / num_ranks_y) x num_ranks_y
+         *  grid with rank = rank_y + num_ranks_y * rank_z and the real-space buffer of each rank holds a
+         *  size(0) x local_size_y() x local_size_z() pencil. This allows to use more ranks than the number of
+         *  z-planes. The pencil decomposition is implemented only for CPU. */
+        FFT3D(std::array<int, 3>  initial_dims__,
+              Communicator const& comm__,
+              device_t            pu__,
+              unsigned int        fftw_plan_flags__ = FFTW_ESTIMATE,
+              int                 num_ranks_y__ = 1)
+            : FFT3D_grid(initial_dims__)
+            , comm_(comm__)
+            , pu_(pu__)
+            , fftw_plan_flags_(fftw_plan_flags__)
+            , num_ranks_y_(std::max(1, num_ranks_y__))
+        {
+            PROFILE("sddk::FFT3D::FFT3D");
+
+            if (is_pencil()) {
+                if (comm_.size() % num_ranks_y_) {
+                    std::stringstream s;
+                    s << "number of FFT ranks (" << comm_.size() << ") is not divisible by the number of ranks "
+                      << "in y-dimension of the pencil decomposition (" << num_ranks_y_ << ")";
+                    TERMINATE(s);
+                }
+                if (pu_ != CPU) {
+                    TERMINATE("pencil decomposition of FFT is implemented only for CPU");
+                }
+                if (comm_.size() / num_ranks_y_ > size(2) || num_ranks_y_ > std::min(size(0), size(1))) {
+                    TERMINATE("too many ranks for the pencil decomposition of FFT");
+                }
+                comm_xy_ = comm_.split(comm_.rank() / num_ranks_y_);
+            }
+
+            /* split z-direction */
+            spl_z_        = splindex<block>(size(2), comm_.size() / num_ranks_y_, comm_.rank() / num_ranks_y_);
+            local_size_z_ = spl_z_.local_size();
+            offset_z_     = spl_z_.global_offset();
+
+            /* split y- and x-directions; in case of slab decomposition the full xy-plane is local */
+            spl_y_        = splindex<block>(size(1), num_ranks_y_, comm_.rank() % num_ranks_y_);
+            local_size_y_ = spl_y_.local_size();
+            offset_y_     = spl_y_.global_offset();
+            spl_x_        = splindex<block>(size(0), num_ranks_y_, comm_.rank() % num_ranks_y_);
+
+            if (pu_ == CPU) {
+                host_memory_type_ = memory_t::host;
+            } else {
+                host_memory_type_ = memory_t::host_pinned;
+            }
+
+            /* allocate main buffer */
+            fft_buffer_ = mdarray<double_complex, 1>(local_size(), host_memory_type_, "FFT3D.fft_buffer_");
+
+            /* allocate 1d and 2d buffers */
             for (int i = 0; i < omp_get_max_threads(); i++) {
-                plan_forward_z_[i] = fftw_plan_dft_1d(size(2), (fftw_complex*)fftw_buffer_z_[i],
-                                                      (fftw_complex*)fftw_buffer_z_[i], FFTW_FORWARD, FFTW_ESTIMATE);
+                fftw_buffer_z_.push_back(nullptr);
+                fftw_buffer_xy_.push_back((double_complex*)fftw_malloc(size(0) * size(1) * sizeof(double_complex)));
+            }
 
-                plan_backward_z_[i] = fftw_plan_dft_1d(size(2), (fftw_complex*)fftw_buffer_z_[i],
-                                                       (fftw_complex*)fftw_buffer_z_[i], FFTW_BACKWARD, FFTW_ESTIMATE);
+            plan_forward_z_   = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_forward_xy_  = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_backward_z_  = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_backward_xy_ = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_forward_x_   = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_backward_x_  = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_forward_y_   = std::vector<std::vector<fftw_plan>>(omp_get_max_threads());
+            plan_backward_y_  = std::vector<std::vector<fftw_plan>>(omp_get_max_threads());
+            plan_backward_xy_c2r_ = std::vector<fftw_plan>(omp_get_max_threads(), nullptr);
+            plan_forward_xy_r2c_  = std::vector<fftw_plan>(omp_get_max_threads(), nullptr);
 
+            for (int i = 0; i < omp_get_max_threads(); i++) {
                 plan_forward_xy_[i] = fftw_plan_dft_2d(size(1), size(0), (fftw_complex*)fftw_buffer_xy_[i],
-                                                       (fftw_complex*)fftw_buffer_xy_[i], FFTW_FORWARD, FFTW_ESTIMATE);
+                                                       (fftw_complex*)fftw_buffer_xy_[i], FFTW_FORWARD, fftw_plan_flags_);
 
                 plan_backward_xy_[i] = fftw_plan_dft_2d(size(1), size(0), (fftw_complex*)fftw_buffer_xy_[i],
-                                                        (fftw_complex*)fftw_buffer_xy_[i], FFTW_BACKWARD, FFTW_ESTIMATE);
+                                                        (fftw_complex*)fftw_buffer_xy_[i], FFTW_BACKWARD, fftw_plan_flags_);
+
+                int n[] = {size(0)};
+                plan_forward_x_[i] = fftw_plan_many_dft(1, n, size(1), (fftw_complex*)fftw_buffer_xy_[i], NULL, 1, size(0),
+                                                        (fftw_complex*)fftw_buffer_xy_[i], NULL, 1, size(0), FFTW_FORWARD,
+                                                        fftw_plan_flags_);
+
+                plan_backward_x_[i] = fftw_plan_many_dft(1, n, size(1), (fftw_complex*)fftw_buffer_xy_[i], NULL, 1, size(0),
+                                                         (fftw_complex*)fftw_buffer_xy_[i], NULL, 1, size(0), FFTW_BACKWARD,
+                                                         fftw_plan_flags_);
+            }
+
+            /* plans for the real functions are executed with the real-space planes of the output array */
+            if (pu_ == CPU && !is_pencil()) {
+                double* tmp = (double*)fftw_malloc(size(0) * size(1) * sizeof(double));
+                for (int i = 0; i < omp_get_max_threads(); i++) {
+                    plan_backward_xy_c2r_[i] = fftw_plan_dft_c2r_2d(size(1), size(0), (fftw_complex*)fftw_buffer_xy_[i],
+                                                                    tmp, fftw_plan_flags_ | FFTW_UNALIGNED);
+                    plan_forward_xy_r2c_[i] = fftw_plan_dft_r2c_2d(size(1), size(0), tmp, (fftw_complex*)fftw_buffer_xy_[i],
+                                                                   fftw_plan_flags_ | FFTW_UNALIGNED);
+                }
+                fftw_free(tmp);
+            }
+
+            if (is_pencil()) {
+                int nx_loc = spl_x_.local_size();
+                /* local parts of the pencils can be empty if the dimension is not divisible by the number of ranks;
+                 * keep at least one element to have valid pointers */
+                pencil_y_buf_ = mdarray<double_complex, 1>(std::max<size_t>(1, static_cast<size_t>(nx_loc) * size(1) * local_size_z_),
+                                                           memory_t::host, "FFT3D.pencil_y_buf_");
+                pencil_tmp_buf_ = mdarray<double_complex, 1>(std::max(1, local_size()), memory_t::host,
+                                                             "FFT3D.pencil_tmp_buf_");
+                if (!local_size()) {
+                    fft_buffer_ = mdarray<double_complex, 1>(1, host_memory_type_, "FFT3D.fft_buffer_");
+                }
+
+                /* plans are executed for each z-plane with fftw_execute_dft() */
+                unsigned int flags = fftw_plan_flags_ | FFTW_UNALIGNED;
+
+                int ny[] = {size(1)};
+                auto yptr = (fftw_complex*)pencil_y_buf_.at<CPU>();
+                if (nx_loc && local_size_z_) {
+                    plan_backward_y_pencil_ = fftw_plan_many_dft(1, ny, nx_loc, yptr, NULL, 1, size(1), yptr, NULL, 1,
+                                                                 size(1), FFTW_BACKWARD, flags);
+                    plan_forward_y_pencil_ = fftw_plan_many_dft(1, ny, nx_loc, yptr, NULL, 1, size(1), yptr, NULL, 1,
+                                                                size(1), FFTW_FORWARD, flags);
+                }
+                int nx[] = {size(0)};
+                auto xptr = (fftw_complex*)fft_buffer_.at<CPU>();
+                if (local_size()) {
+                    plan_backward_x_pencil_ = fftw_plan_many_dft(1, nx, local_size_y_, xptr, NULL, 1, size(0), xptr, NULL,
+                                                                 1, size(0), FFTW_BACKWARD, flags);
+                    plan_forward_x_pencil_ = fftw_plan_many_dft(1, nx, local_size_y_, xptr, NULL, 1, size(0), xptr, NULL,
+                                                                1, size(0), FFTW_FORWARD, flags);
+                }
             }
 
 #ifdef __GPU
@@ -833,13 +1952,21 @@ class FFT3D: public FFT3D_grid
                 dismiss();
             }
             for (int i = 0; i < omp_get_max_threads(); i++) {
-                fftw_free(fftw_buffer_z_[i]);
                 fftw_free(fftw_buffer_xy_[i]);
 
-                fftw_destroy_plan(plan_forward_z_[i]);
                 fftw_destroy_plan(plan_forward_xy_[i]);
-                fftw_destroy_plan(plan_backward_z_[i]);
                 fftw_destroy_plan(plan_backward_xy_[i]);
+                fftw_destroy_plan(plan_forward_x_[i]);
+                fftw_destroy_plan(plan_backward_x_[i]);
+                if (plan_backward_xy_c2r_[i]) {
+                    fftw_destroy_plan(plan_backward_xy_c2r_[i]);
+                    fftw_destroy_plan(plan_forward_xy_r2c_[i]);
+                }
+            }
+            for (auto p: {plan_backward_y_pencil_, plan_forward_y_pencil_, plan_backward_x_pencil_, plan_forward_x_pencil_}) {
+                if (p) {
+                    fftw_destroy_plan(p);
+                }
             }
 #ifdef __GPU
             if (pu_ == GPU) {
@@ -900,7 +2027,25 @@ class FFT3D: public FFT3D_grid
         /// Size of the local part of FFT buffer.
         inline int local_size() const
         {
-            return size(0) * size(1) * local_size_z_;
+            return size(0) * local_size_y_ * local_size_z_;
+        }
+
+        /// Local size of y-dimension of FFT buffer.
+        /** This is equal to size(1) unless the pencil decomposition is used. */
+        inline int local_size_y() const
+        {
+            return local_size_y_;
+        }
+
+        inline int offset_y() const
+        {
+            return offset_y_;
+        }
+
+        /// Number of ranks in y-dimension of the pencil decomposition.
+        inline int num_ranks_y() const
+        {
+            return num_ranks_y_;
         }
 
         inline int local_size_z() const
@@ -975,6 +2120,12 @@ class FFT3D: public FFT3D_grid
                     z_col_pos_(i, 1) = x + y * size(0);
                 }
             }
+            create_z_plans(gvp__);
+            if (is_pencil()) {
+                prepare_pencil(gvp__);
+            } else if (pu_ == CPU) {
+                create_pruned_xy_plans(gvp__);
+            }
             t1.stop();
 
 #ifdef __GPU
@@ -1055,6 +2206,13 @@ class FFT3D: public FFT3D_grid
 
         void dismiss()
         {
+#ifdef __FFTWF
+            destroy_fp32_plans();
+#endif
+            destroy_z_plans();
+            if (pu_ == CPU && !is_pencil()) {
+                destroy_pruned_xy_plans();
+            }
             if (pu_ == GPU) {
                 fft_buffer_aux1_.deallocate(memory_t::device);
                 fft_buffer_aux2_.deallocate(memory_t::device);
@@ -1079,6 +2237,11 @@ class FFT3D: public FFT3D_grid
                 TERMINATE("FFT3D is not ready");
             }
 
+            if (is_pencil()) {
+                transform_pencil<direction>(data__);
+                return;
+            }
+
             reallocate_fft_buffer_aux(fft_buffer_aux1_);
 
             switch (direction) {
@@ -1120,6 +2283,40 @@ class FFT3D: public FFT3D_grid
                 TERMINATE("reduced set of G-vectors is required");
             }
 
+            /* in the pencil decomposition the functions are transformed one by one */
+            if (is_pencil()) {
+                switch (direction) {
+                    case 1: {
+                        transform_pencil<1>(data1__);
+                        std::copy(fft_buffer_.at<CPU>(), fft_buffer_.at<CPU>() + local_size(), pencil_tmp_buf_.at<CPU>());
+                        transform_pencil<1>(data2__);
+                        #pragma omp parallel for schedule(static)
+                        for (int ir = 0; ir < local_size(); ir++) {
+                            fft_buffer_[ir] = pencil_tmp_buf_[ir] + double_complex(0, 1) * fft_buffer_[ir];
+                        }
+                        break;
+                    }
+                    case -1: {
+                        std::copy(fft_buffer_.at<CPU>(), fft_buffer_.at<CPU>() + local_size(), pencil_tmp_buf_.at<CPU>());
+                        #pragma omp parallel for schedule(static)
+                        for (int ir = 0; ir < local_size(); ir++) {
+                            fft_buffer_[ir] = pencil_tmp_buf_[ir].real();
+                        }
+                        transform_pencil<-1>(data1__);
+                        #pragma omp parallel for schedule(static)
+                        for (int ir = 0; ir < local_size(); ir++) {
+                            fft_buffer_[ir] = pencil_tmp_buf_[ir].imag();
+                        }
+                        transform_pencil<-1>(data2__);
+                        break;
+                    }
+                    default: {
+                        TERMINATE("wrong direction");
+                    }
+                }
+                return;
+            }
+
             reallocate_fft_buffer_aux(fft_buffer_aux1_);
             reallocate_fft_buffer_aux(fft_buffer_aux2_);
 
@@ -1151,8 +2348,526 @@ class FFT3D: public FFT3D_grid
                 }
             }
         }
+
+        /// True if real functions can be transformed with the c2r / r2c FFT (see transform_real()).
+        inline bool real_transform_available() const
+        {
+            return (pu_ == CPU && !is_pencil() && gvec_partition_ && gvec_partition_->gvec().reduced());
+        }
+
+        /// Transform a real function.
+        /** \param [inout] data CPU pointer to the plane-wave coefficients of the reduced set of G-vectors.
+         *  \param [inout] f_rg CPU pointer to the local_size() real-space values of the function.
+         *
+         *  In contrast to transform(), the xy-planes are transformed with the c2r / r2c FFT of half the size and the
+         *  real-space values are read from or written to f_rg directly instead of the complex FFT buffer. */
+        template <int direction>
+        void transform_real(double_complex* data__, double* f_rg__)
+        {
+            PROFILE("sddk::FFT3D::transform_real");
+
+            if (!real_transform_available()) {
+                TERMINATE("real FFT requires CPU, slab decomposition and reduced set of G-vectors");
+            }
+
+            reallocate_fft_buffer_aux(fft_buffer_aux1_);
+
+            auto& plan_z = gvec_partition_->gvec().bare() ? cufft_plan_z_gvec_ : cufft_plan_z_gkvec_;
+
+            switch (direction) {
+                case 1: {
+                    transform_z<direction, CPU>(data__, fft_buffer_aux1_, plan_z);
+                    transform_xy_real<direction>(fft_buffer_aux1_, f_rg__);
+                    break;
+                }
+                case -1: {
+                    transform_xy_real<direction>(fft_buffer_aux1_, f_rg__);
+                    transform_z<direction, CPU>(data__, fft_buffer_aux1_, plan_z);
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+        /// True if complex functions can be transformed in single precision (see transform_fp32()).
+        inline bool fp32_transform_available() const
+        {
+#ifdef __FFTWF
+            return (pu_ == CPU && !is_pencil());
+#else
+            return false;
+#endif
+        }
+
+        /// Real-space buffer of the single-precision transformation.
+        inline mdarray<std::complex<float>, 1>& buffer_fp32()
+        {
+            return fft_buffer_fp32_;
+        }
+
+        /// Transform a single complex function in single precision.
+        /** \param [inout] data CPU pointer to the single-precision plane-wave coefficients.
+         *
+         *  Real-space values are stored in buffer_fp32(). The z-columns are exchanged in single precision, which
+         *  halves the communication volume compared to transform(). */
+        template <int direction>
+        void transform_fp32(std::complex<float>* data__)
+        {
+            PROFILE("sddk::FFT3D::transform_fp32");
+
+            if (!gvec_partition_) {
+                TERMINATE("FFT3D is not ready");
+            }
+            if (!fp32_transform_available()) {
+                TERMINATE("single-precision FFT requires CPU, slab decomposition and single-precision FFTW");
+            }
+#ifdef __FFTWF
+            if (planf_backward_xy_.empty()) {
+                create_fp32_plans();
+            }
+
+            int rank = comm_.rank();
+
+            /* z-columns of this rank and z-slabs of the FFT buffer */
+            block_data_descriptor zcol(comm_.size());
+            block_data_descriptor zslab(comm_.size());
+            for (int r = 0; r < comm_.size(); r++) {
+                zcol.counts[r]  = spl_z_.local_size(r) * gvec_partition_->zcol_count_fft(rank);
+                zslab.counts[r] = local_size_z_ * gvec_partition_->zcol_count_fft(r);
+            }
+            zcol.calc_offsets();
+            zslab.calc_offsets();
+
+            auto aux = fft_buffer_aux_fp32_.at<CPU>();
+            /* real-space buffer is used as a temporary storage for all-to-all */
+            auto tmp = fft_buffer_fp32_.at<CPU>();
+            size_t sz = static_cast<size_t>(gvec_partition_->gvec().num_zcol()) * local_size_z_;
+
+            switch (direction) {
+                case 1: {
+                    transform_z_fp32<1>(data__, aux);
+                    if (comm_.size() > 1) {
+                        comm_.alltoall(aux, &zcol.counts[0], &zcol.offsets[0], tmp, &zslab.counts[0], &zslab.offsets[0]);
+                        std::copy(tmp, tmp + sz, aux);
+                    }
+                    transform_xy_fp32<1>(aux);
+                    break;
+                }
+                case -1: {
+                    transform_xy_fp32<-1>(aux);
+                    if (comm_.size() > 1) {
+                        std::copy(aux, aux + sz, tmp);
+                        comm_.alltoall(tmp, &zslab.counts[0], &zslab.offsets[0], aux, &zcol.counts[0], &zcol.offsets[0]);
+                    }
+                    transform_z_fp32<-1>(data__, aux);
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+#endif
+        }
+
+        /// Make sure that the batch buffers can hold a given number of functions.
+        void reallocate_batch(int num_bands__)
+        {
+            if (!gvec_partition_) {
+                TERMINATE("FFT3D is not ready");
+            }
+            size_t sz_aux = std::max(size(2) * gvec_partition_->zcol_count_fft(),
+                                     local_size_z_ * gvec_partition_->gvec().num_zcol());
+            if (num_bands__ > num_batch_max_ || aux_batch_stride_ < sz_aux) {
+                num_batch_max_ = std::max(num_bands__, num_batch_max_);
+                aux_batch_stride_ = std::max(sz_aux, aux_batch_stride_);
+                fft_buffer_batch_ = mdarray<double_complex, 1>(std::max<size_t>(1, static_cast<size_t>(local_size()) * num_batch_max_),
+                                                               memory_t::host, "FFT3D.fft_buffer_batch_");
+                fft_buffer_aux_batch_ = mdarray<double_complex, 1>(aux_batch_stride_ * num_batch_max_, memory_t::host,
+                                                                   "FFT3D.fft_buffer_aux_batch_");
+            }
+        }
+
+        /// Pointer to the real-space values of a function in the batch buffer.
+        inline double_complex* buffer_batch(int ib__)
+        {
+            assert(ib__ < num_batch_max_);
+            return fft_buffer_batch_.at<CPU>(static_cast<size_t>(ib__) * local_size());
+        }
+
+        /// Set the number of functions in a chunk of the pipelined batched transformation.
+        /** Zero or negative value disables the pipelining. */
+        inline void set_pipeline_chunk_size(int chunk_size__)
+        {
+            pipeline_chunk_size_ = chunk_size__;
+        }
+
+        /// Check if a block of functions should be transformed band by band on separate threads.
+        /** On small grids the OpenMP loops inside a single transformation are too short and the threads mostly wait
+         *  at the implicit barriers. In this case it is faster to run a complete transformation of one function on
+         *  each thread (see transform_in_thread()). This is possible only for the serial CPU transformation in the
+         *  slab decomposition and makes sense only when there is at least one function per thread. */
+        inline bool band_parallel_preferred(int num_bands__) const
+        {
+            int nt = omp_get_max_threads();
+            return pu_ == CPU && comm_.size() == 1 && !is_pencil() && nt > 1 && num_bands__ >= nt &&
+                   local_size() / nt < band_parallel_max_points_;
+        }
+
+        /// Transform a single complex function on the calling thread.
+        /** \param [in]    slot Index of the function in the batch buffer.
+         *  \param [inout] data CPU pointer to the plane-wave coefficients of the function.
+         *
+         *  This is called from inside an OpenMP parallel region; the thread uses its private FFTW buffers and plans
+         *  and no other thread is involved. Real-space values are stored in buffer_batch(slot). The batch buffers
+         *  must be allocated beforehand with reallocate_batch() and each thread must use its own slot. Only the
+         *  serial CPU transformation in the slab decomposition is supported (see band_parallel_preferred()). */
+        template <int direction>
+        void transform_in_thread(int slot__, double_complex* data__)
+        {
+            assert(comm_.size() == 1 && !is_pencil());
+
+            int tid = omp_get_thread_num();
+            int num_zcol_local = gvec_partition_->zcol_count_fft();
+
+            switch (direction) {
+                case 1: {
+                    for (int i0 = 0; i0 < num_zcol_local; i0 += zcol_block_size_) {
+                        transform_z_block<1>(tid, 1, 0, i0, data__, aux_batch(slot__));
+                    }
+                    for (int iz = 0; iz < local_size_z_; iz++) {
+                        transform_xy_plane<1>(tid, iz, aux_batch(slot__), buffer_batch(slot__));
+                    }
+                    break;
+                }
+                case -1: {
+                    for (int iz = 0; iz < local_size_z_; iz++) {
+                        transform_xy_plane<-1>(tid, iz, aux_batch(slot__), buffer_batch(slot__));
+                    }
+                    for (int i0 = 0; i0 < num_zcol_local; i0 += zcol_block_size_) {
+                        transform_z_block<-1>(tid, 1, 0, i0, data__, aux_batch(slot__));
+                    }
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+        /// Transform a block of complex functions.
+        /** \param [in]    num_bands Number of functions in the block.
+         *  \param [inout] data      CPU pointer to the plane-wave coefficients of the first function.
+         *  \param [in]    ld        Leading dimension of the data array (distance between two functions).
+         *
+         *  Real-space values of the functions are stored in the batch buffer (see buffer_batch()). In contrast to
+         *  the transformation of a single function, z-columns of all functions are exchanged with a single
+         *  all-to-all call and the 1D and 2D transformations of different functions are executed in one parallel
+         *  region. Only the CPU execution is implemented.
+         *
+         *  In the pipelined mode the block is split into chunks of pipeline_chunk_size_ functions and each chunk
+         *  is exchanged with a non-blocking all-to-all. The exchange of one chunk is overlapped with the z-transform
+         *  (backward) or xy-transform (forward) of the next chunk. */
+        template <int direction>
+        void transform_batch(int num_bands__, double_complex* data__, int ld__)
+        {
+            PROFILE("sddk::FFT3D::transform_batch");
+
+            if (!gvec_partition_) {
+                TERMINATE("FFT3D is not ready");
+            }
+            if (pu_ != CPU) {
+                TERMINATE("batched FFT is implemented only for CPU");
+            }
+
+            reallocate_batch(num_bands__);
+
+            /* in the pencil decomposition the functions are transformed one by one */
+            if (is_pencil()) {
+                for (int ib = 0; ib < num_bands__; ib++) {
+                    double_complex* data = data__ + static_cast<size_t>(ld__) * ib;
+                    if (direction == 1) {
+                        transform_pencil<1>(data);
+                        std::copy(fft_buffer_.at<CPU>(), fft_buffer_.at<CPU>() + local_size(), buffer_batch(ib));
+                    } else {
+                        std::copy(buffer_batch(ib), buffer_batch(ib) + local_size(), fft_buffer_.at<CPU>());
+                        transform_pencil<-1>(data);
+                    }
+                }
+                return;
+            }
+
+            /* split functions in chunks */
+            int chunk_size = num_bands__;
+            if (comm_.size() > 1 && pipeline_chunk_size_ > 0) {
+                chunk_size = std::min(pipeline_chunk_size_, num_bands__);
+            }
+            int num_chunks = (num_bands__ + chunk_size - 1) / chunk_size;
+
+            auto chunk_offset = [&](int c) { return c * chunk_size; };
+            auto chunk_count  = [&](int c) { return std::min(chunk_size, num_bands__ - c * chunk_size); };
+
+            /* counts and offsets must stay alive until non-blocking exchange is finished */
+            std::vector<block_data_descriptor> send(num_chunks);
+            std::vector<block_data_descriptor> recv(num_chunks);
+            std::vector<Request> req(num_chunks);
+
+            auto z_transform = [&](int c) {
+                utils::timer t("sddk::FFT3D::transform_batch|z");
+                transform_z_cpu<direction>(chunk_count(c), data__ + static_cast<size_t>(ld__) * chunk_offset(c), ld__,
+                                           aux_batch(chunk_offset(c)));
+            };
+
+            auto start_exchange = [&](int c) {
+                batch_a2a_descriptors(chunk_count(c), direction, send[c], recv[c]);
+                if (direction == 1) {
+                    req[c] = comm_.ialltoall(aux_batch(chunk_offset(c)), send[c].counts.data(), send[c].offsets.data(),
+                                             buffer_batch(chunk_offset(c)), recv[c].counts.data(), recv[c].offsets.data());
+                } else {
+                    req[c] = comm_.ialltoall(buffer_batch(chunk_offset(c)), send[c].counts.data(), send[c].offsets.data(),
+                                             aux_batch(chunk_offset(c)), recv[c].counts.data(), recv[c].offsets.data());
+                }
+            };
+
+            auto finish_exchange = [&](int c) {
+                utils::timer t("sddk::FFT3D::transform_batch|wait");
+                req[c].wait();
+            };
+
+            switch (direction) {
+                case 1: {
+                    for (int c = 0; c < num_chunks; c++) {
+                        z_transform(c);
+                        if (comm_.size() > 1) {
+                            start_exchange(c);
+                            /* previous chunk is finished while the current one is in flight */
+                            if (c > 0) {
+                                finish_exchange(c - 1);
+                                repack_batch<direction>(chunk_offset(c - 1), chunk_count(c - 1));
+                                transform_xy_batch<direction>(chunk_offset(c - 1), chunk_count(c - 1));
+                            }
+                        } else {
+                            transform_xy_batch<direction>(chunk_offset(c), chunk_count(c));
+                        }
+                    }
+                    if (comm_.size() > 1) {
+                        int c = num_chunks - 1;
+                        finish_exchange(c);
+                        repack_batch<direction>(chunk_offset(c), chunk_count(c));
+                        transform_xy_batch<direction>(chunk_offset(c), chunk_count(c));
+                    }
+                    break;
+                }
+                case -1: {
+                    for (int c = 0; c < num_chunks; c++) {
+                        transform_xy_batch<direction>(chunk_offset(c), chunk_count(c));
+                        if (comm_.size() > 1) {
+                            repack_batch<direction>(chunk_offset(c), chunk_count(c));
+                            start_exchange(c);
+                            /* previous chunk is finished while the current one is in flight */
+                            if (c > 0) {
+                                finish_exchange(c - 1);
+                                z_transform(c - 1);
+                            }
+                        } else {
+                            z_transform(c);
+                        }
+                    }
+                    if (comm_.size() > 1) {
+                        int c = num_chunks - 1;
+                        finish_exchange(c);
+                        z_transform(c);
+                    }
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
 };
 
+/// Find FFT grid dimensions with the fastest transformation.
+/** \param [in] initial_dims  Minimum dimensions of the FFT grid.
+ *  \param [in] tolerance     Relative increase of each dimension above its minimum optimal size.
+ *  \param [in] num_ranks_fft Number of ranks in the FFT communicator.
+ *  \param [in] comm          Communicator of all ranks which must get the same grid.
+ *
+ *  Candidate sizes of each dimension are the optimal sizes in the range [n, n * (1 + tolerance)]. Time of the
+ *  slab-decomposed transform of a single function is estimated on a single rank as
+ *  \f[
+ *      T = \lceil N_z^{loc} / N_{t} \rceil t_{xy}(N_x, N_y) + \lceil N_{col}^{loc} / N_{t} \rceil t_{z}(N_z)
+ *  \f]
+ *  where \f$ N_z^{loc} \f$ is the largest local size of z-dimension (uneven split of z is penalized),
+ *  \f$ N_{col}^{loc} \f$ is the local number of z-columns of the G-sphere inscribed in the initial box and
+ *  \f$ N_t \f$ is the number of OpenMP threads. Timings of 1D and 2D transforms are measured on rank 0 and the
+ *  chosen dimensions are broadcasted. The result is cached for the subsequent calls with the same arguments. */
+inline std::array<int, 3> find_fast_fft_grid(std::array<int, 3> initial_dims__, double tolerance__, int num_ranks_fft__,
+                                             Communicator const& comm__)
+{
+    PROFILE("sddk::find_fast_fft_grid");
+
+    int nt = omp_get_max_threads();
+
+    static std::map<std::tuple<int, int, int, double, int, int>, std::array<int, 3>> cache;
+    auto key = std::make_tuple(initial_dims__[0], initial_dims__[1], initial_dims__[2], tolerance__, num_ranks_fft__, nt);
+    if (cache.count(key)) {
+        return cache[key];
+    }
+
+    std::array<std::vector<int>, 3> candidates;
+    for (int i = 0; i < 3; i++) {
+        int n_min = FFT3D_grid::find_grid_sizes(initial_dims__[i], initial_dims__[i]).front();
+        candidates[i] = FFT3D_grid::find_grid_sizes(n_min, static_cast<int>(n_min * (1 + tolerance__)));
+    }
+
+    std::array<int, 3> dims;
+    if (comm__.rank() == 0) {
+        /* average execution time of a plan */
+        auto time_plan = [](fftw_plan plan__) {
+            fftw_execute(plan__);
+            int n{0};
+            double t0 = utils::wtime();
+            double t{0};
+            while (n < 3 || t < 1e-3) {
+                fftw_execute(plan__);
+                n++;
+                t = utils::wtime() - t0;
+            }
+            return t / n;
+        };
+
+        /* time of a single z-column transform, measured in a batch of columns */
+        int nb = 16;
+        std::map<int, double> t_z;
+        for (int nz: candidates[2]) {
+            auto buf = (fftw_complex*)fftw_malloc(nz * nb * sizeof(fftw_complex));
+            std::fill((double*)buf, (double*)buf + 2 * nz * nb, 0);
+            int n[] = {nz};
+            auto plan = fftw_plan_many_dft(1, n, nb, buf, NULL, 1, nz, buf, NULL, 1, nz, FFTW_BACKWARD, FFTW_ESTIMATE);
+            t_z[nz] = time_plan(plan) / nb;
+            fftw_destroy_plan(plan);
+            fftw_free(buf);
+        }
+
+        /* approximate number of z-columns of the sphere inscribed in the initial box */
+        double num_zcol = 0.25 * pi * initial_dims__[0] * initial_dims__[1];
+        int num_zcol_loc = static_cast<int>(std::ceil(num_zcol / num_ranks_fft__));
+
+        double t_min{-1};
+        for (int nx: candidates[0]) {
+            for (int ny: candidates[1]) {
+                auto buf = (fftw_complex*)fftw_malloc(nx * ny * sizeof(fftw_complex));
+                std::fill((double*)buf, (double*)buf + 2 * nx * ny, 0);
+                auto plan = fftw_plan_dft_2d(ny, nx, buf, buf, FFTW_BACKWARD, FFTW_ESTIMATE);
+                double t_xy = time_plan(plan);
+                fftw_destroy_plan(plan);
+                fftw_free(buf);
+
+                for (int nz: candidates[2]) {
+                    int nz_loc = splindex_base<int>::block_size(nz, num_ranks_fft__);
+                    double t = ((nz_loc + nt - 1) / nt) * t_xy + ((num_zcol_loc + nt - 1) / nt) * t_z[nz];
+                    if (t_min < 0 || t < t_min) {
+                        t_min = t;
+                        dims = {nx, ny, nz};
+                    }
+                }
+            }
+        }
+    }
+    comm__.bcast(dims.data(), 3, 0);
+
+    cache[key] = dims;
+    return dims;
+}
+
+/// Get FFTW planner flags by the name of the planning mode ("estimate", "measure" or "patient").
+inline unsigned int fftw_plan_flags(std::string const& name__)
+{
+    if (name__ == "estimate") {
+        return FFTW_ESTIMATE;
+    }
+    if (name__ == "measure") {
+        return FFTW_MEASURE;
+    }
+    if (name__ == "patient") {
+        return FFTW_PATIENT;
+    }
+    std::stringstream s;
+    s << "wrong FFTW planning mode: " << name__;
+    TERMINATE(s);
+    return 0; // make compiler happy
+}
+
+/// Import FFTW wisdom from a file.
+/** The file is read by the rank 0 of the communicator and the wisdom is broadcasted to all other ranks. Missing
+ *  file is not an error: nothing is imported and false is returned. */
+inline bool import_fftw_wisdom(std::string const& fname__, Communicator const& comm__)
+{
+    PROFILE("sddk::import_fftw_wisdom");
+
+    std::string wisdom;
+    if (comm__.rank() == 0) {
+        std::ifstream ifs(fname__);
+        if (ifs.is_open()) {
+            std::stringstream ss;
+            ss << ifs.rdbuf();
+            wisdom = ss.str();
+        }
+    }
+    comm__.bcast(wisdom, 0);
+
+    if (wisdom.empty()) {
+        return false;
+    }
+    if (!fftw_import_wisdom_from_string(wisdom.c_str())) {
+        std::stringstream s;
+        s << "failed to import FFTW wisdom from " << fname__;
+        WARNING(s);
+        return false;
+    }
+    return true;
+}
+
+/// Export FFTW wisdom to a file.
+/** Plans of different ranks are different (e.g. the number of local z-columns is not the same), so the wisdom of
+ *  all ranks is collected on rank 0 and merged before it is written to the file. */
+inline void export_fftw_wisdom(std::string const& fname__, Communicator const& comm__)
+{
+    PROFILE("sddk::export_fftw_wisdom");
+
+    for (int r = 1; r < comm__.size(); r++) {
+        if (comm__.rank() == r) {
+            char* w = fftw_export_wisdom_to_string();
+            int sz = static_cast<int>(std::strlen(w)) + 1;
+            comm__.send(&sz, 1, 0, r);
+            comm__.send(w, sz, 0, r);
+            free(w);
+        }
+        if (comm__.rank() == 0) {
+            int sz;
+            comm__.recv(&sz, 1, r, r);
+            std::vector<char> w(sz);
+            comm__.recv(w.data(), sz, r, r);
+            /* wisdom is accumulated */
+            fftw_import_wisdom_from_string(w.data());
+        }
+    }
+    if (comm__.rank() == 0) {
+        char* w = fftw_export_wisdom_to_string();
+        std::ofstream ofs(fname__);
+        if (ofs.is_open()) {
+            ofs << w;
+        } else {
+            std::stringstream s;
+            s << "failed to write FFTW wisdom to " << fname__;
+            WARNING(s);
+        }
+        free(w);
+    }
+}
+
 } // namespace sddk
 
 #endif // __FFT3D_H__
@@ -40,19 +40,10 @@ class FFT3D_grid
     /// Find smallest optimal grid size starting from n.
     int find_grid_size(int n)
     {
-        while (true) {
-            int m = n;
-            for (int k = 2; k <= 5; k++) {
-                while (m % k == 0) {
-                    m /= k;
-                }
-            }
-            if (m == 1) {
-                return n;
-            } else {
-                n++;
-            }
+        while (!is_optimal_size(n)) {
+            n++;
         }
+        return n;
     }
 
     /// Find grid sizes and limits for all three dimensions.
@@ -84,6 +75,31 @@ class FFT3D_grid
 
   public:
 
+    /// Check if the size of the grid dimension has only small (2, 3 and 5) prime factors.
+    static bool is_optimal_size(int n__)
+    {
+        int m = n__;
+        for (int k = 2; k <= 5; k++) {
+            while (m % k == 0) {
+                m /= k;
+            }
+        }
+        return (m == 1);
+    }
+
+    /// Get all optimal grid sizes in the range [n_min, n_max].
+    /** At least one size (the smallest optimal size starting from n_min) is always returned. */
+    static std::vector<int> find_grid_sizes(int n_min__, int n_max__)
+    {
+        std::vector<int> sizes;
+        for (int n = n_min__; n <= n_max__ || sizes.empty(); n++) {
+            if (is_optimal_size(n)) {
+                sizes.push_back(n);
+            }
+        }
+        return sizes;
+    }
+
     /// Create FFT grid with initial dimensions.
     FFT3D_grid(std::array<int, 3> initial_dims__)
     {
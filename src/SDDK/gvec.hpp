@@ -1076,6 +1076,12 @@ class Gvec_partition
         return zcol_count_fft(fft_comm().rank());
     }
 
+    /// Offset of the z-columns of a given rank in the global list of z-columns ordered for the FFT.
+    inline int zcol_offset_fft(int rank__) const
+    {
+        return zcol_distr_fft_.offsets[rank__];
+    }
+
     template <index_domain_t index_domain>
     inline int idx_zcol(int idx__) const
     {
@@ -205,6 +205,10 @@ class linalg<CPU>: public linalg_base
 
         template <typename T>
         static void geqrf(ftn_int m, ftn_int n, dmatrix<T>& A, ftn_int ia, ftn_int ja);
+
+        /// QR factorization of a general matrix; the R factor is returned in the upper triangle of A.
+        template <typename T>
+        static ftn_int geqrf(ftn_int m, ftn_int n, T* A, ftn_int lda);
 };
 
 #ifdef __GPU
@@ -263,6 +267,50 @@ class linalg<GPU>: public linalg_base
 };
 #endif
 
+// C = alpha * op(A) * op(B) + beta * op(C), float
+template<>
+inline void linalg<CPU>::gemm<ftn_single>(int transa, int transb, ftn_int m, ftn_int n, ftn_int k,
+                                          ftn_single alpha,
+                                          ftn_single const* A, ftn_int lda,
+                                          ftn_single const* B, ftn_int ldb,
+                                          ftn_single beta,
+                                          ftn_single* C, ftn_int ldc)
+{
+    assert(lda > 0);
+    assert(ldb > 0);
+    assert(ldc > 0);
+    assert(m > 0);
+    assert(n > 0);
+    assert(k > 0);
+
+    const char *trans[] = {"N", "T", "C"};
+
+    FORTRAN(sgemm)(trans[transa], trans[transb], &m, &n, &k, &alpha, const_cast<ftn_single*>(A), &lda, const_cast<ftn_single*>(B), &ldb, &beta, C, &ldc,
+                   (ftn_len)1, (ftn_len)1);
+}
+
+// C = alpha * op(A) * op(B) + beta * op(C), complex
+template<>
+inline void linalg<CPU>::gemm<ftn_complex>(int transa, int transb, ftn_int m, ftn_int n, ftn_int k,
+                                           ftn_complex alpha,
+                                           ftn_complex const* A, ftn_int lda,
+                                           ftn_complex const* B, ftn_int ldb,
+                                           ftn_complex beta,
+                                           ftn_complex* C, ftn_int ldc)
+{
+    assert(lda > 0);
+    assert(ldb > 0);
+    assert(ldc > 0);
+    assert(m > 0);
+    assert(n > 0);
+    assert(k > 0);
+
+    const char *trans[] = {"N", "T", "C"};
+
+    FORTRAN(cgemm)(trans[transa], trans[transb], &m, &n, &k, &alpha, const_cast<ftn_complex*>(A), &lda, const_cast<ftn_complex*>(B), &ldb, &beta, C, &ldc,
+                   (ftn_len)1, (ftn_len)1);
+}
+
 // C = alpha * op(A) * op(B) + beta * op(C), double
 template<>
 inline void linalg<CPU>::gemm<ftn_double>(int transa, int transb, ftn_int m, ftn_int n, ftn_int k,
@@ -615,6 +663,34 @@ inline ftn_int linalg<CPU>::trtri<ftn_double_complex>(ftn_int n, ftn_double_comp
     return info;
 }
 
+template <>
+inline ftn_int linalg<CPU>::geqrf<ftn_double>(ftn_int m, ftn_int n, ftn_double* A, ftn_int lda)
+{
+    ftn_int lwork = -1;
+    ftn_double z;
+    ftn_int info;
+    FORTRAN(dgeqrf)(&m, &n, A, &lda, &z, &z, &lwork, &info);
+    lwork = static_cast<int>(z + 1);
+    std::vector<ftn_double> work(lwork);
+    std::vector<ftn_double> tau(std::max(m, n));
+    FORTRAN(dgeqrf)(&m, &n, A, &lda, tau.data(), work.data(), &lwork, &info);
+    return info;
+}
+
+template <>
+inline ftn_int linalg<CPU>::geqrf<ftn_double_complex>(ftn_int m, ftn_int n, ftn_double_complex* A, ftn_int lda)
+{
+    ftn_int lwork = -1;
+    ftn_double_complex z;
+    ftn_int info;
+    FORTRAN(zgeqrf)(&m, &n, A, &lda, &z, &z, &lwork, &info);
+    lwork = static_cast<int>(z.real() + 1);
+    std::vector<ftn_double_complex> work(lwork);
+    std::vector<ftn_double_complex> tau(std::max(m, n));
+    FORTRAN(zgeqrf)(&m, &n, A, &lda, tau.data(), work.data(), &lwork, &info);
+    return info;
+}
+
 template <>
 inline void linalg<CPU>::trmm<ftn_double>(char side, char uplo, char transa, ftn_int m, ftn_int n, ftn_double alpha,
                                           ftn_double* A, ftn_int lda, ftn_double* B, ftn_int ldb)
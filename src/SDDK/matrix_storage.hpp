@@ -81,6 +81,170 @@ class matrix_storage<T, matrix_storage_t::slab>
     /// Column distribution in auxiliary matrix.
     splindex<block> spl_num_col_;
 
+    /// Description of a single all-to-all exchange between prime and extra storage.
+    /** The position of the data of each rank is encoded in its datatype with the MPI_Aint byte displacement, so the
+     *  (int) counts are either 0 or 1 and the (int) displacements of the all-to-all call are always zero. This keeps
+     *  the exchange valid for prime and extra storages larger than 2 GiB. */
+    struct remap_chunk
+    {
+        /// First local column of the extra storage covered by the exchange.
+        int col0{0};
+        /// Number of local columns of the extra storage covered by the exchange.
+        int ncol{0};
+        /// Send (forward) or receive (backward) counts of the prime storage.
+        std::vector<int> prime_counts;
+        /// Receive (forward) or send (backward) counts of the extra storage.
+        std::vector<int> extra_counts;
+        /// Zero displacements.
+        std::vector<int> displs;
+        /// Columns of the prime storage exchanged with each rank, relative to the first remapped column.
+        std::vector<MPI_Datatype> prime_types;
+        /// Rows of the extra storage exchanged with each rank, relative to the first column of the extra storage.
+        std::vector<MPI_Datatype> extra_types;
+    };
+
+    /// Cached remapping plan.
+    /** G-vector partitioning is fixed for the lifetime of the storage and the starting column only shifts the base
+     *  pointer, so the plan depends solely on the number of remapped columns. */
+    struct remap_plan
+    {
+        /// Number of remapped columns for which the plan was built.
+        int n{-1};
+        /// List of exchanges.
+        std::vector<remap_chunk> chunks;
+    };
+
+    /// Plan for the blocking remapping (single exchange).
+    remap_plan remap_plan_;
+
+    /// Plan for the non-blocking forward remapping (exchange is split in several column chunks).
+    remap_plan remap_plan_async_;
+
+    /// Number of column chunks of the non-blocking forward remapping.
+    static const int remap_num_chunks_{4};
+
+    /// Column datatype of the prime storage.
+    MPI_Datatype prime_col_type_{MPI_DATATYPE_NULL};
+
+    /// Strided column datatypes of the extra storage for each rank of the column communicator.
+    /** The datatype for rank j is a contiguous block of the rows stored by rank j with the extent equal to the
+     *  leading dimension of the extra storage. This places the received rows directly at their final position. */
+    std::vector<MPI_Datatype> extra_types_;
+
+    /// Pending requests of the non-blocking forward remapping.
+    std::vector<Request> remap_requests_;
+
+    /// Number of completed chunks of the non-blocking forward remapping.
+    int remap_num_done_{0};
+
+    /// Create MPI datatypes used by the remapping.
+    inline void create_remap_types()
+    {
+        if (extra_types_.size()) {
+            return;
+        }
+        auto& comm_col  = gvp_->comm_ortho_fft();
+        auto& row_distr = gvp_->gvec_fft_slab();
+
+        CALL_MPI(MPI_Type_contiguous, (num_rows_loc_, mpi_type_wrapper<T>::kind(), &prime_col_type_));
+        CALL_MPI(MPI_Type_commit, (&prime_col_type_));
+
+        extra_types_ = std::vector<MPI_Datatype>(comm_col.size());
+
+        MPI_Aint extent = static_cast<MPI_Aint>(gvp_->gvec_count_fft()) * sizeof(T);
+        for (int j = 0; j < comm_col.size(); j++) {
+            MPI_Datatype t;
+            CALL_MPI(MPI_Type_contiguous, (row_distr.counts[j], mpi_type_wrapper<T>::kind(), &t));
+            CALL_MPI(MPI_Type_create_resized, (t, 0, extent, &extra_types_[j]));
+            CALL_MPI(MPI_Type_commit, (&extra_types_[j]));
+            CALL_MPI(MPI_Type_free, (&t));
+        }
+    }
+
+    /// Create a datatype of n consecutive elements of a given type starting at a byte offset.
+    static MPI_Datatype create_block_type(int n__, MPI_Aint offset__, MPI_Datatype type__)
+    {
+        MPI_Datatype t;
+        CALL_MPI(MPI_Type_create_hindexed_block, (1, n__, &offset__, type__, &t));
+        CALL_MPI(MPI_Type_commit, (&t));
+        return t;
+    }
+
+    /// Free the datatypes of the remapping plan.
+    static void free_remap_plan(remap_plan& plan__)
+    {
+        for (auto& c: plan__.chunks) {
+            for (auto& t: c.prime_types) {
+                MPI_Type_free(&t);
+            }
+            for (auto& t: c.extra_types) {
+                MPI_Type_free(&t);
+            }
+        }
+        plan__.chunks.clear();
+        plan__.n = -1;
+    }
+
+    /// Get the remapping plan for n columns split in a given number of chunks.
+    inline remap_plan const& get_remap_plan(remap_plan& plan__, int n__, int num_chunks__)
+    {
+        if (plan__.n == n__) {
+            return plan__;
+        }
+        free_remap_plan(plan__);
+
+        auto& comm_col  = gvp_->comm_ortho_fft();
+        auto& row_distr = gvp_->gvec_fft_slab();
+
+        splindex<block> spl_col(n__, comm_col.size(), comm_col.rank());
+
+        /* all ranks must post the same number of exchanges, so the chunks are defined by the largest local size */
+        int max_ncol = splindex_base<int>::block_size(n__, comm_col.size());
+        int width    = std::max(1, (max_ncol + num_chunks__ - 1) / num_chunks__);
+        int nchunk   = (max_ncol + width - 1) / width;
+
+        /* leading dimension of the extra storage */
+        MPI_Aint ld = gvp_->gvec_count_fft();
+
+        plan__.n = n__;
+        plan__.chunks.resize(nchunk);
+        for (int c = 0; c < nchunk; c++) {
+            auto& chunk = plan__.chunks[c];
+            chunk.col0  = c * width;
+            chunk.ncol  = std::max(0, std::min(width, spl_col.local_size() - chunk.col0));
+            chunk.prime_counts.resize(comm_col.size());
+            chunk.extra_counts.resize(comm_col.size());
+            chunk.displs = std::vector<int>(comm_col.size(), 0);
+            chunk.prime_types.resize(comm_col.size());
+            chunk.extra_types.resize(comm_col.size());
+            for (int j = 0; j < comm_col.size(); j++) {
+                int ncol_j = std::max(0, std::min(width, spl_col.local_size(j) - chunk.col0));
+                /* offset of the first column sent to (received from) rank j in the prime storage */
+                MPI_Aint prime_offs = static_cast<MPI_Aint>(spl_col.global_offset(j) + chunk.col0) * num_rows_loc_;
+                /* offset of the first row received from (sent to) rank j in the extra storage */
+                MPI_Aint extra_offs = static_cast<MPI_Aint>(chunk.col0) * ld + row_distr.offsets[j];
+
+                chunk.prime_counts[j] = (ncol_j * num_rows_loc_ > 0) ? 1 : 0;
+                chunk.prime_types[j]  = create_block_type(ncol_j, prime_offs * sizeof(T), prime_col_type_);
+                chunk.extra_counts[j] = (chunk.ncol * row_distr.counts[j] > 0) ? 1 : 0;
+                chunk.extra_types[j]  = create_block_type(chunk.ncol, extra_offs * sizeof(T), extra_types_[j]);
+            }
+        }
+        return plan__;
+    }
+
+    /// Pointer to the first remapped column of the prime storage.
+    inline T* prime_remap_ptr(int idx0__)
+    {
+        return (num_rows_loc_ == 0) ? nullptr : prime_.template at<CPU>(0, idx0__);
+    }
+
+    /// Pointer to the first column of the extra storage.
+    inline T* extra_remap_ptr()
+    {
+        return (extra_.size() == 0) ? nullptr : extra_.template at<CPU>();
+    }
+
   public:
     /// Constructor.
     matrix_storage(Gvec_partition const& gvp__, int num_cols__)
@@ -113,6 +277,27 @@ class matrix_storage<T, matrix_storage_t::slab>
         prime_ = mdarray<T, 2>(ptr__, num_rows_loc_, num_cols_, "matrix_storage.prime_");
     }
 
+    /* the storage owns MPI datatypes and can't be copied */
+    matrix_storage(matrix_storage const& src__) = delete;
+
+    matrix_storage& operator=(matrix_storage const& src__) = delete;
+
+    ~matrix_storage()
+    {
+        int finalized{0};
+        MPI_Finalized(&finalized);
+        if (!finalized) {
+            free_remap_plan(remap_plan_);
+            free_remap_plan(remap_plan_async_);
+            for (auto& t: extra_types_) {
+                MPI_Type_free(&t);
+            }
+            if (prime_col_type_ != MPI_DATATYPE_NULL) {
+                MPI_Type_free(&prime_col_type_);
+            }
+        }
+    }
+
     /// Check if data needs to be remapped. This happens when comm_col is not trivial communicator.
     inline bool is_remapped() const
     {
@@ -161,7 +346,6 @@ class matrix_storage<T, matrix_storage_t::slab>
             size_t sz = gvp_->gvec_count_fft() * ncol;
             /* reallocate buffers if necessary */
             if (extra_buf_.size() < sz) {
-                send_recv_buf_ = mdarray<T, 1>(sz, memory_t::host, "matrix_storage.send_recv_buf_");
                 memory_t mem_type = memory_t::none;
                 switch (pu__) {
                     case CPU: {
@@ -185,12 +369,12 @@ class matrix_storage<T, matrix_storage_t::slab>
     
     /// Remap data from prime to extra storage.
     /** \param [in] pu        Target processing unit.
-     *  \param [in] row_distr Distribution of rows of prime matrix in the extra matrix storage. 
      *  \param [in] n         Number of matrix columns to distribute.
      *  \param [in] idx0      Starting column of the matrix.
      *
      *  Prime storage is expected on the CPU (for the MPI a2a communication). If the target processing unit is GPU
-     *  extra storage will be copied to the device memory. */
+     *  extra storage will be copied to the device memory. The received rows are placed directly at their final
+     *  position in the extra storage by the strided MPI datatypes, so no intermediate buffer is used. */
     inline void remap_forward(device_t                     pu__,
                               int                          n__,
                               int                          idx0__ = 0)
@@ -204,47 +388,83 @@ class matrix_storage<T, matrix_storage_t::slab>
             return;
         }
 
-        auto& row_distr = gvp_->gvec_fft_slab();
+        create_remap_types();
+        auto& plan = get_remap_plan(remap_plan_, n__, 1);
 
         auto& comm_col = gvp_->comm_ortho_fft();
 
-        /* local number of columns */
-        int n_loc = spl_num_col_.local_size();
+        for (auto& c: plan.chunks) {
+            comm_col.alltoall(prime_remap_ptr(idx0__), c.prime_counts.data(), c.displs.data(),
+                              c.prime_types.data(), extra_remap_ptr(), c.extra_counts.data(), c.displs.data(),
+                              c.extra_types.data());
+        }
 
-        /* send and recieve dimensions */
-        block_data_descriptor sd(comm_col.size()), rd(comm_col.size());
-        for (int j = 0; j < comm_col.size(); j++) {
-            sd.counts[j] = spl_num_col_.local_size(j) * row_distr.counts[comm_col.rank()];
-            rd.counts[j] = spl_num_col_.local_size(comm_col.rank()) * row_distr.counts[j];
+        /*  copy extra storage to the device if needed */
+        if (pu__ == GPU && extra_.on_device()) {
+            extra_.template copy<memory_t::host, memory_t::device>();
         }
-        sd.calc_offsets();
-        rd.calc_offsets();
+    }
 
-        T* send_buf = (num_rows_loc_ == 0) ? nullptr : prime_.template at<CPU>(0, idx0__);
+    /// Start non-blocking remapping of data from prime to extra storage.
+    /** \param [in] n         Number of matrix columns to distribute.
+     *  \param [in] idx0      Starting column of the matrix.
+     *
+     *  Only the CPU extra storage is used. The columns are sent in several chunks; use remap_forward_wait() to
+     *  wait for a particular local column and remap_forward_end() to complete the remapping. Prime storage must
+     *  not be modified until the remapping is completed. */
+    inline void remap_forward_begin(int n__, int idx0__ = 0)
+    {
+        PROFILE("sddk::matrix_storage::remap_forward_begin");
 
-        comm_col.alltoall(send_buf, sd.counts.data(), sd.offsets.data(), send_recv_buf_.template at<CPU>(),
-                          rd.counts.data(), rd.offsets.data());
+        set_num_extra(CPU, n__, idx0__);
 
-        /* reorder recieved blocks */
-        #pragma omp parallel for
-        for (int i = 0; i < n_loc; i++) {
-            for (int j = 0; j < comm_col.size(); j++) {
-                int offset = row_distr.offsets[j];
-                int count  = row_distr.counts[j];
-                if (count) {
-                    std::memcpy(&extra_(offset, i), &send_recv_buf_[offset * n_loc + count * i], count * sizeof(T));
-                }
+        remap_requests_.clear();
+        remap_num_done_ = 0;
+
+        if (!is_remapped()) {
+            return;
+        }
+
+        create_remap_types();
+        auto& plan = get_remap_plan(remap_plan_async_, n__, remap_num_chunks_);
+
+        auto& comm_col = gvp_->comm_ortho_fft();
+
+        for (auto& c: plan.chunks) {
+            remap_requests_.push_back(comm_col.ialltoall(prime_remap_ptr(idx0__), c.prime_counts.data(),
+                                                         c.displs.data(), c.prime_types.data(), extra_remap_ptr(),
+                                                         c.extra_counts.data(), c.displs.data(),
+                                                         c.extra_types.data()));
+        }
+    }
+
+    /// Wait until the local column of the extra storage is received.
+    inline void remap_forward_wait(int i__)
+    {
+        while (remap_num_done_ < static_cast<int>(remap_requests_.size())) {
+            auto& c = remap_plan_async_.chunks[remap_num_done_];
+            if (i__ < c.col0) {
+                break;
             }
+            PROFILE("sddk::matrix_storage::remap_forward_wait");
+            remap_requests_[remap_num_done_++].wait();
         }
-        /*  copy extra storage to the device if needed */
-        if (pu__ == GPU && extra_.on_device()) {
-            extra_.template copy<memory_t::host, memory_t::device>();
+    }
+
+    /// Complete non-blocking remapping of data from prime to extra storage.
+    inline void remap_forward_end()
+    {
+        PROFILE("sddk::matrix_storage::remap_forward_end");
+
+        while (remap_num_done_ < static_cast<int>(remap_requests_.size())) {
+            remap_requests_[remap_num_done_++].wait();
         }
+        remap_requests_.clear();
+        remap_num_done_ = 0;
     }
 
     /// Remap data from extra to prime storage.
     /** \param [in] pu        Target processing unit.
-     *  \param [in] row_distr Distribution of rows of prime matrix in the extra matrix storage. 
      *  \param [in] n         Number of matrix columns to collect.
      *  \param [in] idx0      Starting column of the matrix.
      *
@@ -261,40 +481,18 @@ class matrix_storage<T, matrix_storage_t::slab>
             return;
         }
 
-        auto& comm_col = gvp_->comm_ortho_fft();
-
-        auto& row_distr = gvp_->gvec_fft_slab();
-        
         assert(n__ == spl_num_col_.global_index_size());
 
-        /* local number of columns */
-        int n_loc = spl_num_col_.local_size();
+        create_remap_types();
+        auto& plan = get_remap_plan(remap_plan_, n__, 1);
 
-        /* reorder sending blocks */
-        #pragma omp parallel for
-        for (int i = 0; i < n_loc; i++) {
-            for (int j = 0; j < comm_col.size(); j++) {
-                int offset = row_distr.offsets[j];
-                int count  = row_distr.counts[j];
-                if (count) {
-                    std::memcpy(&send_recv_buf_[offset * n_loc + count * i], &extra_(offset, i), count * sizeof(T));
-                }
-            }
-        }
+        auto& comm_col = gvp_->comm_ortho_fft();
 
-        /* send and recieve dimensions */
-        block_data_descriptor sd(comm_col.size()), rd(comm_col.size());
-        for (int j = 0; j < comm_col.size(); j++) {
-            sd.counts[j] = spl_num_col_.local_size(comm_col.rank()) * row_distr.counts[j];
-            rd.counts[j] = spl_num_col_.local_size(j) * row_distr.counts[comm_col.rank()];
+        for (auto& c: plan.chunks) {
+            comm_col.alltoall(extra_remap_ptr(), c.extra_counts.data(), c.displs.data(), c.extra_types.data(),
+                              prime_remap_ptr(idx0__), c.prime_counts.data(), c.displs.data(),
+                              c.prime_types.data());
         }
-        sd.calc_offsets();
-        rd.calc_offsets();
-
-        T* recv_buf = (num_rows_loc_ == 0) ? nullptr : prime_.template at<CPU>(0, idx0__);
-
-        comm_col.alltoall(send_recv_buf_.template at<CPU>(), sd.counts.data(), sd.offsets.data(), recv_buf,
-                           rd.counts.data(), rd.offsets.data());
 
         /* move data back to device */
         if (pu__ == GPU && prime_.on_device()) {
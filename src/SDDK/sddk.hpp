@@ -62,5 +62,6 @@ namespace sddk {
 #include "gvec.hpp"
 #include "fft3d.hpp"
 #include "wave_functions.hpp"
+#include "wave_functions_store.hpp"
 
 #endif
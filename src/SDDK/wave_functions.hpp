@@ -88,11 +88,21 @@ class Wave_functions
     /// Plane-wave part of wave-functions.
     std::array<std::unique_ptr<matrix_storage<double_complex, matrix_storage_t::slab>>, 2> pw_coeffs_{{nullptr, nullptr}};
 
+    /// Plane-wave part of wave-functions stored in single precision.
+    /** Only one of pw_coeffs_ and pw_coeffs_fp32_ is allocated. */
+    std::array<std::unique_ptr<matrix_storage<std::complex<float>, matrix_storage_t::slab>>, 2> pw_coeffs_fp32_{{nullptr, nullptr}};
+
     /// Muffin-tin part of wave-functions.
     std::array<std::unique_ptr<matrix_storage<double_complex, matrix_storage_t::slab>>, 2> mt_coeffs_{{nullptr, nullptr}};
 
     bool has_mt_{false};
 
+    /// True if the plane-wave coefficients are stored in single precision.
+    bool fp32_{false};
+
+    /// Buffer for the single precision panels of gemm_fp32().
+    mdarray<std::complex<float>, 1> fp32_buf_;
+
     /// Lower boundary for the spin component index by spin index.
     inline int s0(int ispn__) const
     {
@@ -126,6 +136,9 @@ class Wave_functions
 
     inline mdarray<double, 1> sumsqr(device_t pu__, int ispn__, int n__) const
     {
+        if (fp32_) {
+            TERMINATE("norm of single precision wave-functions is not implemented");
+        }
         mdarray<double, 1> s(n__, memory_t::host, "sumsqr");
         s.zero();
         if (pu__ == GPU) {
@@ -217,6 +230,31 @@ class Wave_functions
         }
     }
 
+    /// Constructor for PW wave-functions with the coefficients stored in single precision.
+    /** Such wave-functions are used as the auxiliary basis of the mixed precision iterative solver. They can be
+     *  copied to and from the double precision wave-functions, and they can take part in inner(), transform() and
+     *  orthogonalize() on the CPU. */
+    Wave_functions(std::complex<float>*  ptr__,
+                   Gvec_partition const& gkvecp__,
+                   int                   num_wf__,
+                   int                   num_sc__ = 1)
+        : comm_(gkvecp__.gvec().comm())
+        , gkvecp_(gkvecp__)
+        , num_wf_(num_wf__)
+        , num_sc_(num_sc__)
+        , fp32_(true)
+    {
+        if (!(num_sc__ == 1 || num_sc__ == 2)) {
+            TERMINATE("wrong number of spin components");
+        }
+
+        for (int ispn = 0; ispn < num_sc_; ispn++) {
+            pw_coeffs_fp32_[ispn] = std::unique_ptr<matrix_storage<std::complex<float>, matrix_storage_t::slab>>(
+                new matrix_storage<std::complex<float>, matrix_storage_t::slab>(ptr__, gkvecp_, num_wf_));
+            ptr__ += gkvecp_.gvec().count() * num_wf_;
+        }
+    }
+
     /// Constructor for LAPW wave-functions.
     Wave_functions(Gvec_partition const&   gkvecp__,
                    int                     num_atoms__,
@@ -282,14 +320,35 @@ class Wave_functions
 
     inline matrix_storage<double_complex, matrix_storage_t::slab>& pw_coeffs(int ispn__)
     {
+        assert(!fp32_);
         return *pw_coeffs_[isc(ispn__)];
     }
 
     inline matrix_storage<double_complex, matrix_storage_t::slab> const& pw_coeffs(int ispn__) const
     {
+        assert(!fp32_);
         return *pw_coeffs_[isc(ispn__)];
     }
 
+    /// Plane-wave coefficients stored in single precision.
+    inline matrix_storage<std::complex<float>, matrix_storage_t::slab>& pw_coeffs_fp32(int ispn__)
+    {
+        assert(fp32_);
+        return *pw_coeffs_fp32_[isc(ispn__)];
+    }
+
+    inline matrix_storage<std::complex<float>, matrix_storage_t::slab> const& pw_coeffs_fp32(int ispn__) const
+    {
+        assert(fp32_);
+        return *pw_coeffs_fp32_[isc(ispn__)];
+    }
+
+    /// Local number of plane-wave coefficients.
+    inline int num_pw_rows_loc() const
+    {
+        return gkvecp_.gvec().count();
+    }
+
     inline matrix_storage<double_complex, matrix_storage_t::slab>& mt_coeffs(int ispn__)
     {
         return *mt_coeffs_[isc(ispn__)];
@@ -305,6 +364,18 @@ class Wave_functions
         return has_mt_ && (mt_coeffs_distr_.counts[comm_.rank()] > 0);
     }
 
+    /// True if the plane-wave coefficients are stored in single precision.
+    inline bool fp32() const
+    {
+        return fp32_;
+    }
+
+    /// Buffer for the single precision panels of gemm_fp32().
+    inline mdarray<std::complex<float>, 1>& fp32_buffer()
+    {
+        return fp32_buf_;
+    }
+
     inline int num_wf() const
     {
         return num_wf_;
@@ -344,9 +415,30 @@ class Wave_functions
         assert(ispn__ == 0 || ispn__ == 1);
         assert(jspn__ == 0 || jspn__ == 1);
 
-        int ngv =  pw_coeffs(jspn__).num_rows_loc();
+        int ngv = num_pw_rows_loc();
         int nmt = has_mt() ? mt_coeffs(jspn__).num_rows_loc() : 0;
 
+        if (fp32_ || src__.fp32()) {
+            if (pu__ != CPU || has_mt()) {
+                TERMINATE("single precision wave-functions are implemented for plane-wave coefficients on CPU");
+            }
+            /* copy PW part with the conversion of precision */
+            if (fp32_ && src__.fp32()) {
+                std::copy(src__.pw_coeffs_fp32(ispn__).prime().at<CPU>(0, i0__),
+                          src__.pw_coeffs_fp32(ispn__).prime().at<CPU>(0, i0__) + ngv * n__,
+                          pw_coeffs_fp32(jspn__).prime().at<CPU>(0, j0__));
+            } else if (fp32_) {
+                std::copy(src__.pw_coeffs(ispn__).prime().at<CPU>(0, i0__),
+                          src__.pw_coeffs(ispn__).prime().at<CPU>(0, i0__) + ngv * n__,
+                          pw_coeffs_fp32(jspn__).prime().at<CPU>(0, j0__));
+            } else {
+                std::copy(src__.pw_coeffs_fp32(ispn__).prime().at<CPU>(0, i0__),
+                          src__.pw_coeffs_fp32(ispn__).prime().at<CPU>(0, i0__) + ngv * n__,
+                          pw_coeffs(jspn__).prime().at<CPU>(0, j0__));
+            }
+            return;
+        }
+
         switch (pu__) {
             case CPU: {
                 /* copy PW part */
@@ -390,7 +482,15 @@ class Wave_functions
         assert(n__ != 0);
         double_complex cs(0, 0);
         for (int s = s0(ispn__); s <= s1(ispn__); s++) {
-            cs += pw_coeffs(s).checksum(pu__, i0__, n__);
+            if (fp32_) {
+                for (int i = 0; i < n__; i++) {
+                    for (int ig = 0; ig < num_pw_rows_loc(); ig++) {
+                        cs += pw_coeffs_fp32(s).prime(ig, i0__ + i);
+                    }
+                }
+            } else {
+                cs += pw_coeffs(s).checksum(pu__, i0__, n__);
+            }
         }
         comm_.allreduce(&cs, 1);
         return cs;
@@ -419,6 +519,10 @@ class Wave_functions
     inline void zero_pw(device_t pu__, int ispn__, int i0__, int n__)
     {
         for (int s = s0(ispn__); s <= s1(ispn__); s++) {
+            if (fp32_) {
+                pw_coeffs_fp32(s).zero<memory_t::host>(i0__, n__);
+                continue;
+            }
             switch (pu__) {
                 case CPU: {
                     pw_coeffs(s).zero<memory_t::host>(i0__, n__);
@@ -460,6 +564,10 @@ class Wave_functions
     inline void scale(device_t pu__, int ispn__, int i0__, int n__, double beta__)
     {
         for (int s = s0(ispn__); s <= s1(ispn__); s++) {
+            if (fp32_) {
+                pw_coeffs_fp32(s).scale<memory_t::host>(i0__, n__, beta__);
+                continue;
+            }
             switch (pu__) {
                 case CPU: {
                     pw_coeffs(s).scale<memory_t::host>(i0__, n__, beta__);
@@ -642,6 +750,7 @@ class Wave_functions
     }
 };
 
+#include "wf_fp32.hpp"
 #include "wf_inner.hpp"
 #include "wf_trans.hpp"
 #include "wf_ortho.hpp"
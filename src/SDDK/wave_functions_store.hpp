@@ -0,0 +1,299 @@
+// Copyright (c) 2013-2018 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file wave_functions_store.hpp
+ *
+ *  \brief Contains declaration and implementation of sddk::Wave_functions_store class.
+ */
+
+#ifndef __WAVE_FUNCTIONS_STORE_HPP__
+#define __WAVE_FUNCTIONS_STORE_HPP__
+
+#include <future>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "wave_functions.hpp"
+
+namespace sddk {
+
+/// Out-of-core backing store for wave-functions.
+/** Wave-functions registered in the store can be paged out to a local scratch file and paged back in when they
+ *  are needed. Only the host memory of the prime storage (plane-wave and muffin-tin parts) is released; the
+ *  wave-functions must not be accessed while they are paged out. Both directions of the transfer are executed
+ *  asynchronously with pwrite() / pread() in a background thread, so that the next set of wave-functions can be
+ *  prefetched while the current one is being processed.
+ *
+ *  Wave-functions are paged in either for reading or for modification. Only modified wave-functions are written
+ *  back to the scratch file when they are paged out; for the read-only access the host memory is simply released.
+ *  The number of resident wave-functions is limited: when the limit is reached, the least recently used
+ *  wave-functions are paged out before new ones are read.
+ *
+ *  The scratch file is created with a unique name in the given directory and is unlinked immediately, so it is
+ *  removed by the operating system when the store is destroyed or the program terminates. */
+class Wave_functions_store
+{
+  private:
+    /// State of a single set of wave-functions.
+    struct entry
+    {
+        /// Wave-functions kept in the store.
+        Wave_functions* wf{nullptr};
+        /// Offset in the scratch file.
+        off_t offset{0};
+        /// True if the wave-functions are in memory (or are being read back).
+        bool resident{true};
+        /// True if the wave-functions in memory differ from the copy in the scratch file.
+        bool dirty{true};
+        /// Time of the last access (used to find the least recently used entry).
+        size_t last_access{0};
+        /// Pending read or write operation.
+        std::future<void> io;
+    };
+
+    /// File descriptor of the scratch file.
+    int fd_{-1};
+
+    /// Total size of the scratch file in bytes.
+    off_t size_{0};
+
+    /// List of registered wave-functions.
+    std::vector<entry> entries_;
+
+    /// Maximum number of resident wave-functions.
+    int max_resident_{2};
+
+    /// Access counter.
+    size_t access_count_{0};
+
+    Wave_functions_store(Wave_functions_store const& src__) = delete;
+
+    Wave_functions_store& operator=(Wave_functions_store const& src__) = delete;
+
+    /// Get the list of host arrays of the prime storage.
+    static std::vector<mdarray<double_complex, 2>*> arrays(Wave_functions& wf__)
+    {
+        std::vector<mdarray<double_complex, 2>*> a;
+        for (int is = 0; is < wf__.num_sc(); is++) {
+            a.push_back(&wf__.pw_coeffs(is).prime());
+            if (wf__.has_mt()) {
+                a.push_back(&wf__.mt_coeffs(is).prime());
+            }
+        }
+        return a;
+    }
+
+    /// Write the arrays to the scratch file and release their host memory.
+    static void write(int fd__, off_t offset__, std::vector<mdarray<double_complex, 2>*> arrays__)
+    {
+        for (auto a: arrays__) {
+            size_t sz = a->size() * sizeof(double_complex);
+            if (!sz) {
+                continue;
+            }
+            char const* ptr = reinterpret_cast<char const*>(a->at<CPU>());
+            for (size_t done = 0; done < sz;) {
+                ssize_t n = pwrite(fd__, ptr + done, sz - done, offset__ + done);
+                if (n < 0 && errno != EINTR) {
+                    std::stringstream s;
+                    s << "error writing wave-functions to the scratch file: " << std::strerror(errno);
+                    TERMINATE(s);
+                }
+                done += std::max(ssize_t(0), n);
+            }
+            offset__ += sz;
+            a->deallocate(memory_t::host);
+        }
+    }
+
+    /// Read the arrays from the scratch file.
+    static void read(int fd__, off_t offset__, std::vector<mdarray<double_complex, 2>*> arrays__)
+    {
+        for (auto a: arrays__) {
+            size_t sz = a->size() * sizeof(double_complex);
+            if (!sz) {
+                continue;
+            }
+            char* ptr = reinterpret_cast<char*>(a->at<CPU>());
+            for (size_t done = 0; done < sz;) {
+                ssize_t n = pread(fd__, ptr + done, sz - done, offset__ + done);
+                if (n == 0 || (n < 0 && errno != EINTR)) {
+                    std::stringstream s;
+                    s << "error reading wave-functions from the scratch file: " << (n ? std::strerror(errno) : "EOF");
+                    TERMINATE(s);
+                }
+                done += std::max(ssize_t(0), n);
+            }
+            offset__ += sz;
+        }
+    }
+
+    /// Wait for the pending operation.
+    inline void wait(entry& e__)
+    {
+        if (e__.io.valid()) {
+            PROFILE("sddk::Wave_functions_store::wait");
+            e__.io.get();
+        }
+    }
+
+    /// Page out the least recently used wave-functions if the limit of resident wave-functions is reached.
+    inline void evict(int idx__)
+    {
+        int n{0};
+        int lru{-1};
+        for (int i = 0; i < static_cast<int>(entries_.size()); i++) {
+            if (entries_[i].resident && i != idx__) {
+                n++;
+                if (lru < 0 || entries_[i].last_access < entries_[lru].last_access) {
+                    lru = i;
+                }
+            }
+        }
+        if (n >= max_resident_) {
+            page_out(lru);
+        }
+    }
+
+  public:
+    /// Constructor.
+    /** \param [in] path         Directory for the scratch file (should be on a fast local disk).
+     *  \param [in] max_resident Maximum number of wave-functions which are kept in memory at the same time. */
+    Wave_functions_store(std::string const& path__, int max_resident__ = 2)
+        : max_resident_(std::max(1, max_resident__))
+    {
+        std::string name = path__ + "/sirius_wf_XXXXXX";
+        std::vector<char> tmpl(name.begin(), name.end());
+        tmpl.push_back('\0');
+        fd_ = mkstemp(tmpl.data());
+        if (fd_ < 0) {
+            std::stringstream s;
+            s << "can't create scratch file " << name << " : " << std::strerror(errno);
+            TERMINATE(s);
+        }
+        unlink(tmpl.data());
+    }
+
+    ~Wave_functions_store()
+    {
+        for (auto& e: entries_) {
+            if (e.io.valid()) {
+                e.io.wait();
+            }
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    /// Register wave-functions in the store and reserve space in the scratch file.
+    /** Wave-functions must own their host memory. Returns the index of the entry. */
+    inline int add(Wave_functions& wf__)
+    {
+        entry e;
+        e.wf     = &wf__;
+        e.offset = size_;
+        for (auto a: arrays(wf__)) {
+            size_ += a->size() * sizeof(double_complex);
+        }
+        entries_.push_back(std::move(e));
+        return static_cast<int>(entries_.size()) - 1;
+    }
+
+    /// Release the host memory of wave-functions; modified wave-functions are written to the scratch file first.
+    /** The write is done in the background and the memory is released when it is completed. */
+    inline void page_out(int idx__)
+    {
+        PROFILE("sddk::Wave_functions_store::page_out");
+
+        auto& e = entries_[idx__];
+        wait(e);
+        if (!e.resident) {
+            return;
+        }
+        e.resident = false;
+        if (e.dirty) {
+            e.dirty = false;
+            e.io = std::async(std::launch::async, write, fd_, e.offset, arrays(*e.wf));
+        } else {
+            for (auto a: arrays(*e.wf)) {
+                a->deallocate(memory_t::host);
+            }
+        }
+    }
+
+    /// Start reading wave-functions from the scratch file.
+    /** Host memory is allocated here, the data is valid after a call to wait() or page_in(). If modify is true,
+     *  the wave-functions are written back to the scratch file when they are paged out. Wave-functions which are
+     *  paged in only for reading must not be changed. */
+    inline void prefetch(int idx__, bool modify__)
+    {
+        auto& e = entries_[idx__];
+        e.last_access = ++access_count_;
+        if (modify__) {
+            e.dirty = true;
+        }
+        if (e.resident) {
+            return;
+        }
+
+        PROFILE("sddk::Wave_functions_store::prefetch");
+
+        evict(idx__);
+
+        /* wait for the write to complete before the memory is allocated again */
+        wait(e);
+        auto a = arrays(*e.wf);
+        for (auto x: a) {
+            x->allocate(memory_t::host);
+        }
+        e.resident = true;
+        e.io = std::async(std::launch::async, read, fd_, e.offset, a);
+    }
+
+    /// Make sure that the wave-functions are in memory.
+    inline void page_in(int idx__, bool modify__)
+    {
+        prefetch(idx__, modify__);
+        wait(entries_[idx__]);
+    }
+
+    /// Return true if the wave-functions are in memory or are being read back.
+    inline bool is_resident(int idx__) const
+    {
+        return entries_[idx__].resident;
+    }
+
+    /// Return true if the wave-functions must be written to the scratch file when they are paged out.
+    inline bool is_dirty(int idx__) const
+    {
+        return entries_[idx__].dirty;
+    }
+
+    /// Total size of the scratch file in bytes.
+    inline size_t size() const
+    {
+        return static_cast<size_t>(size_);
+    }
+};
+
+} // namespace sddk
+
+#endif // __WAVE_FUNCTIONS_STORE_HPP__
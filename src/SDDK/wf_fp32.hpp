@@ -0,0 +1,204 @@
+// Copyright (c) 2013-2018 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file wf_fp32.hpp
+ *
+ *  \brief Single precision GEMM for the wave-function panels.
+ */
+
+/// Single precision counterpart of the double precision type.
+template <typename T>
+struct fp32_type;
+
+template <>
+struct fp32_type<double>
+{
+    using type = float;
+};
+
+template <>
+struct fp32_type<double_complex>
+{
+    using type = std::complex<float>;
+};
+
+/// Column-major block of a matrix in the CPU memory, stored either in double or in single precision.
+/** For the real wave-functions (T = double) the complex coefficients are treated as real numbers, so the number
+ *  of rows and the leading dimension are doubled. */
+struct gemm_panel
+{
+    /// Pointer to the first element: T* for double and fp32_type<T>::type* for single precision data.
+    void* ptr;
+
+    /// Leading dimension in units of the element type.
+    int ld;
+
+    /// True if the elements are stored in single precision.
+    bool fp32;
+
+    /// Panel which starts at the element (i, j) of this panel.
+    template <typename T>
+    inline gemm_panel at(int i__, int j__) const
+    {
+        size_t ofs = i__ + static_cast<size_t>(ld) * j__;
+        if (fp32) {
+            return {static_cast<typename fp32_type<T>::type*>(ptr) + ofs, ld, true};
+        } else {
+            return {static_cast<T*>(ptr) + ofs, ld, false};
+        }
+    }
+
+    /// Element (i, j) in double precision.
+    template <typename T>
+    inline T value(int i__, int j__) const
+    {
+        size_t ofs = i__ + static_cast<size_t>(ld) * j__;
+        if (fp32) {
+            return static_cast<T>(static_cast<typename fp32_type<T>::type*>(ptr)[ofs]);
+        } else {
+            return static_cast<T*>(ptr)[ofs];
+        }
+    }
+};
+
+/// Panel of the plane-wave coefficients of the wave-functions starting from the wave-function i0.
+template <typename T>
+inline gemm_panel pw_panel(Wave_functions& wf__, int ispn__, int i0__)
+{
+    int k = (std::is_same<T, double>::value) ? 2 : 1;
+    if (wf__.fp32()) {
+        auto& pw = wf__.pw_coeffs_fp32(ispn__).prime();
+        return {pw.template at<CPU>(0, i0__), k * static_cast<int>(pw.ld()), true};
+    } else {
+        auto& pw = wf__.pw_coeffs(ispn__).prime();
+        return {pw.template at<CPU>(0, i0__), k * static_cast<int>(pw.ld()), false};
+    }
+}
+
+/// Copy a (rows x cols) panel into a contiguous buffer of a different precision.
+template <typename T, typename F>
+inline void convert_panel(int rows__, int cols__, T const* src__, int ld_src__, F* dst__, int ld_dst__)
+{
+    #pragma omp parallel for schedule(static)
+    for (int j = 0; j < cols__; j++) {
+        T const* src = src__ + static_cast<size_t>(ld_src__) * j;
+        F* dst = dst__ + static_cast<size_t>(ld_dst__) * j;
+        for (int i = 0; i < rows__; i++) {
+            dst[i] = static_cast<F>(src[i]);
+        }
+    }
+}
+
+/// Compute C = alpha * op(A) * B + beta * C with the product evaluated in single precision.
+/** Each of the panels A, B and C can be stored either in double or in single precision. Single precision panels
+ *  are used by {s,c}gemm directly, double precision panels are converted to a single precision buffer. The long
+ *  dimension of the wave-function panels (rows of A and C for op(A) = A, rows of A and B for op(A) = A^H) is
+ *  processed in blocks, so the converted copies stay small; they are kept in a buffer which is reused between the
+ *  calls. The product of each block is added to C in double precision. Only the CPU memory is used. C must not
+ *  overlap with B; it can be the same panel as A if op(A) = A and beta = 0. */
+template <typename T>
+inline void gemm_fp32(int transa__, int m__, int n__, int k__, T alpha__, gemm_panel A__, gemm_panel B__, T beta__,
+                      gemm_panel C__, mdarray<std::complex<float>, 1>& buf__)
+{
+    PROFILE("sddk::gemm_fp32");
+
+    using F = typename fp32_type<T>::type;
+
+    /* size of the block of rows */
+    const int BR{4096};
+
+    /* get the buffer for a given number of single precision numbers */
+    auto get_buf = [&buf__](size_t size__)
+    {
+        size_t sz = (size__ * sizeof(F) + sizeof(std::complex<float>) - 1) / sizeof(std::complex<float>);
+        if (buf__.size() < sz) {
+            buf__ = mdarray<std::complex<float>, 1>(sz, memory_t::host, "gemm_fp32_buf");
+        }
+        return reinterpret_cast<F*>(buf__.template at<CPU>());
+    };
+
+    /* single precision view of the (nr x nc) block of the panel; double precision data is converted to tmp */
+    auto load = [](gemm_panel const& p__, int i0__, int nr__, int nc__, F* tmp__, int& ld__) -> F const*
+    {
+        if (p__.fp32) {
+            ld__ = p__.ld;
+            return static_cast<F const*>(p__.ptr) + i0__;
+        }
+        convert_panel(nr__, nc__, static_cast<T const*>(p__.ptr) + i0__, p__.ld, tmp__, nr__);
+        ld__ = nr__;
+        return tmp__;
+    };
+
+    /* C[i0:i0+nr, :] = alpha * c + beta * C[i0:i0+nr, :] */
+    auto update_c = [&](int i0__, int nr__, F const* c__, T beta__)
+    {
+        #pragma omp parallel for schedule(static)
+        for (int j = 0; j < n__; j++) {
+            for (int i = 0; i < nr__; i++) {
+                T v = alpha__ * static_cast<T>(c__[i + static_cast<size_t>(nr__) * j]);
+                size_t ofs = i0__ + i + static_cast<size_t>(C__.ld) * j;
+                /* don't multiply by beta = 0 to avoid propagating uninitialized values */
+                if (C__.fp32) {
+                    auto c = static_cast<F*>(C__.ptr);
+                    c[ofs] = static_cast<F>((beta__ == T(0)) ? v : beta__ * static_cast<T>(c[ofs]) + v);
+                } else {
+                    auto c = static_cast<T*>(C__.ptr);
+                    c[ofs] = (beta__ == T(0)) ? v : beta__ * c[ofs] + v;
+                }
+            }
+        }
+    };
+
+    if (transa__ == 0) {
+        int br = std::min(BR, m__);
+        F* b = get_buf(static_cast<size_t>(k__) * n__ + static_cast<size_t>(br) * (k__ + n__));
+        F* a = b + static_cast<size_t>(k__) * n__;
+        F* c = a + static_cast<size_t>(br) * k__;
+
+        int ldb;
+        auto bp = load(B__, 0, k__, n__, b, ldb);
+        for (int i0 = 0; i0 < m__; i0 += br) {
+            int nr = std::min(br, m__ - i0);
+            int lda;
+            auto ap = load(A__, i0, nr, k__, a, lda);
+            linalg<CPU>::gemm(0, 0, nr, n__, k__, F(1), ap, lda, bp, ldb, F(0), c, nr);
+            update_c(i0, nr, c, beta__);
+        }
+    } else {
+        int br = std::min(BR, k__);
+        F* c = get_buf(static_cast<size_t>(m__) * n__ + static_cast<size_t>(br) * (m__ + n__));
+        F* a = c + static_cast<size_t>(m__) * n__;
+        F* b = a + static_cast<size_t>(br) * m__;
+
+        T beta = beta__;
+        for (int i0 = 0; i0 < k__; i0 += br) {
+            int nr = std::min(br, k__ - i0);
+            int lda, ldb;
+            auto ap = load(A__, i0, nr, m__, a, lda);
+            auto bp = load(B__, i0, nr, n__, b, ldb);
+            linalg<CPU>::gemm(transa__, 0, m__, n__, nr, F(1), ap, lda, bp, ldb, F(0), c, m__);
+            update_c(0, m__, c, beta);
+            beta = T(1);
+        }
+        if (k__ == 0 && beta__ != T(1)) {
+            std::fill(c, c + static_cast<size_t>(m__) * n__, F(0));
+            update_c(0, m__, c, beta__);
+        }
+    }
+}
@@ -91,6 +91,12 @@ inline void inner(device_t        pu__,
     T alpha = (std::is_same<T, double_complex>::value) ? 1 : 2;
     T beta = 0;
 
+    /* single precision wave-functions are multiplied in single precision; they have no muffin-tin part */
+    bool fp32 = bra__.fp32() || ket__.fp32();
+    if (fp32 && pu__ != CPU) {
+        TERMINATE("inner product of single precision wave-functions is implemented only on CPU");
+    }
+
     auto local_inner = [&](int i0__,
                            int m__,
                            int j0__,
@@ -105,6 +111,25 @@ inline void inner(device_t        pu__,
         }
         beta = 0;
         for (int s = s0; s <= s1; s++) {
+            /* plane-wave part in single precision; the real case is handled as a real matrix with twice the number
+               of rows */
+            if (fp32) {
+                int k = (std::is_same<T, double>::value) ? 2 : 1;
+                auto bra = pw_panel<T>(bra__, s, i0__);
+                auto ket = pw_panel<T>(ket__, s, j0__);
+                gemm_fp32<T>(2, m__, n__, k * bra__.num_pw_rows_loc(), alpha, bra, ket, beta, {buf__, ld__, false},
+                             bra__.fp32() ? bra__.fp32_buffer() : ket__.fp32_buffer());
+                /* subtract one extra G=0 contribution */
+                if (std::is_same<T, double>::value && comm.rank() == 0) {
+                    for (int j = 0; j < n__; j++) {
+                        for (int i = 0; i < m__; i++) {
+                            buf__[i + static_cast<size_t>(ld__) * j] -= bra.template value<T>(0, i) * ket.template value<T>(0, j);
+                        }
+                    }
+                }
+                beta = 1;
+                continue;
+            }
             /* wave-functions are complex and inner product is complex */
             if (std::is_same<T, double_complex>::value) {
                 switch (pu__) {
@@ -438,3 +463,156 @@ inline void inner(device_t        pu__,
         }
     }
 }
+
+/// Complex conjugate which keeps the type of a real argument.
+inline double conj_val(double x__)
+{
+    return x__;
+}
+
+inline double_complex conj_val(double_complex z__)
+{
+    return std::conj(z__);
+}
+
+/// Inner product of wave-functions which is known to be a Hermitian matrix.
+/** This is the case of \f$ \langle \phi_{i} | \hat O | \phi_{j} \rangle \f$ with a Hermitian operator \f$ \hat O \f$
+ *  (including the identity) and the same range of indices for the "bra" and "ket" wave-functions. Only the upper
+ *  triangle of the \f$ n \times n \f$ matrix is computed, column panel by column panel, and only the packed upper
+ *  triangle is reduced between MPI ranks. The lower triangle is restored from the Hermitian symmetry:
+ *  \f[
+ *    S_{irow0+i,jcol0+j} = \langle \phi_{i0 + i} | \tilde \phi_{j0 + j} \rangle, \quad
+ *    S_{irow0+j,jcol0+i} = S_{irow0+i,jcol0+j}^{*}, \quad i \le j
+ *  \f]
+ *  The GPU run falls back to the full inner product.
+ */
+template <typename T>
+inline void inner_herm(device_t        pu__,
+                       int             ispn__,
+                       Wave_functions& bra__,
+                       int             i0__,
+                       Wave_functions& ket__,
+                       int             j0__,
+                       int             n__,
+                       dmatrix<T>&     result__,
+                       int             irow0__,
+                       int             jcol0__)
+{
+    static_assert(std::is_same<T, double>::value || std::is_same<T, double_complex>::value, "wrong type");
+
+    if (pu__ != CPU) {
+        inner(pu__, ispn__, bra__, i0__, n__, ket__, j0__, n__, result__, irow0__, jcol0__);
+        return;
+    }
+
+    PROFILE("sddk::Wave_functions::inner_herm");
+
+    auto& comm = bra__.comm();
+
+    /* width of the column panel */
+    const int nb{64};
+
+    T alpha = (std::is_same<T, double_complex>::value) ? 1 : 2;
+
+    /* single precision wave-functions are multiplied in single precision; they have no muffin-tin part */
+    bool fp32 = bra__.fp32() || ket__.fp32();
+
+    /* upper triangle of the local contribution */
+    mdarray<T, 2> tmp(n__, n__);
+    tmp.zero();
+
+    int s0{0};
+    int s1{1};
+    if (ispn__ != 2) {
+        s0 = s1 = ispn__;
+    }
+    for (int s = s0; s <= s1; s++) {
+        /* number of real or complex rows of the plane-wave part */
+        int k = (std::is_same<T, double>::value) ? 2 : 1;
+        int nrow = k * bra__.num_pw_rows_loc();
+
+        if (fp32) {
+            auto bra = pw_panel<T>(bra__, s, i0__);
+            auto ket = pw_panel<T>(ket__, s, j0__);
+            for (int j = 0; j < n__; j += nb) {
+                int ncol = std::min(nb, n__ - j);
+                /* rows [0, j + ncol) of the columns [j, j + ncol) */
+                gemm_fp32<T>(2, j + ncol, ncol, nrow, alpha, bra, ket.template at<T>(0, j), T(1),
+                             {tmp.template at<CPU>(0, j), n__, false},
+                             bra__.fp32() ? bra__.fp32_buffer() : ket__.fp32_buffer());
+            }
+            /* subtract one extra G=0 contribution */
+            if (std::is_same<T, double>::value && comm.rank() == 0) {
+                for (int j = 0; j < n__; j++) {
+                    for (int i = 0; i <= j; i++) {
+                        tmp(i, j) -= bra.template value<T>(0, i) * ket.template value<T>(0, j);
+                    }
+                }
+            }
+            continue;
+        }
+
+        T* bra = reinterpret_cast<T*>(bra__.pw_coeffs(s).prime().at<CPU>(0, i0__));
+        T* ket = reinterpret_cast<T*>(ket__.pw_coeffs(s).prime().at<CPU>(0, j0__));
+        int ld_bra = k * bra__.pw_coeffs(s).prime().ld();
+        int ld_ket = k * ket__.pw_coeffs(s).prime().ld();
+
+        for (int j = 0; j < n__; j += nb) {
+            int ncol = std::min(nb, n__ - j);
+            /* rows [0, j + ncol) of the columns [j, j + ncol) */
+            linalg<CPU>::gemm(2, 0, j + ncol, ncol, nrow, alpha, bra, ld_bra, ket + static_cast<size_t>(ld_ket) * j,
+                              ld_ket, linalg_const<T>::one(), tmp.template at<CPU>(0, j), n__);
+        }
+        if (std::is_same<T, double>::value) {
+            if (bra__.has_mt()) {
+                TERMINATE("not implemented");
+            }
+            /* subtract one extra G=0 contribution */
+            if (comm.rank() == 0) {
+                linalg<CPU>::ger(n__, n__, -1.0, reinterpret_cast<double*>(bra), ld_bra, reinterpret_cast<double*>(ket),
+                                 ld_ket, reinterpret_cast<double*>(tmp.template at<CPU>()), n__);
+            }
+        } else {
+            if (bra__.has_mt()) {
+                T* bra_mt = reinterpret_cast<T*>(bra__.mt_coeffs(s).prime().at<CPU>(0, i0__));
+                T* ket_mt = reinterpret_cast<T*>(ket__.mt_coeffs(s).prime().at<CPU>(0, j0__));
+                int ld_bra_mt = bra__.mt_coeffs(s).prime().ld();
+                int ld_ket_mt = ket__.mt_coeffs(s).prime().ld();
+                for (int j = 0; j < n__; j += nb) {
+                    int ncol = std::min(nb, n__ - j);
+                    linalg<CPU>::gemm(2, 0, j + ncol, ncol, bra__.mt_coeffs(s).num_rows_loc(), alpha, bra_mt, ld_bra_mt,
+                                      ket_mt + static_cast<size_t>(ld_ket_mt) * j, ld_ket_mt, linalg_const<T>::one(),
+                                      tmp.template at<CPU>(0, j), n__);
+                }
+            }
+        }
+    }
+
+    /* pack and reduce the upper triangle */
+    std::vector<T> packed(n__ * (n__ + 1) / 2);
+    #pragma omp parallel for schedule(static)
+    for (int j = 0; j < n__; j++) {
+        std::copy(&tmp(0, j), &tmp(0, j) + j + 1, &packed[j * (j + 1) / 2]);
+    }
+    if (comm.size() > 1) {
+        comm.allreduce(packed.data(), static_cast<int>(packed.size()));
+    }
+
+    /* store the local part of the result */
+    auto& spl_row = result__.spl_row();
+    auto& spl_col = result__.spl_col();
+    #pragma omp parallel for schedule(static)
+    for (int jloc = 0; jloc < spl_col.local_size(); jloc++) {
+        int j = spl_col[jloc] - jcol0__;
+        if (j < 0 || j >= n__) {
+            continue;
+        }
+        for (int iloc = 0; iloc < spl_row.local_size(); iloc++) {
+            int i = spl_row[iloc] - irow0__;
+            if (i < 0 || i >= n__) {
+                continue;
+            }
+            result__(iloc, jloc) = (i <= j) ? packed[j * (j + 1) / 2 + i] : conj_val(packed[i * (i + 1) / 2 + j]);
+        }
+    }
+}
@@ -22,133 +22,53 @@
  *  \brief Wave-function orthonormalization.
  */
 
-/// Orthogonalize n new wave-functions to the N old wave-functions
-template <typename T, int idx_bra__, int idx_ket__>
-inline void orthogonalize(device_t                     pu__,
-                          int                          ispn__, 
-                          std::vector<Wave_functions*> wfs__,
-                          int                          N__,
-                          int                          n__,
-                          dmatrix<T>&                  o__,
-                          Wave_functions&              tmp__)
+/// Method of orthonormalization of the new wave-functions.
+enum class ortho_method_t
 {
-    PROFILE("sddk::Wave_functions::orthogonalize");
-
-    const char* sddk_pp_raw = std::getenv("SDDK_PRINT_PERFORMANCE");
-    int sddk_pp = (sddk_pp_raw == NULL) ? 0 : std::atoi(sddk_pp_raw);
-
-    auto& comm = wfs__[0]->comm();
-
-#ifdef __GPU
-    if (pu__ == GPU) {
-        acc::set_device();
-    }
-#endif
-    int K{0};
-    if (sddk_pp) {
-        K = wfs__[0]->gkvec().num_gvec() + wfs__[0]->num_mt_coeffs();
-        if (std::is_same<T, double>::value) {
-            K *= 2;
-        }
-    }
-
-    const char* sddk_debug_raw = std::getenv("SDDK_DEBUG");
-    int sddk_debug = (sddk_debug_raw == NULL) ? 0 : std::atoi(sddk_debug_raw);
-
-    double ngop{0};
-    if (std::is_same<T, double>::value) {
-        ngop = 2e-9;
-    }
-    if (std::is_same<T, double_complex>::value) {
-        ngop = 8e-9;
-    }
-
-    if (sddk_pp) {
-        comm.barrier();
-    }
-    //double time = -omp_get_wtime();
-
-    double gflops{0};
-
-    /* project out the old subspace:
-     * |\tilda phi_new> = |phi_new> - |phi_old><phi_old|phi_new> */
-    if (N__ > 0) {
-        inner(pu__, ispn__, *wfs__[idx_bra__], 0, N__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
-        transform(pu__, ispn__, -1.0, wfs__, 0, N__, o__, 0, 0, 1.0, wfs__, N__, n__);
-
-        if (sddk_pp) {
-            gflops += static_cast<int>(1 + wfs__.size()) * ngop * N__ * n__ * K; // inner and transfrom have the same number of flops
-        }
-    }
-
-    if (sddk_debug >= 2) {
-        if (o__.comm().rank() == 0) {
-            printf("check QR decomposition, matrix size : %i\n", n__);
-        }
-        inner(pu__, ispn__, *wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
-
-        linalg<CPU>::geqrf(n__, n__, o__, 0, 0);
-        auto diag = o__.get_diag(n__);
-        if (o__.comm().rank() == 0) {
-            for (int i = 0; i < n__; i++) {
-                if (std::abs(diag[i]) < 1e-6) {
-                    std::cout << "small norm: " << i << " " << diag[i] << std::endl;
-                }
-            }
-        }
-
-        if (o__.comm().rank() == 0) {
-            printf("check eigen-values, matrix size : %i\n", n__);
-        }
-        inner(pu__, ispn__, *wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
-        
-        //if (sddk_debug >= 3) {
-        //    save_to_hdf5("nxn_overlap.h5", o__, n__);
-        //}
-
-        std::vector<double> eo(n__);
-        dmatrix<T> evec(o__.num_rows(), o__.num_cols(), o__.blacs_grid(), o__.bs_row(), o__.bs_col());
-
-        auto solver = Eigensolver_factory<T>(ev_solver_t::scalapack);
-        solver->solve(n__, o__, eo.data(), evec);
-
-        if (o__.comm().rank() == 0) {
-            for (int i = 0; i < n__; i++) {
-                if (eo[i] < 1e-6) {
-                    std::cout << "small eigen-value " << i << " " << eo[i] << std::endl;
-                }
-            }
-        }
-    }
+    /// Cholesky factorization of the overlap matrix.
+    cholesky,
 
-    /* orthogonalize new n__ x n__ block */
-    inner(pu__, ispn__, *wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+    /// Two passes of projection and Cholesky QR; the overlap matrix of the first pass is shifted if needed.
+    cholesky_qr2,
 
-    if (sddk_debug >= 1) {
-        if (o__.comm().rank() == 0) {
-            printf("check diagonal\n");
-        }
-        auto diag = o__.get_diag(n__);
-        for (int i = 0; i < n__; i++) {
-            if (std::real(diag[i]) <= 0 || std::imag(diag[i]) > 1e-12) {
-                std::cout << "wrong diagonal: " << i << " " << diag[i] << std::endl;
-            }
-        }
-        if (o__.comm().rank() == 0) {
-            printf("check hermitian\n");
-        }
-        double d = check_hermitian(o__, n__);
-        if (d > 1e-12 && o__.comm().rank() == 0) {
-            std::stringstream s;
-            s << "matrix is not hermitian, max diff = " << d;
-            WARNING(s);
-        }
-    }
+    /// Communication-avoiding QR factorization over the distribution of G-vectors.
+    tsqr
+};
 
-    if (sddk_pp) {
-        gflops += ngop * n__ * n__ * K;
+inline ortho_method_t get_ortho_method_t(std::string name__)
+{
+    std::transform(name__.begin(), name__.end(), name__.begin(), ::tolower);
+
+    static const std::map<std::string, ortho_method_t> map_to_type = {
+        {"cholesky", ortho_method_t::cholesky},
+        {"cholesky_qr2", ortho_method_t::cholesky_qr2},
+        {"tsqr", ortho_method_t::tsqr}
+    };
+
+    if (map_to_type.count(name__) == 0) {
+        std::stringstream s;
+        s << "wrong label of orthogonalization method: " << name__;
+        TERMINATE(s);
     }
+    return map_to_type.at(name__);
+}
 
+/// Orthonormalize n new wave-functions using the Cholesky factorization of their overlap matrix.
+/** On input the matrix o contains the overlap \f$ O_{ij} = \langle \phi_{N+i} | \hat O | \phi_{N+j} \rangle \f$.
+ *  The matrix \f$ O + \sigma I \f$ is factorized as \f$ U^{H}U \f$ and all wave-functions are transformed
+ *  by \f$ U^{-1} \f$. The error code of the factorization is returned; the wave-functions are not changed if the
+ *  factorization fails.
+ */
+template <typename T>
+inline int orthogonalize_cholesky(device_t                     pu__,
+                                  int                          ispn__,
+                                  std::vector<Wave_functions*> wfs__,
+                                  int                          N__,
+                                  int                          n__,
+                                  dmatrix<T>&                  o__,
+                                  Wave_functions&              tmp__,
+                                  double                       shift__ = 0)
+{
     /* single MPI rank */
     if (o__.comm().size() == 1) {
         bool use_magma{false};
@@ -158,13 +78,22 @@ inline void orthogonalize(device_t                     pu__,
         }
         #endif
 
+        if (shift__ != 0) {
+            for (int i = 0; i < n__; i++) {
+                o__(i, i) += shift__;
+            }
+            #ifdef __GPU
+            if (use_magma) {
+                acc::copyin(o__.template at<GPU>(), o__.ld(), o__.template at<CPU>(), o__.ld(), n__, n__);
+            }
+            #endif
+        }
+
         if (use_magma) {
             #ifdef __GPU
             /* Cholesky factorization */
             if (int info = linalg<GPU>::potrf(n__, o__.template at<GPU>(), o__.ld())) {
-                std::stringstream s;
-                s << "error in GPU factorization, info = " << info;
-                TERMINATE(s);
+                return info;
             }
             /* inversion of triangular matrix */
             if (linalg<GPU>::trtri(n__, o__.template at<GPU>(), o__.ld())) {
@@ -174,13 +103,7 @@ inline void orthogonalize(device_t                     pu__,
         } else { /* CPU version */
             /* Cholesky factorization */
             if (int info = linalg<CPU>::potrf(n__, &o__(0, 0), o__.ld())) {
-                std::stringstream s;
-                s << "error in factorization, info = " << info << std::endl
-                  << "number of existing states: " << N__ << std::endl
-                  << "number of new states: " << n__ << std::endl
-                  << "number of wave_functions: " << wfs__.size() << std::endl
-                  << "idx_bra: " << idx_bra__ << " " << "idx_ket:" << idx_ket__;
-                TERMINATE(s);
+                return info;
             }
             /* inversion of triangular matrix */
             if (linalg<CPU>::trtri(n__, &o__(0, 0), o__.ld())) {
@@ -203,6 +126,20 @@ inline void orthogonalize(device_t                     pu__,
             if (pu__ == CPU) {
                 /* multiplication by triangular matrix */
                 for (auto& e: wfs__) {
+                    /* single precision wave-functions are multiplied by the full matrix with zero lower part */
+                    if (e->fp32()) {
+                        mdarray<T, 2> u(n__, n__);
+                        for (int j = 0; j < n__; j++) {
+                            for (int i = 0; i < n__; i++) {
+                                u(i, j) = (i <= j) ? o__(i, j) : T(0);
+                            }
+                        }
+                        int k = (std::is_same<T, double>::value) ? 2 : 1;
+                        auto p = pw_panel<T>(*e, s, N__);
+                        gemm_fp32<T>(0, k * e->num_pw_rows_loc(), n__, n__, T(1), p, {u.template at<CPU>(), n__, false}, T(0),
+                                     p, e->fp32_buffer());
+                        continue;
+                    }
                     /* wave functions are complex, transformation matrix is complex */
                     if (std::is_same<T, double_complex>::value) {
                         linalg<CPU>::trmm('R', 'U', 'N', e->pw_coeffs(s).num_rows_loc(), n__, double_complex(1, 0),
@@ -269,18 +206,12 @@ inline void orthogonalize(device_t                     pu__,
         }
     } else { /* parallel transformation */
         utils::timer t1("sddk::Wave_functions::orthogonalize|potrf");
-        mdarray<T, 1> diag;
         o__.make_real_diag(n__);
-        if (sddk_debug >= 1) {
-            diag = o__.get_diag(n__);
+        for (int i = 0; i < n__; i++) {
+            o__.add(i, i, shift__);
         }
         if (int info = linalg<CPU>::potrf(n__, o__)) {
-            std::stringstream s;
-            s << "error in Cholesky factorization, info = " << info << ", matrix size = " << n__;
-            if (sddk_debug >= 1) {
-                s << std::endl << "  diag = " << diag[info - 1];
-            }
-            TERMINATE(s);
+            return info;
         }
         t1.stop();
 
@@ -310,8 +241,336 @@ inline void orthogonalize(device_t                     pu__,
             }
         }
     }
+    return 0;
 }
 
+/// Orthonormalize n new wave-functions with the communication-avoiding QR factorization (TSQR).
+/** Each MPI rank computes the QR factorization of its local rows of the wave-functions. The triangular factors
+ *  are combined pairwise along a binary tree of ranks and the final factor R is broadcast, so only
+ *  \f$ \log_2 P \f$ messages of size \f$ n^2 \f$ are exchanged. All wave-functions are then transformed locally
+ *  by \f$ R^{-1} \f$. Only the Euclidean metric (\f$ \hat O = 1 \f$) is supported. For real wave-functions the
+ *  local rows are scaled such that their Euclidean product reproduces the inner product over the reduced set
+ *  of G-vectors.
+ */
+template <typename T>
+inline void orthogonalize_tsqr(int                          ispn__,
+                               std::vector<Wave_functions*> wfs__,
+                               int                          idx__,
+                               int                          N__,
+                               int                          n__)
+{
+    PROFILE("sddk::Wave_functions::orthogonalize_tsqr");
+
+    auto& phi = *wfs__[idx__];
+    auto& comm = phi.comm();
+
+    bool is_real = std::is_same<T, double>::value;
+
+    if (is_real && phi.has_mt()) {
+        TERMINATE("not implemented");
+    }
+
+    int s0{0};
+    int s1{1};
+    if (ispn__ != 2) {
+        s0 = s1 = ispn__;
+    }
+
+    /* number of local rows of the stacked matrix */
+    int nrow{0};
+    for (int s = s0; s <= s1; s++) {
+        nrow += (is_real ? 2 : 1) * phi.pw_coeffs(s).num_rows_loc();
+        if (phi.has_mt()) {
+            nrow += phi.mt_coeffs(s).num_rows_loc();
+        }
+    }
+    /* pad the local matrix with zeros to have at least n rows; R factor is then always n x n */
+    int ld = std::max(nrow, n__);
+
+    mdarray<T, 2> a(ld, n__);
+    a.zero();
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n__; i++) {
+        int r{0};
+        for (int s = s0; s <= s1; s++) {
+            if (is_real) {
+                int nr = 2 * phi.pw_coeffs(s).num_rows_loc();
+                auto src = reinterpret_cast<double*>(phi.pw_coeffs(s).prime().at<CPU>(0, N__ + i));
+                for (int j = 0; j < nr; j++) {
+                    a(r + j, i) = std::sqrt(2.0) * src[j];
+                }
+                /* G=0 component is counted once */
+                if (comm.rank() == 0 && nr) {
+                    a(r, i)     = src[0];
+                    a(r + 1, i) = 0;
+                }
+                r += nr;
+            } else {
+                int nr = phi.pw_coeffs(s).num_rows_loc();
+                auto src = reinterpret_cast<T*>(phi.pw_coeffs(s).prime().at<CPU>(0, N__ + i));
+                std::copy(src, src + nr, &a(r, i));
+                r += nr;
+                if (phi.has_mt()) {
+                    nr  = phi.mt_coeffs(s).num_rows_loc();
+                    src = reinterpret_cast<T*>(phi.mt_coeffs(s).prime().at<CPU>(0, N__ + i));
+                    std::copy(src, src + nr, &a(r, i));
+                    r += nr;
+                }
+            }
+        }
+    }
+
+    if (int info = linalg<CPU>::geqrf(ld, n__, a.template at<CPU>(), ld)) {
+        std::stringstream s;
+        s << "error in local QR factorization, info = " << info;
+        TERMINATE(s);
+    }
+
+    /* R factor of the local rows; [R_1; R_2] is stacked in the first 2n rows */
+    mdarray<T, 2> r(2 * n__, n__);
+    r.zero();
+    for (int j = 0; j < n__; j++) {
+        std::copy(&a(0, j), &a(0, j) + j + 1, &r(0, j));
+    }
+
+    /* reduce the R factors along the binary tree of ranks */
+    mdarray<T, 2> r1(n__, n__);
+    for (int d = 1; d < comm.size(); d *= 2) {
+        if (comm.rank() % (2 * d) == d) {
+            for (int j = 0; j < n__; j++) {
+                std::copy(&r(0, j), &r(0, j) + n__, &r1(0, j));
+            }
+            comm.send(r1.template at<CPU>(), n__ * n__, comm.rank() - d, d);
+            break;
+        }
+        if (comm.rank() % (2 * d) == 0 && comm.rank() + d < comm.size()) {
+            comm.recv(r1.template at<CPU>(), n__ * n__, comm.rank() + d, d);
+            for (int j = 0; j < n__; j++) {
+                std::copy(&r1(0, j), &r1(0, j) + j + 1, &r(n__, j));
+                std::fill(&r(n__, j) + j + 1, &r(0, j) + 2 * n__, T(0));
+            }
+            if (int info = linalg<CPU>::geqrf(2 * n__, n__, r.template at<CPU>(), 2 * n__)) {
+                std::stringstream s;
+                s << "error in QR factorization of the stacked R factors, info = " << info;
+                TERMINATE(s);
+            }
+            for (int j = 0; j < n__; j++) {
+                std::fill(&r(0, j) + j + 1, &r(0, j) + 2 * n__, T(0));
+            }
+        }
+    }
+    for (int j = 0; j < n__; j++) {
+        std::copy(&r(0, j), &r(0, j) + n__, &r1(0, j));
+    }
+    comm.bcast(r1.template at<CPU>(), n__ * n__, 0);
+
+    /* inversion of triangular matrix */
+    if (linalg<CPU>::trtri(n__, r1.template at<CPU>(), n__)) {
+        TERMINATE("error in inversion");
+    }
+
+    /* local multiplication by R^{-1} */
+    for (int s = s0; s <= s1; s++) {
+        for (auto& e: wfs__) {
+            if (is_real) {
+                linalg<CPU>::trmm('R', 'U', 'N', 2 * e->pw_coeffs(s).num_rows_loc(), n__, 1.0,
+                                  reinterpret_cast<double*>(r1.template at<CPU>()), n__,
+                                  reinterpret_cast<double*>(e->pw_coeffs(s).prime().at<CPU>(0, N__)), 2 * e->pw_coeffs(s).prime().ld());
+            } else {
+                linalg<CPU>::trmm('R', 'U', 'N', e->pw_coeffs(s).num_rows_loc(), n__, double_complex(1, 0),
+                                  reinterpret_cast<double_complex*>(r1.template at<CPU>()), n__,
+                                  e->pw_coeffs(s).prime().at<CPU>(0, N__), e->pw_coeffs(s).prime().ld());
+                if (e->has_mt()) {
+                    linalg<CPU>::trmm('R', 'U', 'N', e->mt_coeffs(s).num_rows_loc(), n__, double_complex(1, 0),
+                                      reinterpret_cast<double_complex*>(r1.template at<CPU>()), n__,
+                                      e->mt_coeffs(s).prime().at<CPU>(0, N__), e->mt_coeffs(s).prime().ld());
+                }
+            }
+        }
+    }
+}
+
+/// Orthogonalize n new wave-functions to the N old wave-functions
+template <typename T, int idx_bra__, int idx_ket__>
+inline void orthogonalize(device_t                     pu__,
+                          int                          ispn__, 
+                          std::vector<Wave_functions*> wfs__,
+                          int                          N__,
+                          int                          n__,
+                          dmatrix<T>&                  o__,
+                          Wave_functions&              tmp__,
+                          ortho_method_t               method__ = ortho_method_t::cholesky)
+{
+    PROFILE("sddk::Wave_functions::orthogonalize");
+
+    const char* sddk_pp_raw = std::getenv("SDDK_PRINT_PERFORMANCE");
+    int sddk_pp = (sddk_pp_raw == NULL) ? 0 : std::atoi(sddk_pp_raw);
+
+    auto& comm = wfs__[0]->comm();
+
+#ifdef __GPU
+    if (pu__ == GPU) {
+        acc::set_device();
+    }
+#endif
+    int K{0};
+    if (sddk_pp) {
+        K = wfs__[0]->gkvec().num_gvec() + wfs__[0]->num_mt_coeffs();
+        if (std::is_same<T, double>::value) {
+            K *= 2;
+        }
+    }
+
+    const char* sddk_debug_raw = std::getenv("SDDK_DEBUG");
+    int sddk_debug = (sddk_debug_raw == NULL) ? 0 : std::atoi(sddk_debug_raw);
+
+    double ngop{0};
+    if (std::is_same<T, double>::value) {
+        ngop = 2e-9;
+    }
+    if (std::is_same<T, double_complex>::value) {
+        ngop = 8e-9;
+    }
+
+    if (sddk_pp) {
+        comm.barrier();
+    }
+    //double time = -omp_get_wtime();
+
+    double gflops{0};
+
+    /* TSQR works with the Euclidean metric on CPU and double precision wave-functions; fall back to CholeskyQR2
+     * otherwise */
+    if (method__ == ortho_method_t::tsqr && (idx_bra__ != idx_ket__ || pu__ != CPU || wfs__[0]->fp32())) {
+        method__ = ortho_method_t::cholesky_qr2;
+    }
+
+    /* CholeskyQR2 repeats the projection and the orthonormalization */
+    int num_pass = (method__ == ortho_method_t::cholesky_qr2) ? 2 : 1;
+    bool shifted{false};
+
+    for (int ipass = 0; ipass < num_pass; ipass++) {
+        /* project out the old subspace:
+         * |\tilda phi_new> = |phi_new> - |phi_old><phi_old|phi_new> */
+        if (N__ > 0) {
+            inner(pu__, ispn__, *wfs__[idx_bra__], 0, N__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+            transform(pu__, ispn__, -1.0, wfs__, 0, N__, o__, 0, 0, 1.0, wfs__, N__, n__);
+
+            if (sddk_pp) {
+                gflops += static_cast<int>(1 + wfs__.size()) * ngop * N__ * n__ * K; // inner and transfrom have the same number of flops
+            }
+        }
+
+        if (sddk_debug >= 2) {
+            if (o__.comm().rank() == 0) {
+                printf("check QR decomposition, matrix size : %i\n", n__);
+            }
+            inner(pu__, ispn__, *wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+
+            linalg<CPU>::geqrf(n__, n__, o__, 0, 0);
+            auto diag = o__.get_diag(n__);
+            if (o__.comm().rank() == 0) {
+                for (int i = 0; i < n__; i++) {
+                    if (std::abs(diag[i]) < 1e-6) {
+                        std::cout << "small norm: " << i << " " << diag[i] << std::endl;
+                    }
+                }
+            }
+
+            if (o__.comm().rank() == 0) {
+                printf("check eigen-values, matrix size : %i\n", n__);
+            }
+            inner(pu__, ispn__, *wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+        
+            //if (sddk_debug >= 3) {
+            //    save_to_hdf5("nxn_overlap.h5", o__, n__);
+            //}
+
+            std::vector<double> eo(n__);
+            dmatrix<T> evec(o__.num_rows(), o__.num_cols(), o__.blacs_grid(), o__.bs_row(), o__.bs_col());
+
+            auto solver = Eigensolver_factory<T>(ev_solver_t::scalapack);
+            solver->solve(n__, o__, eo.data(), evec);
+
+            if (o__.comm().rank() == 0) {
+                for (int i = 0; i < n__; i++) {
+                    if (eo[i] < 1e-6) {
+                        std::cout << "small eigen-value " << i << " " << eo[i] << std::endl;
+                    }
+                }
+            }
+        }
+
+        if (method__ == ortho_method_t::tsqr) {
+            orthogonalize_tsqr<T>(ispn__, wfs__, idx_bra__, N__, n__);
+            continue;
+        }
+
+        /* orthogonalize new n__ x n__ block; the overlap matrix is Hermitian */
+        inner_herm(pu__, ispn__, *wfs__[idx_bra__], N__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+
+        if (sddk_debug >= 1) {
+            if (o__.comm().rank() == 0) {
+                printf("check diagonal\n");
+            }
+            auto diag = o__.get_diag(n__);
+            for (int i = 0; i < n__; i++) {
+                if (std::real(diag[i]) <= 0 || std::imag(diag[i]) > 1e-12) {
+                    std::cout << "wrong diagonal: " << i << " " << diag[i] << std::endl;
+                }
+            }
+            if (o__.comm().rank() == 0) {
+                printf("check hermitian\n");
+            }
+            double d = check_hermitian(o__, n__);
+            if (d > 1e-12 && o__.comm().rank() == 0) {
+                std::stringstream s;
+                s << "matrix is not hermitian, max diff = " << d;
+                WARNING(s);
+            }
+        }
+
+        if (sddk_pp) {
+            gflops += ngop * n__ * n__ * K;
+        }
+
+        if (int info = orthogonalize_cholesky<T>(pu__, ispn__, wfs__, N__, n__, o__, tmp__)) {
+            if (method__ != ortho_method_t::cholesky_qr2 || shifted) {
+                std::stringstream s;
+                s << "error in factorization, info = " << info << std::endl
+                  << "number of existing states: " << N__ << std::endl
+                  << "number of new states: " << n__ << std::endl
+                  << "number of wave_functions: " << wfs__.size() << std::endl
+                  << "idx_bra: " << idx_bra__ << " " << "idx_ket:" << idx_ket__;
+                TERMINATE(s);
+            }
+            /* the overlap matrix is numerically not positive definite; factorize the shifted matrix
+             * O + sigma I, sigma = 11 (m n + n (n + 1)) u ||phi||^2, and do one more pass (shifted CholeskyQR3) */
+            inner_herm(pu__, ispn__, *wfs__[idx_bra__], N__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+            double tr{0};
+            for (int jloc = 0; jloc < o__.spl_col().local_size(); jloc++) {
+                for (int iloc = 0; iloc < o__.spl_row().local_size(); iloc++) {
+                    int i = o__.spl_row()[iloc];
+                    if (i == o__.spl_col()[jloc] && i < n__) {
+                        tr += std::real(o__(iloc, jloc));
+                    }
+                }
+            }
+            o__.comm().allreduce(&tr, 1);
+            double m = (wfs__[0]->gkvec().num_gvec() + wfs__[0]->num_mt_coeffs()) * ((ispn__ == 2) ? 2 : 1);
+            double shift = 11 * (m * n__ + n__ * (n__ + 1)) * 0.5 * std::numeric_limits<double>::epsilon() * tr;
+            if (int info = orthogonalize_cholesky<T>(pu__, ispn__, wfs__, N__, n__, o__, tmp__, shift)) {
+                std::stringstream s;
+                s << "error in factorization of the shifted overlap matrix, info = " << info << ", shift = " << shift;
+                TERMINATE(s);
+            }
+            shifted = true;
+            num_pass++;
+        }
+    }
+}
+
+
 template <typename T>
 inline void orthogonalize(device_t        pu__,
                           int             ispn__,
@@ -321,13 +580,14 @@ inline void orthogonalize(device_t        pu__,
                           int             N__,
                           int             n__,
                           dmatrix<T>&     o__,
-                          Wave_functions& tmp__)
+                          Wave_functions& tmp__,
+                          ortho_method_t  method__ = ortho_method_t::cholesky)
 {
     static_assert(std::is_same<T, double>::value || std::is_same<T, double_complex>::value, "wrong type");
 
     auto wfs = {&phi__, &hphi__, &ophi__};
 
-    orthogonalize<T, 0, 2>(pu__, ispn__, wfs, N__, n__, o__, tmp__);
+    orthogonalize<T, 0, 2>(pu__, ispn__, wfs, N__, n__, o__, tmp__, method__);
 }
 
 template <typename T>
@@ -338,11 +598,12 @@ inline void orthogonalize(device_t        pu__,
                           int             N__,
                           int             n__,
                           dmatrix<T>&     o__,
-                          Wave_functions& tmp__)
+                          Wave_functions& tmp__,
+                          ortho_method_t  method__ = ortho_method_t::cholesky)
 {
     static_assert(std::is_same<T, double>::value || std::is_same<T, double_complex>::value, "wrong type");
 
     auto wfs = {&phi__, &hphi__};
 
-    orthogonalize<T, 0, 0>(pu__, ispn__, wfs, N__, n__, o__, tmp__);
+    orthogonalize<T, 0, 0>(pu__, ispn__, wfs, N__, n__, o__, tmp__, method__);
 }
@@ -99,6 +99,19 @@ inline void transform(device_t                     pu__,
                wave-fucntions; in this case we set spin index of input wave-function to 0 */
             int in_s = (wf_in__->num_sc() == 1) ? 0 : s;
 
+            if (wf_in__->fp32() || wf_out__->fp32()) {
+                if (pu__ != CPU) {
+                    TERMINATE("transformation of single precision wave-functions is implemented only on CPU");
+                }
+                /* transform plane-wave part in single precision; the real case is handled as a real matrix with
+                   twice the number of rows */
+                int k = (std::is_same<T, double>::value) ? 2 : 1;
+                gemm_fp32<T>(0, k * wf_in__->num_pw_rows_loc(), n__, m__, *alpha, pw_panel<T>(*wf_in__, in_s, i0__),
+                             {ptr__, ld__, false}, T(1), pw_panel<T>(*wf_out__, s, j0__),
+                             wf_in__->fp32() ? wf_in__->fp32_buffer() : wf_out__->fp32_buffer());
+                continue;
+            }
+
             if (pu__ == CPU) {
                 if (std::is_same<T, double_complex>::value) {
                     /* transform plane-wave part */
@@ -423,3 +436,81 @@ inline void transform(device_t        pu__,
     transform<T>(pu__, ispn__, 1.0, {&wf_in__}, i0__, m__, mtrx__, irow0__, jcol0__, 0.0, {&wf_out__}, j0__, n__);
 }
 
+
+/// Linear transformation of the wave-functions in place.
+/** The following operation is performed:
+ *  \f[
+ *     \psi_{j0 + j} \leftarrow \sum_{i=0}^{m-1} \psi_{i0 + i} Z_{ij}, \quad j = 0 \dots n - 1
+ *  \f]
+ *  The output range of wave-functions can overlap the input range. The transformation matrix is not distributed:
+ *  each MPI rank holds a full copy of it (in the device memory in case of GPU). The local rows of the plane-wave
+ *  coefficients are transformed in blocks, so only a small buffer of the size of one block of rows is needed.
+ */
+template <typename T>
+inline void transform_in_place(device_t                     pu__,
+                               int                          ispn__,
+                               std::vector<Wave_functions*> wfs__,
+                               int                          i0__,
+                               int                          m__,
+                               mdarray<T, 2>&               mtrx__,
+                               int                          j0__,
+                               int                          n__)
+{
+    PROFILE("sddk::Wave_functions::transform_in_place");
+
+    static_assert(std::is_same<T, double>::value || std::is_same<T, double_complex>::value, "wrong type");
+
+    assert(m__ != 0);
+    assert(n__ != 0);
+
+    /* number of rows in one block */
+    const int BR{1024};
+
+    /* real transformation matrix is applied to real and imaginary parts of the coefficients */
+    const int k = (std::is_same<T, double>::value) ? 2 : 1;
+
+    mdarray<T, 2> buf(BR, n__, (pu__ == CPU) ? memory_t::host : memory_t::device, "transform_in_place::buf");
+
+    int s0{0};
+    int s1{1};
+    if (ispn__ != 2) {
+        s0 = s1 = ispn__;
+    }
+
+    for (auto e: wfs__) {
+        if (e->has_mt()) {
+            TERMINATE("not implemented");
+        }
+        for (int s = s0; s <= s1; s++) {
+            auto& pw = e->pw_coeffs(s);
+            int nr = k * pw.num_rows_loc();
+            int ld = k * pw.prime().ld();
+            for (int r0 = 0; r0 < nr; r0 += BR) {
+                int nrb = std::min(BR, nr - r0);
+                switch (pu__) {
+                    case CPU: {
+                        T* ptr = reinterpret_cast<T*>(pw.prime().at<CPU>()) + r0;
+                        linalg<CPU>::gemm(0, 0, nrb, n__, m__, ptr + ld * i0__, ld, mtrx__.template at<CPU>(),
+                                          mtrx__.ld(), buf.template at<CPU>(), buf.ld());
+                        for (int j = 0; j < n__; j++) {
+                            std::copy(buf.template at<CPU>(0, j), buf.template at<CPU>(0, j) + nrb,
+                                      ptr + ld * (j0__ + j));
+                        }
+                        break;
+                    }
+                    case GPU: {
+                        #ifdef __GPU
+                        T* ptr = reinterpret_cast<T*>(pw.prime().at<GPU>()) + r0;
+                        linalg<GPU>::gemm(0, 0, nrb, n__, m__, ptr + ld * i0__, ld, mtrx__.template at<GPU>(),
+                                          mtrx__.ld(), buf.template at<GPU>(), buf.ld());
+                        for (int j = 0; j < n__; j++) {
+                            acc::copy(ptr + ld * (j0__ + j), buf.template at<GPU>(0, j), nrb);
+                        }
+                        #endif
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
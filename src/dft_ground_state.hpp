@@ -634,6 +634,8 @@ inline json DFT_ground_state::find(double potential_tol, double energy_tol, int
         if (!ctx_.full_potential()) {
             /* mix density */
             rms = density_.mix();
+            /* switch local operator to double precision close to convergence */
+            ctx_.update_local_op_precision(rms);
             /* estimate new tolerance of iterative solver */
             double tol = std::max(1e-12, 0.1 * density_.dr2() / ctx_.unit_cell().num_valence_electrons());
             /* print dr2 of mixer and current iterative solver tolerance */
@@ -720,6 +722,9 @@ inline json DFT_ground_state::find(double potential_tol, double energy_tol, int
         eold = etot;
     }
 
+    /* save FFTW wisdom accumulated during the SCF loop */
+    ctx_.save_fftw_wisdom();
+
     if (write_state) {
         ctx_.create_storage_file();
         if (ctx_.full_potential()) { // TODO: why this is necessary?
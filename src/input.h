@@ -227,6 +227,7 @@ struct Mixer_input
 struct Iterative_solver_input
 {
     /// Type of the iterative solver.
+    /** It can be "exact", "davidson", "lobpcg", "ppcg" (CPU only), "rmm-diis" or "chebyshev". */
     std::string type_{""};
 
     /// Number of steps (iterations) of the solver.
@@ -271,6 +272,19 @@ struct Iterative_solver_input
      *  the randomized wave functions. */
     std::string init_subspace_{"lcao"};
 
+    /// Orthonormalization method of the new basis functions.
+    /** It can be "cholesky", "cholesky_qr2" (two passes of projection and Cholesky QR) or "tsqr" (communication-avoiding
+     *  QR over the distribution of G-vectors). */
+    std::string ortho_method_{"cholesky"};
+
+    /// Lock converged bands in the Davidson solver.
+    /** Converged lowest bands are removed from the active subspace: they are no longer rotated and the Hamiltonian
+     *  is not applied to them; new basis functions are only kept orthogonal to them. Requires orthogonalize = true. */
+    bool locking_{false};
+
+    /// Number of PPCG iterations between two Rayleigh-Ritz steps in the subspace of all bands.
+    int rr_period_{5};
+
     void read(json const& parser)
     {
         if (parser.count("iterative_solver")) {
@@ -288,6 +302,9 @@ struct Iterative_solver_input
             init_eval_old_          = section.value("init_eval_old", init_eval_old_);
             init_subspace_          = section.value("init_subspace", init_subspace_);
             std::transform(init_subspace_.begin(), init_subspace_.end(), init_subspace_.begin(), ::tolower);
+            ortho_method_           = section.value("ortho_method", ortho_method_);
+            locking_                = section.value("locking", locking_);
+            rr_period_              = section.value("rr_period", rr_period_);
         }
     }
 };
@@ -335,6 +352,55 @@ struct Control_input
     /// Main processing unit to run on.
     std::string processing_unit_{""};
 
+    /// Number of wave-functions transformed at once by the batched coarse-grid FFT.
+    /** The z-columns of all functions of the batch are exchanged with a single all-to-all call. */
+    int fft_batch_size_{8};
+
+    /// Number of wave-functions in a chunk of the pipelined all-to-all exchange of the batched FFT.
+    /** If positive, the exchange of one chunk is overlapped with the transformation of the next one. Zero disables
+     *  the pipelining. */
+    int fft_pipeline_chunk_size_{0};
+
+    /// Relative tolerance of the FFT grid dimensions above their minimal optimal sizes.
+    /** If positive, the candidate grids within the tolerance are benchmarked and the fastest one is used. */
+    double fft_grid_tolerance_{0};
+
+    /// Number of ranks in y-dimension of the pencil decomposition of the coarse-grid FFT.
+    /** Values larger than one switch the coarse-grid FFT from the slab to the pencil decomposition over a
+     *  (N / fft_pencil_ranks) x fft_pencil_ranks grid of the N ranks of the FFT communicator. */
+    int fft_pencil_ranks_{1};
+
+    /// Density RMS below which the local part of the Hamiltonian is applied in double precision.
+    /** If positive, the early SCF iterations apply the local operator with single-precision FFTs. The switch to
+     *  double precision is made once the RMS of the density mixer drops below this threshold. */
+    double fp32_rms_threshold_{0};
+
+    /// Memory (in MB) per object of beta-projectors to keep the generated chunks of plane-wave coefficients.
+    /** Chunks of beta-projectors which fit into this memory are generated once after prepare() and reused until
+     *  dismiss(); the remaining chunks are generated on the fly. Zero disables the caching. */
+    double beta_cache_memory_mb_{0};
+
+    /// Apply the non-local part of the pseudopotential Hamiltonian with beta-projectors tabulated in real space.
+    /** The projections are computed on the coarse FFT grid inside the projector spheres of atoms; the cost then
+     *  grows linearly with the number of atoms. The same projectors are used for the density matrix and forces.
+     *  Used for spin-collinear calculations on CPU without Hubbard correction and stress; otherwise the
+     *  plane-wave projectors are used and a warning is printed. */
+    bool beta_real_space_{false};
+
+    /// FFTW planning mode ("estimate", "measure" or "patient").
+    std::string fftw_plan_mode_{"estimate"};
+
+    /// Prefix of the FFTW wisdom file.
+    /** If not empty, the wisdom is loaded at startup and saved at the end of the SCF loop. The name of the file
+     *  is extended by the FFT grid dimensions and the number of threads. */
+    std::string fftw_wisdom_file_{""};
+
+    /// Directory of the scratch file for the out-of-core storage of wave-functions.
+    /** If not empty, the spinor wave-functions of the k-points which are not being processed are paged out to a
+     *  scratch file in this directory (should be a fast local disk). The next k-point is read back while the
+     *  current one is processed. */
+    std::string wf_scratch_path_{""};
+
     /// Maximum allowed muffin-tin radius in case of LAPW.
     double rmt_max_{2.2};
 
@@ -393,6 +459,16 @@ struct Control_input
             gen_evp_solver_name_ = section.value("gen_evp_solver_type", gen_evp_solver_name_);
             processing_unit_     = section.value("processing_unit", processing_unit_);
             fft_mode_            = section.value("fft_mode", fft_mode_);
+            fft_batch_size_      = section.value("fft_batch_size", fft_batch_size_);
+            fft_pipeline_chunk_size_ = section.value("fft_pipeline_chunk_size", fft_pipeline_chunk_size_);
+            fft_grid_tolerance_  = section.value("fft_grid_tolerance", fft_grid_tolerance_);
+            fft_pencil_ranks_    = section.value("fft_pencil_ranks", fft_pencil_ranks_);
+            fp32_rms_threshold_  = section.value("fp32_rms_threshold", fp32_rms_threshold_);
+            beta_cache_memory_mb_ = section.value("beta_cache_memory_mb", beta_cache_memory_mb_);
+            beta_real_space_     = section.value("beta_real_space", beta_real_space_);
+            fftw_plan_mode_      = section.value("fftw_plan_mode", fftw_plan_mode_);
+            fftw_wisdom_file_    = section.value("fftw_wisdom_file", fftw_wisdom_file_);
+            wf_scratch_path_     = section.value("wf_scratch_path", wf_scratch_path_);
             reduce_gvec_         = section.value("reduce_gvec", reduce_gvec_);
             rmt_max_             = section.value("rmt_max", rmt_max_);
             spglib_tolerance_    = section.value("spglib_tolerance", spglib_tolerance_);
@@ -408,7 +484,8 @@ struct Control_input
             print_timers_        = section.value("print_timers", print_timers_);
             print_neighbors_     = section.value("print_neighbors", print_neighbors_);
 
-            auto strings = {&std_evp_solver_name_, &gen_evp_solver_name_, &fft_mode_, &processing_unit_};
+            auto strings = {&std_evp_solver_name_, &gen_evp_solver_name_, &fft_mode_, &processing_unit_,
+                            &fftw_plan_mode_};
             for (auto s : strings) {
                 std::transform(s->begin(), s->end(), s->begin(), ::tolower);
             }
@@ -155,6 +155,20 @@ class Simulation_context: public Simulation_parameters
 
         bool initialized_{false};
 
+        /// True if the local part of the Hamiltonian is applied in single precision.
+        bool local_op_fp32_{false};
+
+        /// Name of the FFTW wisdom file for given FFT grids and the current number of threads.
+        inline std::string fftw_wisdom_file_name(FFT3D_grid const& fft_grid__, FFT3D_grid const& fft_coarse_grid__) const
+        {
+            std::stringstream s;
+            s << control().fftw_wisdom_file_ << "."
+              << fft_grid__.size(0) << "x" << fft_grid__.size(1) << "x" << fft_grid__.size(2) << "."
+              << fft_coarse_grid__.size(0) << "x" << fft_coarse_grid__.size(1) << "x" << fft_coarse_grid__.size(2) << "."
+              << "nt" << omp_get_max_threads();
+            return s.str();
+        }
+
         /// Initialize FFT drivers.
         inline void init_fft()
         {
@@ -166,11 +180,30 @@ class Simulation_context: public Simulation_parameters
                 TERMINATE("wrong FFT mode");
             }
 
+            std::array<int, 3> fft_dims        = find_translations(pw_cutoff(), rlv);
+            std::array<int, 3> fft_coarse_dims = find_translations(2 * gk_cutoff(), rlv);
+
+            /* benchmark grid sizes slightly larger than the minimal ones and take the fastest */
+            if (control().fft_grid_tolerance_ > 0) {
+                fft_dims = find_fast_fft_grid(fft_dims, control().fft_grid_tolerance_, comm_fft().size(), comm());
+                fft_coarse_dims = find_fast_fft_grid(fft_coarse_dims, control().fft_grid_tolerance_,
+                                                     comm_fft_coarse().size(), comm());
+            }
+
+            auto plan_flags = fftw_plan_flags(control().fftw_plan_mode_);
+
+            /* load FFTW wisdom before any plan is created */
+            if (!control().fftw_wisdom_file_.empty()) {
+                import_fftw_wisdom(fftw_wisdom_file_name(FFT3D_grid(fft_dims), FFT3D_grid(fft_coarse_dims)), comm());
+            }
+
             /* create FFT driver for dense mesh (density and potential) */
-            fft_ = std::unique_ptr<FFT3D>(new FFT3D(find_translations(pw_cutoff(), rlv), comm_fft(), processing_unit()));
+            fft_ = std::unique_ptr<FFT3D>(new FFT3D(fft_dims, comm_fft(), processing_unit(), plan_flags));
 
             /* create FFT driver for coarse mesh */
-            fft_coarse_ = std::unique_ptr<FFT3D>(new FFT3D(find_translations(2 * gk_cutoff(), rlv), comm_fft_coarse(), processing_unit()));
+            fft_coarse_ = std::unique_ptr<FFT3D>(new FFT3D(fft_coarse_dims, comm_fft_coarse(), processing_unit(),
+                                                           plan_flags, control().fft_pencil_ranks_));
+            fft_coarse_->set_pipeline_chunk_size(control().fft_pipeline_chunk_size_);
 
             /* create a list of G-vectors for corase FFT grid */
             gvec_coarse_ = std::unique_ptr<Gvec>(new Gvec(rlv, gk_cutoff() * 2, comm(), control().reduce_gvec_));
@@ -428,6 +461,16 @@ class Simulation_context: public Simulation_parameters
         /// Initialize the similation (can only be called once).
         void initialize();
 
+        /// Save the FFTW wisdom accumulated so far.
+        /** This is a collective operation over the global communicator; it must be called explicitly while MPI is
+         *  still running (it is not done in the destructor). */
+        inline void save_fftw_wisdom() const
+        {
+            if (initialized_ && !control().fftw_wisdom_file_.empty()) {
+                export_fftw_wisdom(fftw_wisdom_file_name(*fft_, *fft_coarse_), comm());
+            }
+        }
+
         /// Update context after setting new lattice vectors or atomic coordinates.
         void update()
         {
@@ -551,6 +594,25 @@ class Simulation_context: public Simulation_parameters
             return *fft_coarse_;
         }
 
+        /// True if the local part of the Hamiltonian is applied in single precision.
+        inline bool local_op_fp32() const
+        {
+            return local_op_fp32_;
+        }
+
+        /// Update the precision of the local operator for a given RMS of the density.
+        /** The switch from single to double precision is made once and for all when the RMS drops below
+         *  the threshold. */
+        inline void update_local_op_precision(double rms__)
+        {
+            if (local_op_fp32_ && rms__ < control().fp32_rms_threshold_) {
+                local_op_fp32_ = false;
+                if (comm_.rank() == 0 && control().verbosity_ >= 1) {
+                    printf("switching local operator to double precision\n");
+                }
+            }
+        }
+
         Gvec const& gvec() const
         {
             return *gvec_;
@@ -710,6 +772,12 @@ class Simulation_context: public Simulation_parameters
                    phase_factors_(2, G__[2], ia__);
         }
 
+        /// Phase factors \f$ e^{i G_x x_{\alpha}} \f$, \f$ e^{i G_y y_{\alpha}} \f$ and \f$ e^{i G_z z_{\alpha}} \f$.
+        inline mdarray<double_complex, 3> const& phase_factors() const
+        {
+            return phase_factors_;
+        }
+
         /// Phase factors \f$ e^{i {\bf G} {\bf r}_{\alpha}} \f$
         inline double_complex gvec_phase_factor(int ig__, int ia__) const
         {
@@ -1091,6 +1159,11 @@ inline void Simulation_context::initialize()
         }
     }
 
+    /* PPCG updates the wave-functions band by band on the host */
+    if (iterative_solver_input_.type_ == "ppcg" && processing_unit() == GPU) {
+        TERMINATE("PPCG iterative solver is not implemented for GPU, use \"davidson\" or \"lobpcg\" instead");
+    }
+
     /* initialize variables, related to the unit cell */
     unit_cell_.initialize();
 
@@ -1117,6 +1190,35 @@ inline void Simulation_context::initialize()
     /* initialize FFT interface */
     init_fft();
 
+    /* early SCF iterations of the pseudopotential method can be done with the single-precision local operator */
+    local_op_fp32_ = !full_potential() && control().fp32_rms_threshold_ > 0 && fft_coarse().fp32_transform_available();
+
+    /* real-space beta-projectors are implemented for the Hamiltonian, density matrix and forces of the collinear
+       case on the CPU; in all other cases the plane-wave beta-projectors are used */
+    if (control_input_.beta_real_space_ && !full_potential()) {
+        std::string reason;
+        if (num_mag_dims() == 3) {
+            reason = "non-collinear magnetism";
+        } else if (processing_unit() == GPU) {
+            reason = "GPU";
+        } else if (fft_coarse().num_ranks_y() > 1) {
+            reason = "pencil decomposition of the coarse FFT grid";
+        } else if (hubbard_correction()) {
+            reason = "Hubbard correction";
+        } else if (control().print_stress_) {
+            reason = "stress tensor";
+        }
+        if (reason.size()) {
+            control_input_.beta_real_space_ = false;
+            if (comm_.rank() == 0) {
+                std::stringstream s;
+                s << "real-space beta-projectors are not implemented for " << reason << std::endl
+                  << "  plane-wave beta-projectors are used instead";
+                WARNING(s);
+            }
+        }
+    }
+
     int nbnd = static_cast<int>(unit_cell_.num_valence_electrons() / 2.0) +
                                 std::max(10, static_cast<int>(0.1 * unit_cell_.num_valence_electrons()));
     if (full_potential()) {
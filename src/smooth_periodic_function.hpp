@@ -159,16 +159,28 @@ class Smooth_periodic_function
 
             assert(gvecp_ != nullptr);
 
+            /* real function with the reduced set of G-vectors is transformed with c2r / r2c FFT
+             * directly to / from the real-space array */
+            bool real_fft = std::is_same<T, double>::value && fft_->real_transform_available();
+
             switch (direction__) {
                 case 1: {
                     gather_f_pw_fft();
-                    fft_->transform<1>(f_pw_fft_.at<CPU>());
-                    fft_->output(f_rg_.template at<CPU>());
+                    if (real_fft) {
+                        fft_->transform_real<1>(f_pw_fft_.at<CPU>(), reinterpret_cast<double*>(f_rg_.template at<CPU>()));
+                    } else {
+                        fft_->transform<1>(f_pw_fft_.at<CPU>());
+                        fft_->output(f_rg_.template at<CPU>());
+                    }
                     break;
                 }
                 case -1: {
-                    fft_->input(f_rg_.template at<CPU>());
-                    fft_->transform<-1>(f_pw_fft_.at<CPU>());
+                    if (real_fft) {
+                        fft_->transform_real<-1>(f_pw_fft_.at<CPU>(), reinterpret_cast<double*>(f_rg_.template at<CPU>()));
+                    } else {
+                        fft_->input(f_rg_.template at<CPU>());
+                        fft_->transform<-1>(f_pw_fft_.at<CPU>());
+                    }
                     int count  = gvecp_->gvec_fft_slab().counts[gvecp_->comm_ortho_fft().rank()];
                     int offset = gvecp_->gvec_fft_slab().offsets[gvecp_->comm_ortho_fft().rank()];
                     std::memcpy(f_pw_local_.at<CPU>(), f_pw_fft_.at<CPU>(offset), count * sizeof(double_complex));
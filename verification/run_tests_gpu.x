@@ -1,7 +1,10 @@
 #!/bin/bash
 
+# PPCG solver (test15) is not available on GPU
+skip="./test15"
+
 for f in ./*; do
-  if [ -d "$f" ]; then
+  if [ -d "$f" ] && [[ " ${skip} " != *" ${f} "* ]]; then
     echo "running '${f}'"
     cd ${f}
     ../../apps/dft_loop/sirius.scf --test_against=output_ref.json --processing_unit=gpu
@@ -1,7 +1,10 @@
 #!/bin/bash
 
+# PPCG solver (test15) is not available on GPU
+skip="./test15"
+
 for f in ./*; do
-  if [ -d "$f" ]; then
+  if [ -d "$f" ] && [[ " ${skip} " != *" ${f} "* ]]; then
     echo "running '${f}'"
     cd ${f}
     mpirun -np 4 ../../apps/dft_loop/sirius.scf --test_against=output_ref.json --std_evp_solver_name=scalapack --gen_evp_solver_name=scalapack --processing_unit=gpu --mpi_grid="2 2"